@@ -495,6 +495,64 @@ namespace graphene { namespace app {
        }
     }
 
+    /**
+     * @return the sequence number of the first history entry of @p account whose operation id is above @p id, or
+     * at least @p id if @p inclusive, std::numeric_limits<uint32_t>::max() if there is none
+     */
+    inline uint32_t sequence_above(const database& db, account_id_type account, operation_history_id_type id, bool inclusive = false)
+    {
+       const auto& by_op_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_op>();
+       auto itr = inclusive ? by_op_idx.lower_bound(boost::make_tuple(account, id))
+                            : by_op_idx.upper_bound(boost::make_tuple(account, id));
+       if ((itr == by_op_idx.end()) || (itr->account != account)) {
+          return std::numeric_limits<uint32_t>::max();
+       }
+       return itr->sequence;
+    }
+
+    /**
+     * Calls @p visit with the history entries of @p account for one of @p operation_types with a sequence number in
+     * [@p first, @p last), the most recent one first if @p newest_first, until it returns false.
+     * Each operation type is a range of the by_op_type index, the ranges are merged by sequence number.
+     */
+    template<typename Visitor>
+    void visit_account_operations(const database& db, account_id_type account, const flat_set<uint16_t>& operation_types,
+                                  uint32_t first, uint32_t last, bool newest_first, Visitor&& visit)
+    {
+       const auto& idx = db.get_index_type<account_transaction_history_index>().indices().get<by_op_type>();
+       using iterator = decltype(idx.begin());
+       vector<std::pair<iterator, iterator>> ranges;
+       ranges.reserve(operation_types.size());
+       for (uint16_t op_type: operation_types)
+       {
+          auto begin = idx.lower_bound(boost::make_tuple(account, op_type, first));
+          auto end = idx.lower_bound(boost::make_tuple(account, op_type, last));
+          if (begin != end) {
+             ranges.emplace_back(begin, end);
+          }
+       }
+
+       while (!ranges.empty())
+       {
+          size_t next = 0;
+          for (size_t i = 1; i < ranges.size(); ++i)
+          {
+             if (newest_first ? (std::prev(ranges[i].second)->sequence > std::prev(ranges[next].second)->sequence)
+                              : (ranges[i].first->sequence < ranges[next].first->sequence)) {
+                next = i;
+             }
+          }
+          auto& range = ranges[next];
+          const account_transaction_history_object& node = newest_first ? *--range.second : *range.first++;
+          if (range.first == range.second) {
+             ranges.erase(ranges.begin() + next);
+          }
+          if (!visit(node)) {
+             return;
+          }
+       }
+    }
+
     vector<operation_history_object> history_api::get_accounts_history(unsigned limit) const
     {
        FC_ASSERT( _app.chain_database() );
@@ -574,47 +632,25 @@ namespace graphene { namespace app {
       const auto& db = *_app.chain_database();       
       FC_ASSERT(count <= 100);
       vector<listtransactions_result> result;
-      const auto& stats = account(db).statistics(db);
-      if (stats.most_recent_op == account_transaction_history_id_type()) { return result; }
-      if (!db.find(stats.most_recent_op)) {
-         return result;
-      }
-      const account_transaction_history_object* node = &stats.most_recent_op(db);
       const uint32_t current_block = db.head_block_num();
-      while ((node != nullptr) && (result.size() < (uint32_t)count))
+      const flat_set<uint16_t> transfers{ operation::tag<transfer_operation>::value };
+
+      visit_account_operations(db, account, transfers, 0, std::numeric_limits<uint32_t>::max(), true,
+         [&](const account_transaction_history_object& node) -> bool
       {
-         auto op_hist = node->operation_id(db);
-         if (op_hist.op.which() == operation::tag<transfer_operation>::value)
-         {
-            auto ext = op_hist.op.get<transfer_operation>().extensions;
-            auto tr_address = ext.begin() != ext.end() ? ext.begin()->get<string>(): "";
-            if (addresses.size() && std::find(addresses.begin(), addresses.end(), tr_address) == addresses.end())
-            {
-               node = &node->next(db);
-               continue;
-            }
-            try
-            {
-               result.push_back(listtransactions_result{op_hist.op.get<transfer_operation>(),
-                                                        (int)(current_block - op_hist.block_num)});
-            } catch (const fc::exception& e)
-            { break; }
+         if (result.size() >= (uint32_t)count) { return false; }
+         const operation_history_object* op_hist = db.find(node.operation_id);
+         if (op_hist == nullptr) { return false; }
+
+         const transfer_operation& tr_op = op_hist->op.get<transfer_operation>();
+         auto tr_address = tr_op.extensions.begin() != tr_op.extensions.end() ? tr_op.extensions.begin()->get<string>(): "";
+         if (addresses.size() && std::find(addresses.begin(), addresses.end(), tr_address) == addresses.end()) {
+            return true;
          }
-         if (node->next == account_transaction_history_id_type()) {
-            node = nullptr;
-         }
-         else
-         {
-            auto f_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_id>().find(node->next);
-            if (f_idx == db.get_index_type<account_transaction_history_index>().indices().get<by_id>().end()) {
-               node = nullptr;
-            }
-            else {
-               node = &(*f_idx);
-            }
-         }
-      }
-       
+         result.push_back(listtransactions_result{tr_op, (int)(current_block - op_hist->block_num)});
+         return true;
+      });
+
       return result;
    }
 
@@ -659,41 +695,20 @@ namespace graphene { namespace app {
       FC_ASSERT( limit <= 100 );
 
       vector<operation_history_object> result;
-      const auto& stats = account(db).statistics(db);
-      if( stats.most_recent_op == account_transaction_history_id_type() ) { return result; }
+      if (operation_type > std::numeric_limits<uint16_t>::max()) { return result; }
+      const flat_set<uint16_t> operation_types{ uint16_t(operation_type) };
 
-      if (!db.find(stats.most_recent_op)) {
-         return result;
-      }
-      const account_transaction_history_object* node = &stats.most_recent_op(db);
-
-      while (node && result.size() < limit)
+      visit_account_operations(db, account, operation_types, 0, std::numeric_limits<uint32_t>::max(), true,
+         [&](const account_transaction_history_object& node) -> bool
       {
-        try
-        {
-          const operation_history_object& hist = node->operation_id(db);
-          if ((unsigned)hist.op.which() == operation_type)
-          {
-             operation_history_object op_h = hist;
-             reserve_op(op_h);
-             result.push_back(std::move(op_h));
-          }
-        }
-        catch(const fc::exception& e) { break; }
-        if ( node->next == account_transaction_history_id_type() ) {
-           node = nullptr;
-        }
-        else
-        {
-           auto f_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_id>().find(node->next);
-           if (f_idx == db.get_index_type<account_transaction_history_index>().indices().get<by_id>().end()) {
-              node = nullptr;
-           }
-           else {
-              node = &(*f_idx);
-           }
-        }
-      }
+         if (result.size() >= limit) { return false; }
+         const operation_history_object* hist = db.find(node.operation_id);
+         if (hist == nullptr) { return false; }
+         operation_history_object op_h = *hist;
+         reserve_op(op_h);
+         result.push_back(std::move(op_h));
+         return true;
+      });
       
       return result;
     }
@@ -709,49 +724,22 @@ namespace graphene { namespace app {
       const auto& db = *_app.chain_database();       
       FC_ASSERT( limit <= 100 );
       vector<operation_history_object> result;
-      const auto& stats = account(db).statistics(db);
-
-      if (stats.most_recent_op == account_transaction_history_id_type()) { return result; }
-
-      if (!db.find(stats.most_recent_op)) {
-         return result;
-      }
-      const account_transaction_history_object* node = &stats.most_recent_op(db);
+      if (operation_type > std::numeric_limits<uint16_t>::max()) { return result; }
+      const flat_set<uint16_t> operation_types{ uint16_t(operation_type) };
 
-      if (start == operation_history_id_type()) {
-         start = node->operation_id;
-      }
-
-      while (node && (node->operation_id.instance.value > stop.instance.value) && (result.size() < limit))
+      const uint32_t last = (start == operation_history_id_type()) ? std::numeric_limits<uint32_t>::max()
+                                                                   : sequence_above(db, account, start);
+      visit_account_operations(db, account, operation_types, sequence_above(db, account, stop), last, true,
+         [&](const account_transaction_history_object& node) -> bool
       {
-        try
-        {
-          auto& hist = node->operation_id(db);
-          if (node->operation_id.instance.value <= start.instance.value)
-          {
-             if ((unsigned)hist.op.which() == operation_type)
-             {
-                operation_history_object op_h = hist;
-                reserve_op(op_h);
-                result.push_back(std::move(op_h));
-             }
-          }
-        }
-        catch(const fc::exception& e) { break; }
-        if (node->next == account_transaction_history_id_type()) {
-           node = nullptr;
-        }
-        else
-        {
-           auto f_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_id>().find(node->next);
-           if (f_idx == db.get_index_type<account_transaction_history_index>().indices().get<by_id>().end()) {
-              node = nullptr;
-           }
-           else {
-              node = &(*f_idx);
-           }
-        }
-      }
+         if (result.size() >= limit) { return false; }
+         const operation_history_object* hist = db.find(node.operation_id);
+         if (hist == nullptr) { return false; }
+         operation_history_object op_h = *hist;
+         reserve_op(op_h);
+         result.push_back(std::move(op_h));
+         return true;
+      });
 
       return result;
    }
@@ -767,61 +755,27 @@ namespace graphene { namespace app {
       const auto& db = *_app.chain_database();
       FC_ASSERT( limit <= 100 );
       vector<operation_history_object> result;
-      const auto& stats = account_id(db).statistics(db);
-
-      if (stats.most_recent_op == account_transaction_history_id_type()) { return result; }
-
-      if (!db.find(stats.most_recent_op)) {
-         return result;
-      }
-      const account_transaction_history_object* node = &stats.most_recent_op(db);
-
-      if (start == operation_history_id_type()) {
-         start = node->operation_id;
-      }
 
-      while (node && (node->operation_id.instance.value > stop.instance.value) && (result.size() < limit))
+      const uint32_t last = (start == operation_history_id_type()) ? std::numeric_limits<uint32_t>::max()
+                                                                   : sequence_above(db, account_id, start);
+      visit_account_operations(db, account_id, flat_set<uint16_t>(operation_types.begin(), operation_types.end()),
+                               sequence_above(db, account_id, stop), last, true,
+         [&](const account_transaction_history_object& node) -> bool
       {
-         try
-         {
-            operation_history_object hist = node->operation_id(db);
-            reserve_op(hist);
-
-            if (node->operation_id.instance.value <= start.instance.value)
-            {
-               std::for_each(operation_types.begin(), operation_types.end(), [&account_id, &hist, &result](const uint16_t& op_type)
-               {
-                  if ((unsigned)hist.op.which() == op_type)
-                  {
-                     // fund_payment_operation
-                     if (hist.op.which() == operation::tag<fund_payment_operation>::value)
-                     {
-                        if (hist.op.get<fund_payment_operation>().issue_to_account == account_id) {
-                           result.push_back(std::move(hist));
-                        }
-                     }
-                     else {
-                        result.push_back(std::move(hist));
-                     }
-                  }
-               });
-            }
+         if (result.size() >= limit) { return false; }
+         const operation_history_object* hist = db.find(node.operation_id);
+         if (hist == nullptr) { return false; }
+
+         // fund_payment_operation
+         if ((hist->op.which() == operation::tag<fund_payment_operation>::value)
+             && (hist->op.get<fund_payment_operation>().issue_to_account != account_id)) {
+            return true;
          }
-         catch(const fc::exception& e) { break; }
-         if (node->next == account_transaction_history_id_type()) {
-            node = nullptr;
-         }
-         else
-         {
-            auto f_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_id>().find(node->next);
-            if (f_idx == db.get_index_type<account_transaction_history_index>().indices().get<by_id>().end()) {
-               node = nullptr;
-            }
-            else {
-               node = &(*f_idx);
-            }
-         }
-      }
+         operation_history_object op_h = *hist;
+         reserve_op(op_h);
+         result.push_back(std::move(op_h));
+         return true;
+      });
 
       return result;
    }
@@ -838,58 +792,40 @@ namespace graphene { namespace app {
       vector<operation_history_object> result;
       result.reserve(limit);
 
-      const auto& idx = db.get_index_type<operation_history_index>().indices().get<by_id>();
-      auto itr = idx.begin();
-
-      auto is_valid_operation = [&operation_types, &account](const operation_history_object& op) -> bool
+      auto is_valid_operation = [&account](const operation_history_object& op) -> bool
       {
-         for (const uint16_t& op_type: operation_types)
+         // transfer operation
+         if (op.op.which() == operation::tag<transfer_operation>::value)
          {
-            if ((unsigned)op.op.which() == op_type)
-            {
-               // transfer operation
-               if (op.op.which() == operation::tag<transfer_operation>::value)
-               {
-                  const transfer_operation& tr_op = op.op.get<transfer_operation>();
-                  if ((tr_op.from == account) || (tr_op.to == account)) {
-                     return true;
-                  }
-               }
-               // ...
+            const transfer_operation& tr_op = op.op.get<transfer_operation>();
+            if ((tr_op.from == account) || (tr_op.to == account)) {
+               return true;
             }
          }
+         // ...
          return false;
       };
 
-      if (start == operation_history_id_type())
+      uint32_t first = 0;
+      if (start != operation_history_id_type())
       {
-         while (itr != idx.end())
-         {
-            // find first valid operation
-            if (is_valid_operation(*itr)) {
-               break;
-            }
-            ++itr;
-         }
-      }
-      else
-      {
-         itr = idx.find(start);
-         if (itr == idx.end()) { return result; }
+         if (db.find(start) == nullptr) { return result; }
+         first = sequence_above(db, account, start, true);
       }
 
-      while (itr != idx.end())
+      // the history is walked from the oldest operation on
+      visit_account_operations(db, account, flat_set<uint16_t>(operation_types.begin(), operation_types.end()),
+                               first, std::numeric_limits<uint32_t>::max(), false,
+         [&](const account_transaction_history_object& node) -> bool
       {
-         if (result.size() == limit) { break;}
-
-         const operation_history_object& op = *itr;
-
-         if (is_valid_operation(op)) {
-            result.emplace_back(op);
+         if (result.size() >= limit) { return false; }
+         const operation_history_object* op = db.find(node.operation_id);
+         if (op == nullptr) { return true; }
+         if (is_valid_operation(*op)) {
+            result.emplace_back(*op);
          }
-
-         ++itr;
-      }
+         return true;
+      });
 
       return result;
    }
@@ -904,101 +840,56 @@ namespace graphene { namespace app {
       const auto& db = *_app.chain_database();
       FC_ASSERT( limit <= 100 );
       vector<operation_history_object> result;
-      const auto& stats = account_id(db).statistics(db);
-
-      if (stats.most_recent_op == account_transaction_history_id_type()) { return result; }
-
-      if (!db.find(stats.most_recent_op)) {
-         return result;
-      }
-      const account_transaction_history_object* node = &stats.most_recent_op(db);
 
-      if (start == operation_history_id_type()) {
-         start = node->operation_id;
-      }
+      const flat_set<uint16_t> operation_types{ operation::tag<fund_update_operation>::value,
+                                                operation::tag<fund_deposit_operation>::value,
+                                                operation::tag<fund_withdrawal_operation>::value,
+                                                operation::tag<fund_payment_operation>::value };
+      const uint32_t last = (start == operation_history_id_type()) ? std::numeric_limits<uint32_t>::max()
+                                                                   : sequence_above(db, account_id, start);
 
-      auto set_fund_validation = [&](const fund_id_type& fund_id, bool& status)
-      {
-         auto&& itr = std::find_if(funds.begin(), funds.end(), [&fund_id](const fund_id_type& item){
-            return (item == fund_id);
-         });
-         if (itr != funds.end()) {
-            status = true;
-         }
+      auto fund_is_valid = [&funds](const fund_id_type& fund_id) -> bool {
+         return std::find(funds.begin(), funds.end(), fund_id) != funds.end();
       };
 
-      while (node && (result.size() < limit))
+      visit_account_operations(db, account_id, operation_types, 0, last, true,
+         [&](const account_transaction_history_object& node) -> bool
       {
-         try
-         {
-            operation_history_object hist = node->operation_id(db);
-            reserve_op(hist);
-
-            if (node->operation_id.instance.value <= start.instance.value)
-            {
-               const auto& op = hist.op.which();
+         if (result.size() >= limit) { return false; }
+         const operation_history_object* hist_ptr = db.find(node.operation_id);
+         if (hist_ptr == nullptr) { return false; }
+         operation_history_object hist = *hist_ptr;
+         reserve_op(hist);
 
-               bool fund_is_valid = false;
-               bool account_is_valid = false;
+         const auto& op = hist.op.which();
+         bool account_is_valid = false;
 
-               if (op == operation::tag<fund_update_operation>::value)
-               {
-                  const fund_update_operation& inner_op = hist.op.get<fund_update_operation>();
-
-                  set_fund_validation(inner_op.id, fund_is_valid);
-                  if (fund_is_valid && (inner_op.from_account == account_id)) {
-                     account_is_valid = true;
-                  }
-               }
-               else if (op == operation::tag<fund_deposit_operation>::value)
-               {
-                  const fund_deposit_operation& inner_op = hist.op.get<fund_deposit_operation>();
-
-                  set_fund_validation(inner_op.fund_id, fund_is_valid);
-                  if (fund_is_valid && (inner_op.from_account == account_id)) {
-                     account_is_valid = true;
-                  }
-               }
-               else if (op == operation::tag<fund_withdrawal_operation>::value)
-               {
-                  const fund_withdrawal_operation& inner_op = hist.op.get<fund_withdrawal_operation>();
-
-                  set_fund_validation(inner_op.fund_id, fund_is_valid);
-                  if (fund_is_valid && (inner_op.issue_to_account == account_id)) {
-                     account_is_valid = true;
-                  }
-               }
-               else if (op == operation::tag<fund_payment_operation>::value)
-               {
-                  const fund_payment_operation& inner_op = hist.op.get<fund_payment_operation>();
-
-                  set_fund_validation(inner_op.fund_id, fund_is_valid);
-                  if (fund_is_valid && (inner_op.issue_to_account == account_id)) {
-                     account_is_valid = true;
-                  }
-               }
-
-               if (account_is_valid && fund_is_valid) {
-                  result.push_back(std::move(hist));
-               }
-            }
+         if (op == operation::tag<fund_update_operation>::value)
+         {
+            const fund_update_operation& inner_op = hist.op.get<fund_update_operation>();
+            account_is_valid = fund_is_valid(inner_op.id) && (inner_op.from_account == account_id);
          }
-         catch(const fc::exception& e) { break; }
-
-         if (node->next == account_transaction_history_id_type()) {
-            node = nullptr;
+         else if (op == operation::tag<fund_deposit_operation>::value)
+         {
+            const fund_deposit_operation& inner_op = hist.op.get<fund_deposit_operation>();
+            account_is_valid = fund_is_valid(inner_op.fund_id) && (inner_op.from_account == account_id);
          }
-         else
+         else if (op == operation::tag<fund_withdrawal_operation>::value)
          {
-            auto f_idx = db.get_index_type<account_transaction_history_index>().indices().get<by_id>().find(node->next);
-            if (f_idx == db.get_index_type<account_transaction_history_index>().indices().get<by_id>().end()) {
-               node = nullptr;
-            }
-            else {
-               node = &(*f_idx);
-            }
+            const fund_withdrawal_operation& inner_op = hist.op.get<fund_withdrawal_operation>();
+            account_is_valid = fund_is_valid(inner_op.fund_id) && (inner_op.issue_to_account == account_id);
          }
-      }
+         else if (op == operation::tag<fund_payment_operation>::value)
+         {
+            const fund_payment_operation& inner_op = hist.op.get<fund_payment_operation>();
+            account_is_valid = fund_is_valid(inner_op.fund_id) && (inner_op.issue_to_account == account_id);
+         }
+
+         if (account_is_valid) {
+            result.push_back(std::move(hist));
+         }
+         return true;
+      });
 
       return result;
    }
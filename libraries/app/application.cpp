@@ -17,6 +17,7 @@
 #include <fc/rpc/api_connection.hpp>
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/network/resolve.hpp>
+#include <fc/thread/thread.hpp>
 
 #include <fc/filesystem.hpp>
 #include <boost/filesystem/path.hpp>
@@ -24,6 +25,7 @@
 #include <boost/range/algorithm/reverse.hpp>
 
 #include <iostream>
+#include <shared_mutex>
 #include <sstream>
 #include <tuple>
 
@@ -168,6 +170,7 @@ namespace graphene { namespace app { namespace detail {
          auto db_api = std::make_shared<graphene::app::database_api>(*_self.chain_database());
          wsc->register_api(fc::api<graphene::app::database_api>(db_api));
          wsc->register_api(fc::api<graphene::app::login_api>(login));
+         set_api_dispatcher( *wsc );
          c->set_session_data( wsc );
       });
       ilog("Configured websocket rpc to listen on ${ip}", ("ip",_options->at("rpc-endpoint").as<string>()));
@@ -196,6 +199,7 @@ namespace graphene { namespace app { namespace detail {
          auto db_api = std::make_shared<graphene::app::database_api>(*_self.chain_database());
          wsc->register_api(fc::api<graphene::app::database_api>(db_api));
          wsc->register_api(fc::api<graphene::app::login_api>(login));
+         set_api_dispatcher( *wsc );
          c->set_session_data( wsc );
       });
       ilog("Configured websocket TLS rpc to listen on ${ip}", ("ip",_options->at("rpc-tls-endpoint").as<string>()));
@@ -203,6 +207,64 @@ namespace graphene { namespace app { namespace detail {
       _websocket_tls_server->start_accept();
    } FC_CAPTURE_AND_RETHROW() }
 
+   void application_impl::set_api_dispatcher( fc::rpc::websocket_api_connection& wsc )
+   {
+      if( _api_readers.empty() )
+         return;
+      auto subscribed = std::make_shared<bool>( false );
+      wsc.set_call_dispatcher( [this, subscribed]( const fc::generic_api& api, const string& method_name,
+                                                   const std::function<fc::variant()>& call ) {
+         return dispatch_api_call( api, method_name, call, *subscribed );
+      });
+   }
+
+   /**
+    * The history and secure api methods listed below only read the chain state, and so do the database api methods
+    * other than the ones changing the subscriptions, as long as the connection has not subscribed: the getters then
+    * subscribe to what they return. These calls run on a reader thread holding the state gate shared, so they do not
+    * hold up blocks on this thread. Calls changing the subscriptions hold the gate exclusively, so that no reader of
+    * the connection runs meanwhile. Any other call runs here as before, methods added to the history and secure apis
+    * are only moved to the readers once they are listed. The debug api changes the state through the database, which
+    * holds the gate itself.
+    */
+   fc::variant application_impl::dispatch_api_call( const fc::generic_api& api, const string& method_name,
+                                                    const std::function<fc::variant()>& call, bool& subscribed )
+   {
+      static const std::set<string> subscription_methods = {
+         "set_subscribe_callback", "set_pending_transaction_callback", "set_block_applied_callback",
+         "cancel_all_subscriptions", "subscribe_to_market", "unsubscribe_from_market" };
+
+      static const std::set<string> history_readers = {
+         "get_accounts_history", "get_account_history", "listtransactions", "get_account_operation_history",
+         "get_account_operation_history2", "get_account_operation_history3", "get_account_operation_history4",
+         "get_account_leasing_history", "get_fund_history", "get_fund_payments_history", "get_relative_history",
+         "get_fill_order_history", "get_market_history", "get_market_history_buckets" };
+      static const std::set<string> secure_readers = {
+         "get_objects", "get_account_blind_transfers2", "get_account_cheques" };
+
+      bool read_only = ( api.as<fc::api<history_api>>() && history_readers.count( method_name ) )
+                       || ( api.as<fc::api<secure_api>>() && secure_readers.count( method_name ) );
+      if( api.as<fc::api<database_api>>() )
+      {
+         if( subscription_methods.count( method_name ) )
+         {
+            subscribed = true;
+            std::lock_guard<graphene::chain::read_write_gate> gate( _chain_db->state_gate() );
+            return call();
+         }
+         read_only = !subscribed && method_name != "validate_transaction";
+      }
+      if( !read_only )
+         return call();
+
+      auto chain_db = _chain_db;
+      fc::thread& reader = *_api_readers[ _next_api_reader++ % _api_readers.size() ];
+      return reader.async( [chain_db, &call]() {
+         std::shared_lock<graphene::chain::read_write_gate> gate( chain_db->state_gate() );
+         return call();
+      }, "read-only api call" ).wait();
+   }
+
    void application_impl::initialize(const fc::path& data_dir, shared_ptr<boost::program_options::variables_map> options)
    {
       _data_dir = data_dir;
@@ -211,6 +273,35 @@ namespace graphene { namespace app { namespace detail {
       if (options->count("history-days") > 0) {
          _chain_db->set_history_size(options->at("history-days").as<int>());
       }
+      if (options->count("maintenance-tally-threads") > 0) {
+         _chain_db->set_maintenance_tally_threads(options->at("maintenance-tally-threads").as<uint16_t>());
+      }
+      if (options->count("replay-threads") > 0) {
+         _chain_db->set_replay_threads(options->at("replay-threads").as<uint16_t>());
+      }
+      if (options->count("api-reader-threads") > 0) {
+         const uint16_t readers = options->at("api-reader-threads").as<uint16_t>();
+         for (uint16_t i = 0; i < readers; ++i)
+            _api_readers.push_back(std::make_shared<fc::thread>("api reader " + std::to_string(i)));
+      }
+      if (options->count("defer-pending-transactions") > 0) {
+         _chain_db->defer_pending_transactions(options->at("defer-pending-transactions").as<bool>());
+      }
+      if (options->count("snapshot-interval") > 0) {
+         _chain_db->set_snapshot_interval(options->at("snapshot-interval").as<uint32_t>());
+      }
+      if (options->count("snapshot-count") > 0) {
+         _chain_db->set_snapshot_count(options->at("snapshot-count").as<uint32_t>());
+      }
+      if (options->count("maintenance-profile-size") > 0) {
+         _chain_db->set_maintenance_profile_size(options->at("maintenance-profile-size").as<uint32_t>());
+      }
+      if (options->count("maintenance-profile-file") > 0) {
+         fc::path profile_file = options->at("maintenance-profile-file").as<boost::filesystem::path>();
+         if (profile_file.is_relative())
+            profile_file = data_dir / profile_file;
+         _chain_db->set_maintenance_profile_file(profile_file);
+      }
       if( options->count("create-genesis-json") > 0)
       {
          fc::path genesis_out = options->at("create-genesis-json").as<boost::filesystem::path>();
@@ -416,8 +507,8 @@ namespace graphene { namespace app { namespace detail {
       }
       else
       {
-         wlog("Detected unclean shutdown. Replaying blockchain...");
-         _chain_db->reindex(_data_dir / "blockchain", initialize_genesis_state());
+         wlog("Detected unclean shutdown. Replaying blockchain from the newest snapshot...");
+         _chain_db->reindex(_data_dir / "blockchain", initialize_genesis_state(), true);
       }
 
    } FC_LOG_AND_RETHROW() }
@@ -504,7 +595,17 @@ namespace graphene { namespace app { namespace detail {
          // you can help the network code out by throwing a block_older_than_undo_history exception.
          // when the net code sees that, it will stop trying to push blocks from that chain, but
          // leave that peer connected so that they can get sync blocks from us
-         bool result = _chain_db->push_block(blk_msg.block, (_is_block_producer | _force_validate) ? database::skip_nothing : database::skip_transaction_signatures);
+
+         // the blocks shortly below a checkpoint are applied like in a replay, in a run which the checkpoint confirms
+         if( sync_mode && _chain_db->push_checkpointed_block(blk_msg.block) )
+            return false;
+
+         const uint32_t skip = (_is_block_producer | _force_validate) ? database::skip_nothing : database::skip_transaction_signatures;
+         // the signature keys are recovered on the worker pool, this thread serves other tasks meanwhile
+         _chain_db->precompute_parallel(blk_msg.block, skip);
+         // with defer-pending-transactions, the node passes the block on to the peers before the pending
+         // transactions are applied again
+         bool result = _chain_db->push_block(blk_msg.block, skip);
 
          // the block was accepted, so we now know all of the transactions contained in the block
          if (!sync_mode)
@@ -551,6 +652,11 @@ namespace graphene { namespace app { namespace detail {
             trx_count = 0;
          }
 
+         // the database takes no transactions while syncing blocks below a checkpoint, these are not the peer's fault
+         if( _chain_db->in_checkpointed_batch() )
+            return;
+
+         _chain_db->precompute_parallel( transaction_message.trx );
          _chain_db->push_transaction( transaction_message.trx );
       } FC_CAPTURE_AND_RETHROW( (transaction_message) ) }
 
@@ -890,6 +996,9 @@ namespace graphene { namespace app { namespace detail {
       if( _websocket_server )
          _websocket_server.reset();
       // TODO wait until all connections are closed and messages handled?
+      for( auto& reader : _api_readers )
+         reader->quit();
+      _api_readers.clear();
 
       // plugins E.G. witness_plugin may send data to p2p network, so shutdown them first
       ilog( "Shutting down plugins" );
@@ -995,6 +1104,23 @@ namespace graphene { namespace app {
       ("io-threads", bpo::value<uint16_t>()->implicit_value(0), "Number of IO threads, default to 0 for auto-configuration")
       ("replay-blockchain", "Rebuild object graph by replaying all blocks")
       ("create-mt-file", "Creates text file with number of seconds of all processed maintenance times")
+      ("maintenance-tally-threads", bpo::value<uint16_t>()->default_value(0),
+       "Number of threads used to tally votes during chain maintenance, 0 or 1 to tally in a single thread")
+      ("replay-threads", bpo::value<uint16_t>()->default_value(1),
+       "Number of threads checking merkle roots and sizes of blocks ahead of a replay, besides the reading thread")
+      ("api-reader-threads", bpo::value<uint16_t>()->default_value(0),
+       "Number of threads running the read-only calls of the database, history and secure APIs between blocks, 0 to run all API calls on the main thread")
+      ("defer-pending-transactions", bpo::value<bool>()->default_value(false),
+       "Apply the pending transactions again after a block has been handed on, instead of before. "
+       "All of them are still applied again after every block, and until then the node serves the state of the head block")
+      ("snapshot-interval", bpo::value<uint32_t>()->default_value(50000),
+       "Number of irreversible blocks between snapshots of the object database, used to recover from an unclean shutdown without a full replay, 0 disables snapshots")
+      ("snapshot-count", bpo::value<uint32_t>()->default_value(2),
+       "Number of object database snapshots to keep")
+      ("maintenance-profile-size", bpo::value<uint32_t>()->default_value(32),
+       "Number of recent chain maintenances to keep per-phase timings for")
+      ("maintenance-profile-file", bpo::value<boost::filesystem::path>(),
+       "JSON file to write the per-phase maintenance timings to after every maintenance, relative to data-dir")
       ;
       command_line_options.add(configuration_file_options);
       command_line_options.add_options()
@@ -16,6 +16,12 @@ public:
 
    void reset_websocket_tls_server();
 
+   /**
+    * Runs the read-only calls of @p wsc to the database, history and secure apis on the api reader threads, see
+    * dispatch_api_call(). Does nothing if there are no reader threads.
+    */
+   void set_api_dispatcher( fc::rpc::websocket_api_connection& wsc );
+
    explicit application_impl(application& self)
       : _self(self),
         _chain_db(std::make_shared<chain::database>()) { }
@@ -175,6 +181,9 @@ public:
 private:
    void shutdown();
 
+   fc::variant dispatch_api_call( const fc::generic_api& api, const string& method_name,
+                                  const std::function<fc::variant()>& call, bool& subscribed );
+
    void initialize_plugins() const;
    void startup_plugins() const;
    void shutdown_plugins() const;
@@ -196,6 +205,9 @@ private:
    std::shared_ptr<graphene::net::node>             _p2p_network;
    std::shared_ptr<fc::http::websocket_server>      _websocket_server;
    std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
+   /// threads running the read-only api calls, they only read the chain state between blocks
+   std::vector<std::shared_ptr<fc::thread>>          _api_readers;
+   size_t                                            _next_api_reader = 0;
 
    std::map<string, std::shared_ptr<abstract_plugin>> _active_plugins;
    std::map<string, std::shared_ptr<abstract_plugin>> _available_plugins;
@@ -9,6 +9,7 @@
 
 #include <fc/bloom_filter.hpp>
 #include <fc/crypto/hex.hpp>
+#include <fc/rpc/api_connection.hpp>
 
 #include <boost/range/iterator_range.hpp>
 #include <boost/rational.hpp>
@@ -19,6 +20,7 @@
 #include <map>
 #include <future>
 #include <iostream>
+#include <limits>
 #include <utility>
 
 template class fc::api<graphene::app::database_api>;
@@ -39,6 +41,7 @@ database_api::~database_api() {}
 database_api_impl::database_api_impl( graphene::chain::database& db ):_db(db)
 {
    wlog("creating database api ${x}", ("x",int64_t(this)) );
+   _change_journal = object_change_journal::get(_db);
    _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids) {
                                 on_objects_changed(ids);
                                 });
@@ -241,6 +244,16 @@ optional<signed_block> database_api_impl::get_block(uint32_t block_num)
    return b;
 }
 
+vector<vector<char>> database_api::get_blocks(uint32_t first, uint32_t count) const {
+   return my->get_blocks( first, count );
+}
+
+vector<vector<char>> database_api_impl::get_blocks(uint32_t first, uint32_t count) const
+{
+   FC_ASSERT( count <= 100 );
+   return _db.fetch_packed_blocks(first, count);
+}
+
 optional<signed_block> database_api::get_block_reserved(uint32_t block_num) const {
    return my->get_block_reserved(block_num);
 }
@@ -690,6 +703,17 @@ dynamic_global_property_object database_api_impl::get_dynamic_global_properties(
    return _db.get(dynamic_global_property_id_type());
 }
 
+vector<maintenance_profile> database_api::get_maintenance_profiles()const
+{
+   return my->get_maintenance_profiles();
+}
+
+vector<maintenance_profile> database_api_impl::get_maintenance_profiles()const
+{
+   const auto& profiles = _db.get_maintenance_profiler().profiles();
+   return vector<maintenance_profile>(profiles.begin(), profiles.end());
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Keys                                                             //
@@ -2490,113 +2514,72 @@ optional<cheque_info_object> database_api_impl::get_cheque_by_code(const std::st
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
-void database_api_impl::broadcast_updates( const vector<variant>& updates )
+/// Calls back with @p updates, a remote subscriber gets them as the json the journal wrote
+static void send_notice( const std::function<void(const variant&)>& callback, const object_change_journal::notice& updates )
 {
-   if( updates.size() ) {
-      auto capture_this = shared_from_this();
-      fc::async([capture_this,updates](){
-          capture_this->_subscribe_callback( fc::variant(updates) );
-      });
-   }
+   typedef fc::detail::callback_functor<void(const variant&)> remote_callback;
+   const remote_callback* remote = callback.target<remote_callback>();
+   if( remote )
+      remote->send_json( updates.args_json );
+   else
+      callback( updates.value );
 }
 
 void database_api_impl::on_objects_removed( const vector<const object*>& objs )
 {
-   /// we need to ensure the database_api is not deleted for the life of the async operation
-   if( _subscribe_callback )
-   {
-      vector<variant>    updates;
-      updates.reserve(objs.size());
+   if( !_subscribe_callback && _market_subscriptions.empty() )
+      return;
 
-      for( auto obj : objs )
-         updates.emplace_back( obj->to_variant() );
-      broadcast_updates( updates );
-   }
+   auto removed = _change_journal->removed( objs );
+   if( ( !_subscribe_callback || removed->updates.value.get_array().empty() ) && removed->market_updates.empty() )
+      return;
 
-   if( _market_subscriptions.size() )
-   {
-      map< pair<asset_id_type, asset_id_type>, vector<variant> > broadcast_queue;
-      for( const auto& obj : objs )
-      {
-         const limit_order_object* order = dynamic_cast<const limit_order_object*>(obj);
-         if( order )
-         {
-            auto sub = _market_subscriptions.find( order->get_market() );
-            if( sub != _market_subscriptions.end() )
-               broadcast_queue[order->get_market()].emplace_back( order->to_variant() );
-         }
-      }
-      if( broadcast_queue.size() )
+   /// we need to ensure the database_api is not deleted for the life of the async operation
+   auto capture_this = shared_from_this();
+   fc::async([capture_this,this,removed](){
+      if( _subscribe_callback && !removed->updates.value.get_array().empty() )
+         send_notice( _subscribe_callback, removed->updates );
+
+      for( const auto& item : removed->market_updates )
       {
-         auto capture_this = shared_from_this();
-         fc::async([capture_this,this,broadcast_queue](){
-             for( const auto& item : broadcast_queue )
-             {
-               auto sub = _market_subscriptions.find(item.first);
-               if( sub != _market_subscriptions.end() )
-                   sub->second( fc::variant(item.second ) );
-             }
-         });
+        auto sub = _market_subscriptions.find(item.first);
+        if( sub != _market_subscriptions.end() )
+            send_notice( sub->second, item.second );
       }
-   }
+   });
 }
 
 void database_api_impl::on_objects_changed(const vector<object_id_type>& ids)
 {
-   if (_db.start_notify_block_num >= _db.head_block_num()) return;
-   vector<variant>    updates;
-   map< pair<asset_id_type, asset_id_type>,  vector<variant> > market_broadcast_queue;
-   for(auto id : ids)
+   for (const object_id_type& id: ids)
    {
-      if (id == ALPHA_ACCOUNT_ID) continue;
-
-      const vector<optional<asset_object>>& assets = get_assets({EDC_ASSET});
-      if ( (assets.size() > 0) && assets[0].valid() && (assets[0]->issuer == id) ) { continue; }
-
-      const object* obj = nullptr;
-      if( _subscribe_callback )
-      {
-         obj = _db.find_object( id );
-         if( obj )
-         {
-            updates.emplace_back( obj->to_variant() );
-         }
-         else
-         {
-            updates.emplace_back(fc::variant( id, 1 )); // send just the id to indicate removal
-         }
-      }
-
-      if( _market_subscriptions.size() )
+      if (id.is<account_id_type>() || id.is<account_balance_id_type>())
       {
-         if( !_subscribe_callback )
-            obj = _db.find_object( id );
-         if( obj )
-         {
-            const limit_order_object* order = dynamic_cast<const limit_order_object*>(obj);
-            if( order )
-            {
-               auto sub = _market_subscriptions.find( order->get_market() );
-               if( sub != _market_subscriptions.end() )
-                  market_broadcast_queue[order->get_market()].emplace_back( order->to_variant() );
-            }
-         }
+         std::lock_guard<std::mutex> lock(_referrals_mutex);
+         _referrals_cache.clear();
+         break;
       }
    }
 
+   if (_db.start_notify_block_num >= _db.head_block_num()) return;
+   if( !_subscribe_callback && _market_subscriptions.empty() ) return;
+
+   // the objects are converted once for all sessions
+   auto changes = _change_journal->changed( ids );
+
    auto capture_this = shared_from_this();
 
    /// pushing the future back / popping the prior future if it is complete.
    /// if a connection hangs then this could get backed up and result in
    /// a failure to exit cleanly.
-   fc::async([capture_this,this,updates,market_broadcast_queue](){
-      if( _subscribe_callback ) _subscribe_callback( updates );
+   fc::async([capture_this,this,changes](){
+      if( _subscribe_callback ) send_notice( _subscribe_callback, changes->updates );
 
-      for( const auto& item : market_broadcast_queue )
+      for( const auto& item : changes->market_updates )
       {
         auto sub = _market_subscriptions.find(item.first);
         if( sub != _market_subscriptions.end() )
-            sub->second( fc::variant(item.second ) );
+            send_notice( sub->second, item.second );
       }
    });
 }
@@ -2606,6 +2589,12 @@ void database_api_impl::on_objects_changed(const vector<object_id_type>& ids)
  */
 void database_api_impl::on_applied_block()
 {
+   {
+      // the block may follow popped ones, whose changes are not reported
+      std::lock_guard<std::mutex> lock(_referrals_mutex);
+      _referrals_cache.clear();
+   }
+
    if (_block_applied_callback)
    {
       auto capture_this = shared_from_this();
@@ -2666,19 +2655,11 @@ Unit database_api::get_referrals(const std::string& account_name_or_id)
 
 Unit database_api_impl::get_referrals(optional<account_object> account) const
 {
-   const auto& idx = _db.get_index_type<chain::account_index>();
    auto asset = _db.get_index_type<asset_index>().indices().get<by_symbol>().find(EDC_ASSET_SYMBOL);
    Unit result(account->get_id(), account->name, _db.get_balance(account->id, asset->id).amount.value);
-   idx.inspect_all_objects([&](const chain::object& obj)
-   {
-      const account_object& acc = static_cast<const chain::account_object&>(obj);
-      if (acc.referrer == account->get_id())
-      {
-         auto balance = _db.get_balance(acc.id, asset->id).amount.value;
-         auto nElem = Unit(acc.get_id(), acc.name, balance);
-         result.referrals.push_back(std::move(nElem));
-      }
-   });
+   for (const leaf_info& leaf: get_referral_subtree(account->get_id(), 1)->level_1) {
+      result.referrals.push_back(Unit(leaf.account_id, leaf.account_id(_db).name, leaf.balance));
+   }
    return result;
 }
 
@@ -2691,20 +2672,89 @@ ref_info database_api::get_referrals2(const std::string& account_name_or_id)
 
 ref_info database_api_impl::get_referrals2( optional<account_object> account ) const
 {
-    const auto& idx = _db.get_index_type<chain::account_index>();
-    auto asset = _db.get_index_type<asset_index>().indices().get<by_symbol>().find(EDC_ASSET_SYMBOL);
-    auto& bal_idx = _db.get_index_type<account_balance_index>();
-    referral_tree rtree( idx, bal_idx, asset->id, account->id );
-    rtree.form_old();
-    leaf_info root = *rtree.referral_map.find(account->id)->second;
-    ref_info result( root, account->name );
-    for (child_balance e: root.child_balances)
-    {
-        if (e.level == 1) {
-            result.level_1.push_back(ref_info(*rtree.referral_map.find(e.account_id)->second, e.account_id(_db).name));
-        }
-    }
-    return result;
+   auto subtree = get_referral_subtree(account->get_id(), std::numeric_limits<uint32_t>::max());
+   ref_info result( subtree->root, account->name );
+   for (const leaf_info& leaf: subtree->level_1)
+   {
+      // an account referring itself is reported with its whole tree, as referral_tree::referral_map finds the root
+      const leaf_info& level_1 = (leaf.account_id == account->get_id()) ? subtree->root : leaf;
+      result.level_1.push_back(ref_info(level_1, leaf.account_id(_db).name));
+   }
+   return result;
+}
+
+std::shared_ptr<const database_api_impl::referral_subtree>
+database_api_impl::get_referral_subtree( account_id_type account, uint32_t depth )const
+{
+   const auto key = std::make_pair(account, depth);
+   {
+      std::lock_guard<std::mutex> lock(_referrals_mutex);
+      auto itr = _referrals_cache.find(key);
+      if (itr != _referrals_cache.end()) {
+         return itr->second;
+      }
+   }
+
+   const auto& referred_by = dynamic_cast<const primary_index<account_index>&>(_db.get_index_type<account_index>())
+                                .get_secondary_index<account_referrer_index>().referred_by;
+   auto asset = _db.get_index_type<asset_index>().indices().get<by_symbol>().find(EDC_ASSET_SYMBOL);
+   auto get_balance = [&](account_id_type id) { return _db.get_balance(id, asset->id).amount.value; };
+
+   auto result = std::make_shared<referral_subtree>();
+   result->root = leaf_info(account, get_balance(account));
+
+   // Accounts are taken in the way referral_tree::form_old() attaches them while scanning accounts by id: the
+   // committee account never, an account only if it comes after its referrer, unless the referrer is the root, and
+   // the root reached again is a leaf. Referrals are visited by id, as that scan adds them.
+   struct walk_item
+   {
+      account_id_type id;
+      uint32_t        level;
+      size_t          level_1;
+   };
+   std::vector<walk_item> stack;
+   stack.push_back({account, 0, 0});
+   while (!stack.empty())
+   {
+      const walk_item item = stack.back();
+      stack.pop_back();
+
+      size_t level_1 = item.level_1;
+      if (item.level > 0)
+      {
+         const uint64_t balance = get_balance(item.id);
+         result->root.add_child_balance_old(item.id, balance, item.level);
+         if (item.level == 1)
+         {
+            level_1 = result->level_1.size();
+            result->level_1.push_back(leaf_info(item.id, balance));
+         }
+         else {
+            result->level_1[level_1].add_child_balance_old(item.id, balance, item.level - 1);
+         }
+      }
+
+      if ((item.level >= depth) || ((item.level > 0) && (item.id == account))) { continue; }
+      auto referrals = referred_by.find(item.id);
+      if (referrals == referred_by.end()) { continue; }
+      for (auto itr = referrals->second.rbegin(); itr != referrals->second.rend(); ++itr)
+      {
+         if (*itr == GRAPHENE_COMMITTEE_ACCOUNT) { continue; }
+         if ((item.level > 0) && (*itr < item.id)) { continue; }
+         stack.push_back({*itr, item.level + 1, level_1});
+      }
+   }
+
+   referral_tree::set_bonus_percent(result->root);
+   result->root.child_balances.clear();
+   for (leaf_info& leaf: result->level_1)
+   {
+      referral_tree::set_bonus_percent(leaf);
+      leaf.child_balances.clear();
+   }
+
+   std::lock_guard<std::mutex> lock(_referrals_mutex);
+   return _referrals_cache.emplace(key, std::move(result)).first->second;
 }
 
 vector<SimpleUnit> database_api::get_accounts_info(vector<string> account_names_or_ids)
@@ -2852,40 +2902,25 @@ int64_t database_api::get_user_count_with_balances(std::vector<fc::time_point_se
 
 int64_t database_api_impl::get_user_count_with_balances(fc::time_point_sec start, fc::time_point_sec end) const 
 {
-   const auto& idx = _db.get_index_type<chain::account_index>().indices().get<by_id>();
-   auto asset = _db.get_index_type<asset_index>().indices().get<by_symbol>().find(EDC_ASSET_SYMBOL);
-   int64_t users_count = 0;
+   const auto& assets_by_symbol = _db.get_index_type<asset_index>().indices().get<by_symbol>();
+   auto asset = assets_by_symbol.find(EDC_ASSET_SYMBOL);
+   FC_ASSERT( asset != assets_by_symbol.end() );
+   const auto& bidx = dynamic_cast<const primary_index<account_balance_index>&>(_db.get_index_type<account_balance_index>());
+   const auto& holders = bidx.get_secondary_index<account_holder_index>();
+
    if (start == fc::time_point_sec() && end == fc::time_point_sec()) {
-      for (auto account = ++idx.begin(); account != idx.end(); account++) {
-         auto balance = _db.get_balance(account->id, asset->id).amount.value;
-         if (balance < 1) continue;
-         users_count++;
-      }
-   } else {
-      if (end == fc::time_point_sec())
-         end = fc::time_point::now();
-      for (auto account = ++idx.begin(); account != idx.end(); account++) {
-         auto balance = _db.get_balance(account->id, asset->id).amount.value;
-         if (balance < 1) continue;
-
-         const auto& stats = account->statistics(_db);
-         const account_transaction_history_object* node = &stats.most_recent_op(_db);
-         //uint32_t ops_count = stats.total_ops;
-         while (true) {
-            if (node->next == account_transaction_history_id_type()) break;
-            node = &node->next(_db);
-         }
-         auto& hist = node->operation_id(_db);
-         if (hist.op.which() == 5) { // account_create_operation 
-            auto op = hist.op.get<account_create_operation>();
-            fc::time_point_sec create_time = _db.fetch_block_by_number(hist.block_num)->timestamp;
-            if (create_time >= start && create_time <= end) {
-               users_count++;
-            }
-         }
-      }
+      // the committee account is not a user
+      int64_t users_count = holders.holder_count(asset->id);
+      if (_db.get_balance(account_id_type(), asset->id).amount > 0)
+         users_count--;
+      return users_count;
    }
-   return users_count;
+
+   if (end == fc::time_point_sec())
+      end = fc::time_point::now();
+   // the accounts of the genesis state are not registered by account_create
+   start = std::max(start, fc::time_point_sec(1));
+   return holders.holder_count(asset->id, start, end);
 }
 
 std::pair<uint32_t, std::vector<account_id_type>>
@@ -2929,4 +2964,56 @@ database_api_impl::get_users_with_asset(const asset_id_type& asst, uint32_t star
    return {last_item_num, v_result};
 }
 
+vector<account_balance_object>
+database_api::get_asset_holders(asset_id_type asset_id, account_id_type start, uint32_t limit) const {
+   return my->get_asset_holders(asset_id, start, limit);
+}
+
+vector<account_balance_object>
+database_api_impl::get_asset_holders(asset_id_type asset_id, account_id_type start, uint32_t limit) const
+{
+   FC_ASSERT(limit <= 100);
+
+   const auto& bidx = dynamic_cast<const primary_index<account_balance_index>&>(_db.get_index_type<account_balance_index>());
+   const auto& by_account_asset_idx = bidx.indices().get<by_account_asset>();
+
+   vector<account_balance_object> result;
+   result.reserve(limit);
+   for (const account_id_type& owner : bidx.get_secondary_index<account_holder_index>().holders(asset_id, start, limit))
+   {
+      auto itr = by_account_asset_idx.find(boost::make_tuple(owner, asset_id));
+      // the holders follow the balances, a holder without one would be a bug in the index
+      if (itr == by_account_asset_idx.end())
+      {
+         elog("Holder ${a} of ${asset} has no balance", ("a", owner)("asset", asset_id));
+         continue;
+      }
+      result.push_back(*itr);
+   }
+   return result;
+}
+
+vector<account_balance_object>
+database_api::get_asset_holders_by_balance(asset_id_type asset_id, share_type start_balance,
+                                           account_id_type start, uint32_t limit) const {
+   return my->get_asset_holders_by_balance(asset_id, start_balance, start, limit);
+}
+
+vector<account_balance_object>
+database_api_impl::get_asset_holders_by_balance(asset_id_type asset_id, share_type start_balance,
+                                                account_id_type start, uint32_t limit) const
+{
+   FC_ASSERT(limit <= 100);
+
+   const auto& idx = _db.get_index_type<account_balance_index>().indices().get<by_asset_balance>();
+
+   vector<account_balance_object> result;
+   result.reserve(limit);
+   // balances are ordered from the largest, the empty ones come last
+   for (auto itr = idx.lower_bound(boost::make_tuple(asset_id, start_balance, start));
+        itr != idx.end() && itr->asset_type == asset_id && itr->balance > 0 && result.size() < limit; ++itr)
+      result.push_back(*itr);
+   return result;
+}
+
 } } // graphene::app
@@ -1,8 +1,12 @@
 
 #include <graphene/app/database_api.hpp>
 
+#include "object_change_journal.hxx"
+
 #include <fc/bloom_filter.hpp>
 
+#include <mutex>
+
 #define GET_REQUIRED_FEES_MAX_RECURSION 4
 
 namespace graphene { namespace app {
@@ -26,6 +30,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       // Blocks and transactions
       optional<block_header> get_block_header(uint32_t block_num)const;
       optional<signed_block> get_block(uint32_t block_num);
+      vector<vector<char>> get_blocks(uint32_t first, uint32_t count)const;
       optional<signed_block> get_block_by_id(string block_num);
       processed_transaction get_transaction(uint32_t block_num, uint32_t trx_in_block);
       optional<signed_block> get_block_reserved(uint32_t block_num);
@@ -36,6 +41,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       fc::variant_object get_config() const;
       chain_id_type get_chain_id() const;
       dynamic_global_property_object get_dynamic_global_properties() const;
+      vector<maintenance_profile> get_maintenance_profiles() const;
 
       // Keys
       vector<vector<account_id_type>> get_key_references( vector<public_key_type> key ) const;
@@ -63,6 +69,9 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       fc::variant_object get_user_count_by_ranks() const;
       int64_t get_user_count_with_balances(fc::time_point_sec start, fc::time_point_sec end) const;
       std::pair<uint32_t, std::vector<account_id_type>> get_users_with_asset(const asset_id_type& asst, uint32_t start, uint32_t limit) const;
+      vector<account_balance_object> get_asset_holders(asset_id_type asset_id, account_id_type start, uint32_t limit) const;
+      vector<account_balance_object> get_asset_holders_by_balance(asset_id_type asset_id, share_type start_balance,
+                                                                  account_id_type start, uint32_t limit) const;
       vector<account_id_type> get_account_references(account_id_type account_id) const;
       optional<restricted_account_object> get_restricted_account(account_id_type account_id) const;
       vector<optional<account_object>> lookup_account_names(const vector<string>& account_names)const;
@@ -180,23 +189,39 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
          return _subscribe_filter.contains( i );
       }
 
-      void broadcast_updates( const vector<variant>& updates );
-
       /** called every time a block is applied to report the objects that were changed */
       void on_objects_changed(const vector<object_id_type>& ids);
       void on_objects_removed(const vector<const object*>& objs);
       void on_applied_block();
 
+      /** the referral tree of an account as get_referrals2() reports it, child_balances are not kept */
+      struct referral_subtree
+      {
+         leaf_info         root;
+         vector<leaf_info> level_1;
+      };
+
+      /**
+       * Walks the referrals of @p account up to @p depth levels down account_referrer_index, memoized until accounts
+       * or balances change or another block is applied.
+       */
+      std::shared_ptr<const referral_subtree> get_referral_subtree( account_id_type account, uint32_t depth )const;
+
       mutable fc::bloom_filter                               _subscribe_filter;
       std::function<void(const fc::variant&)> _subscribe_callback;
       std::function<void(const fc::variant&)> _pending_trx_callback;
       std::function<void(const fc::variant&)> _block_applied_callback;
 
+      /// shared with the other sessions of _db, it converts the changed objects for all of them
+      std::shared_ptr<object_change_journal> _change_journal;
       boost::signals2::scoped_connection _change_connection;
       boost::signals2::scoped_connection _removed_connection;
       boost::signals2::scoped_connection _applied_block_connection;
       boost::signals2::scoped_connection _pending_trx_connection;
       map<pair<asset_id_type,asset_id_type>, std::function<void(const variant&)>> _market_subscriptions;
+      /// get_referral_subtree() results by (account, depth), read-only calls may run on several threads
+      mutable std::mutex                                                                 _referrals_mutex;
+      mutable map<pair<account_id_type,uint32_t>, std::shared_ptr<const referral_subtree>> _referrals_cache;
       graphene::chain::database& _db;
 };
 
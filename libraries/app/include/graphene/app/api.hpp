@@ -239,6 +239,9 @@ namespace graphene { namespace app {
 
          /**
           * @brief Return general network information, such as p2p port
+          *
+          * message_cache holds the size, the hits and misses of the lookups, and the numbers of messages expired
+          * and evicted for the byte limit, which is set by message_cache_max_bytes of the advanced node parameters.
           */
          fc::variant_object get_info() const;
 
@@ -178,6 +178,14 @@ class database_api
        */
       optional<signed_block> get_block(uint32_t block_num) const;
 
+      /**
+       * @brief Retrieve a range of consecutive blocks, packed
+       * @param first Height of the first block to be returned
+       * @param count Number of blocks to be returned, at most 100
+       * @return the packed blocks in order, fewer than @p count if the head block is reached
+       */
+      vector<vector<char>> get_blocks(uint32_t first, uint32_t count) const;
+
       /**
        * @brief Retrieve a full, signed block
        * @param block_id Id of the block to be returned
@@ -226,6 +234,11 @@ class database_api
        */
       dynamic_global_property_object get_dynamic_global_properties()const;
 
+      /**
+       * @brief Retrieve per-phase timings of the recent chain maintenances, oldest first
+       */
+      vector<maintenance_profile> get_maintenance_profiles()const;
+
       //////////
       // Keys //
       //////////
@@ -283,10 +296,34 @@ class database_api
 
       /**
        * @return number of the last element in query and user ids who have asset 'asst'
+       *
+       * Every call goes through the balances from the first one, @ref get_asset_holders pages in logarithmic time.
        */
       std::pair<uint32_t, std::vector<account_id_type>>
       get_users_with_asset(const asset_id_type& asst, uint32_t start, uint32_t limit) const;
 
+      /**
+       * @brief Get the balances of the accounts holding an asset, ordered by account
+       * @param asset_id ID of the asset
+       * @param start ID of the first account to return; the next page starts after the last account returned
+       * @param limit Maximum number of balances to return, at most 100
+       * @return The positive balances of @ref asset_id
+       */
+      vector<account_balance_object> get_asset_holders(asset_id_type asset_id, account_id_type start,
+                                                       uint32_t limit) const;
+
+      /**
+       * @brief Get the balances of the accounts holding an asset, the largest first
+       * @param asset_id ID of the asset
+       * @param start_balance Balance of the first account to return, GRAPHENE_MAX_SHARE_SUPPLY for the first page
+       * @param start ID of the first account to return among the ones with @ref start_balance
+       * @param limit Maximum number of balances to return, at most 100
+       * @return The positive balances of @ref asset_id; the next page starts at the balance and the account after
+       * the last one returned
+       */
+      vector<account_balance_object> get_asset_holders_by_balance(asset_id_type asset_id, share_type start_balance,
+                                                                  account_id_type start, uint32_t limit) const;
+
       /**
        * @brief Fetch all objects relevant to the specified accounts and subscribe to updates
        * @param callback Function to call with updates
@@ -749,6 +786,7 @@ FC_API(graphene::app::database_api,
    (get_block_header)
    (get_block_by_id)
    (get_block)
+   (get_blocks)
    (get_transaction)
    (get_recent_transaction_by_id)
    (get_block_reserved)
@@ -759,6 +797,7 @@ FC_API(graphene::app::database_api,
    (get_config)
    (get_chain_id)
    (get_dynamic_global_properties)
+   (get_maintenance_profiles)
 
    // Keys
    (get_key_references)
@@ -777,6 +816,8 @@ FC_API(graphene::app::database_api,
    (get_user_count_by_ranks)
    (get_user_count_with_balances)
    (get_users_with_asset)
+   (get_asset_holders)
+   (get_asset_holders_by_balance)
    (get_full_accounts)
    (get_bonus_balances)
    (get_account_by_name)
@@ -44,3 +44,5 @@ FC_REFLECT( graphene::app::full_account,
             (proposals) 
             (bonus_balances_id)
           )
+
+FC_JSON_STREAM_MEMBERS( graphene::app::full_account )
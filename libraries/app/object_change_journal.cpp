@@ -0,0 +1,147 @@
+// see LICENSE.txt
+
+#include "object_change_journal.hxx"
+
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/net/config.hpp>
+
+#include <fc/io/json_writer.hpp>
+
+#include <mutex>
+
+namespace graphene { namespace app {
+
+namespace {
+
+   /// The updates of a notification, each one written as json once
+   class notice_builder
+   {
+      public:
+         typedef object_change_journal::market_type market_type;
+
+         void add( fc::variant update, const market_type* market )
+         {
+            _json.push_back( fc::json_writer::to_string( update, fc::json::stringify_large_ints_and_doubles,
+                                                         GRAPHENE_NET_MAX_NESTED_OBJECTS ) );
+            if( market )
+               _markets[*market].push_back( _values.size() );
+            _values.push_back( std::move( update ) );
+         }
+
+         std::shared_ptr<const object_change_journal::batch> build()const
+         {
+            std::vector<size_t> all( _values.size() );
+            for( size_t i = 0; i < all.size(); ++i )
+               all[i] = i;
+            auto result = std::make_shared<object_change_journal::batch>();
+            result->updates = make_notice( all );
+            for( const auto& item : _markets )
+               result->market_updates.emplace( item.first, make_notice( item.second ) );
+            return result;
+         }
+
+      private:
+         object_change_journal::notice make_notice( const std::vector<size_t>& updates )const
+         {
+            object_change_journal::notice result;
+            vector<variant> values;
+            values.reserve( updates.size() );
+            fc::json_writer args;
+            args.begin_array();
+            args.begin_array();
+            for( size_t i : updates )
+            {
+               values.push_back( _values[i] );
+               args.write_raw( _json[i] );
+            }
+            args.end_array();
+            args.end_array();
+            result.value = fc::variant( std::move( values ) );
+            result.args_json = args.release();
+            return result;
+         }
+
+         vector<variant>                              _values;
+         std::vector<std::string>                     _json;
+         std::map< market_type, std::vector<size_t> > _markets;
+   };
+
+}
+
+std::shared_ptr<object_change_journal> object_change_journal::get( graphene::chain::database& db )
+{
+   static std::mutex mutex;
+   static std::map< const graphene::chain::database*, std::weak_ptr<object_change_journal> > journals;
+
+   std::lock_guard<std::mutex> lock( mutex );
+   auto& entry = journals[&db];
+   auto result = entry.lock();
+   if( !result )
+   {
+      result = std::make_shared<object_change_journal>( db );
+      entry = result;
+   }
+   for( auto itr = journals.begin(); itr != journals.end(); )
+      itr = itr->second.expired() ? journals.erase( itr ) : std::next( itr );
+   return result;
+}
+
+object_change_journal::object_change_journal( graphene::chain::database& db ) : _db(db)
+{
+   // ahead of the sessions, which connect at the back, so a batch is never one of the previous notification
+   _change_connection = _db.changed_objects.connect( [this]( const vector<object_id_type>& ) {
+                           _changed.reset();
+                        }, boost::signals2::at_front );
+   _removed_connection = _db.removed_objects.connect( [this]( const vector<const object*>& ) {
+                            _removed.reset();
+                         }, boost::signals2::at_front );
+}
+
+std::shared_ptr<const object_change_journal::batch> object_change_journal::changed( const vector<object_id_type>& ids )
+{
+   if( _changed )
+      return _changed;
+
+   const asset_object* edc = _db.find( EDC_ASSET );
+
+   notice_builder updates;
+   for( const object_id_type& id : ids )
+   {
+      if( id == ALPHA_ACCOUNT_ID ) continue;
+      if( edc && edc->issuer == id ) continue;
+
+      const object* obj = _db.find_object( id );
+      if( !obj )
+      {
+         updates.add( fc::variant( id, 1 ), nullptr ); // send just the id to indicate removal
+         continue;
+      }
+
+      const limit_order_object* order = dynamic_cast<const limit_order_object*>( obj );
+      const market_type market = order ? order->get_market() : market_type();
+      updates.add( obj->to_variant(), order ? &market : nullptr );
+   }
+
+   _changed = updates.build();
+   return _changed;
+}
+
+std::shared_ptr<const object_change_journal::batch> object_change_journal::removed( const vector<const object*>& objs )
+{
+   if( _removed )
+      return _removed;
+
+   notice_builder updates;
+   for( const object* obj : objs )
+   {
+      const limit_order_object* order = dynamic_cast<const limit_order_object*>( obj );
+      const market_type market = order ? order->get_market() : market_type();
+      updates.add( obj->to_variant(), order ? &market : nullptr );
+   }
+
+   _removed = updates.build();
+   return _removed;
+}
+
+} } // graphene::app
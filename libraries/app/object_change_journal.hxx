@@ -0,0 +1,61 @@
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace graphene { namespace app {
+
+using namespace graphene::chain;
+
+/**
+ * The changes the database reports to the API sessions, converted to variants and written as json once for all of them.
+ *
+ * Every session used to convert every changed object for its own subscribers. The journal connects to the database
+ * signals ahead of the sessions and builds the batch of a notification when the first session asks for it. The
+ * other sessions get the same batch, and the callbacks they queue share it instead of copying the updates. Each
+ * object is written as json once, and the notices to remote subscribers carry that json as it is.
+ */
+class object_change_journal
+{
+   public:
+      typedef std::pair<asset_id_type, asset_id_type> market_type;
+
+      struct notice
+      {
+         /// the argument of the callbacks
+         fc::variant value;
+         /// the arguments of the callbacks as a json array, which api_connection::send_notice_json() sends
+         std::string args_json;
+      };
+
+      struct batch
+      {
+         /// what the subscribe callbacks receive: the changed objects, and the ids of the ones that are gone
+         notice                        updates;
+         /// the limit orders among the objects, for the subscribers of their markets
+         std::map<market_type, notice> market_updates;
+      };
+
+      /// @return the journal the sessions of @p db share, created if none is in use
+      static std::shared_ptr<object_change_journal> get( graphene::chain::database& db );
+
+      explicit object_change_journal( graphene::chain::database& db );
+
+      /// @return the batch of the current notification of database::changed_objects
+      std::shared_ptr<const batch> changed( const vector<object_id_type>& ids );
+      /// @return the batch of the current notification of database::removed_objects
+      std::shared_ptr<const batch> removed( const vector<const object*>& objs );
+
+   private:
+      graphene::chain::database&         _db;
+      std::shared_ptr<const batch>       _changed;
+      std::shared_ptr<const batch>       _removed;
+      boost::signals2::scoped_connection _change_connection;
+      boost::signals2::scoped_connection _removed_connection;
+};
+
+} } // graphene::app
@@ -417,10 +417,403 @@ void account_member_index::object_modified(const object& after)
 
 }
 
-void account_referrer_index::object_inserted( const object& obj ) { }
-void account_referrer_index::object_removed( const object& obj ) { }
-void account_referrer_index::about_to_modify( const object& before ) { }
-void account_referrer_index::object_modified( const object& after  ) { }
+void account_referrer_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(obj);
+   referred_by[a.referrer].insert(a.get_id());
+}
+
+void account_referrer_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(obj);
+   auto itr = referred_by.find(a.referrer);
+   if (itr == referred_by.end()) { return; }
+   itr->second.erase(a.get_id());
+   if (itr->second.empty()) { referred_by.erase(itr); }
+}
+
+void account_referrer_index::about_to_modify( const object& before )
+{
+   assert( dynamic_cast<const account_object*>(&before) ); // for debug only
+   before_referrer = static_cast<const account_object&>(before).referrer;
+}
+
+void account_referrer_index::object_modified( const object& after  )
+{
+   assert( dynamic_cast<const account_object*>(&after) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(after);
+   if (a.referrer == before_referrer) { return; }
+
+   auto itr = referred_by.find(before_referrer);
+   if (itr != referred_by.end())
+   {
+      itr->second.erase(a.get_id());
+      if (itr->second.empty()) { referred_by.erase(itr); }
+   }
+   referred_by[a.referrer].insert(a.get_id());
+}
+
+const referral_forest_index::node* referral_forest_index::find( account_id_type id )const
+{
+   auto itr = nodes.find(id);
+   return (itr != nodes.end()) ? &itr->second : nullptr;
+}
+
+bool referral_forest_index::is_visited( const account_object& a )const
+{
+   // form_referral_map() skips the committee account and market accounts when scanning accounts
+   return (a.get_id() != GRAPHENE_COMMITTEE_ACCOUNT) && !a.is_market_account;
+}
+
+optional<account_id_type> referral_forest_index::effective_parent( account_id_type id )const
+{
+   const node& n = nodes.at(id);
+   if (!n.account || (n.referrer == id)) { return optional<account_id_type>(); }
+
+   auto ref_itr = nodes.find(n.referrer);
+   if ((ref_itr == nodes.end()) || !ref_itr->second.account) { return optional<account_id_type>(); }
+   const node& ref = ref_itr->second;
+
+   // a self-referred referrer is never created as an ancestor, so referrals met before it stay top-level
+   if (ref.referrer == n.referrer)
+   {
+      if (ref.visited && (n.referrer.instance.value < n.key)) {
+         return n.referrer;
+      }
+      return optional<account_id_type>();
+   }
+
+   // never close a cycle, the full rebuild can't handle them either
+   for (optional<account_id_type> p = n.referrer; p.valid(); p = nodes.at(*p).parent)
+   {
+      if (*p == id) { return optional<account_id_type>(); }
+   }
+
+   return n.referrer;
+}
+
+referral_forest_index::ordered_nodes& referral_forest_index::siblings( const node& n )
+{
+   return n.parent.valid() ? nodes.at(*n.parent).children : roots;
+}
+
+void referral_forest_index::set_parent( account_id_type id, const optional<account_id_type>& parent )
+{
+   node& n = nodes.at(id);
+   if (n.parent == parent) { return; }
+
+   optional<account_id_type> old_parent = n.parent;
+   siblings(n).erase(std::make_pair(n.key, id));
+   n.parent = parent;
+   siblings(n).insert(std::make_pair(n.key, id));
+
+   // the grandparent of the children changes as well
+   touched.insert(id);
+   for (const auto& child: n.children) {
+      touched.insert(child.second);
+   }
+
+   if (old_parent.valid()) { update_key(*old_parent); }
+   if (parent.valid()) { update_key(*parent); }
+}
+
+void referral_forest_index::update_key( account_id_type id )
+{
+   node& n = nodes.at(id);
+
+   uint64_t key = n.visited ? id.instance.value : no_key;
+   if (!n.children.empty()) {
+      key = std::min(key, n.children.begin()->first);
+   }
+   if (key == n.key) { return; }
+
+   ordered_nodes& s = siblings(n);
+   s.erase(std::make_pair(n.key, id));
+   n.key = key;
+   s.insert(std::make_pair(n.key, id));
+   touched.insert(id);
+
+   // below a self-referred referrer the place of the node depends on its key
+   auto ref_itr = nodes.find(n.referrer);
+   if ((n.referrer != id) && (ref_itr != nodes.end()) && (ref_itr->second.referrer == n.referrer))
+   {
+      optional<account_id_type> parent = effective_parent(id);
+      if (parent != n.parent)
+      {
+         set_parent(id, parent);
+         return;
+      }
+   }
+
+   if (n.parent.valid()) {
+      update_key(*n.parent);
+   }
+}
+
+void referral_forest_index::reattach_referrals( account_id_type id )
+{
+   auto itr = referrers.referred_by.find(id);
+   if (itr == referrers.referred_by.end()) { return; }
+
+   for (const account_id_type& referral: itr->second)
+   {
+      if ((referral != id) && nodes.count(referral)) {
+         set_parent(referral, effective_parent(referral));
+      }
+   }
+}
+
+void referral_forest_index::sync()
+{
+   // first move the level counters, then the deposit sums that depend on them
+   set<account_id_type> recount;
+   for (const account_id_type& id: touched)
+   {
+      auto itr = nodes.find(id);
+      if (itr == nodes.end()) { continue; }
+      node& n = itr->second;
+      recount.insert(id);
+
+      optional<account_id_type> p, gp;
+      if (n.in_forest() && n.parent.valid() && (*n.parent != GRAPHENE_COMMITTEE_ACCOUNT))
+      {
+         p = n.parent;
+         const node& pn = nodes.at(*p);
+         if (pn.parent.valid() && (*pn.parent != GRAPHENE_COMMITTEE_ACCOUNT)) {
+            gp = pn.parent;
+         }
+      }
+
+      if (n.counted_in_parent != p)
+      {
+         if (n.counted_in_parent.valid()) {
+            --nodes.at(*n.counted_in_parent).level1_count;
+            recount.insert(*n.counted_in_parent);
+         }
+         if (p.valid()) {
+            ++nodes.at(*p).level1_count;
+            recount.insert(*p);
+         }
+         n.counted_in_parent = p;
+      }
+
+      if (n.counted_in_grandparent != gp)
+      {
+         if (n.counted_in_grandparent.valid()) {
+            --nodes.at(*n.counted_in_grandparent).level2_count;
+            recount.insert(*n.counted_in_grandparent);
+         }
+         if (gp.valid()) {
+            ++nodes.at(*gp).level2_count;
+            recount.insert(*gp);
+         }
+         n.counted_in_grandparent = gp;
+      }
+   }
+   touched.clear();
+
+   for (const account_id_type& id: recount)
+   {
+      node& n = nodes.at(id);
+
+      const bool summed = n.account && n.in_forest() && n.parent.valid() && (*n.parent != GRAPHENE_COMMITTEE_ACCOUNT);
+      // each referral walk passing from this node to its parent adds its deposits once
+      const uint32_t walks = summed ? 1 + n.level1_count + n.level2_count : 0;
+      const share_type deposits = summed ? n.account->edc_in_deposits * walks : share_type();
+      const uint32_t deposits_count = summed ? n.account->edc_active_deposits_count * walks : 0;
+
+      if (n.summed_in.valid())
+      {
+         node& old = nodes.at(*n.summed_in);
+         old.active_deposits_sum -= n.summed_deposits;
+         old.active_deposits_count_sum -= n.summed_deposits_count;
+      }
+      if (summed)
+      {
+         node& t = nodes.at(*n.parent);
+         t.active_deposits_sum += deposits;
+         t.active_deposits_count_sum += deposits_count;
+         n.summed_in = *n.parent;
+      }
+      else
+         n.summed_in.reset();
+      n.summed_deposits = deposits;
+      n.summed_deposits_count = deposits_count;
+   }
+}
+
+void referral_forest_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(obj);
+   const account_id_type id = a.get_id();
+
+   node& n = nodes[id];
+   n.account = &a;
+   n.referrer = a.referrer;
+   n.visited = is_visited(a);
+   roots.insert(std::make_pair(n.key, id));
+   touched.insert(id);
+
+   // children first, so that the key of the new node accounts for them
+   reattach_referrals(id);
+   update_key(id);
+   set_parent(id, effective_parent(id));
+   sync();
+}
+
+void referral_forest_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_object*>(&obj) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(obj);
+   const account_id_type id = a.get_id();
+
+   auto itr = nodes.find(id);
+   if (itr == nodes.end()) { return; }
+   node& n = itr->second;
+
+   n.account = nullptr;
+   n.visited = false;
+   reattach_referrals(id);
+   update_key(id);
+   set_parent(id, optional<account_id_type>());
+   touched.insert(id);
+   sync();
+
+   FC_ASSERT( n.children.empty() && !n.summed_in.valid() && !n.counted_in_parent.valid() );
+   roots.erase(std::make_pair(n.key, id));
+   nodes.erase(itr);
+}
+
+void referral_forest_index::object_modified( const object& after  )
+{
+   assert( dynamic_cast<const account_object*>(&after) ); // for debug only
+   const account_object& a = static_cast<const account_object&>(after);
+   const account_id_type id = a.get_id();
+
+   node& n = nodes.at(id);
+   touched.insert(id);
+
+   if (a.referrer != n.referrer)
+   {
+      const bool was_self_referred = (n.referrer == id);
+      n.referrer = a.referrer;
+
+      set_parent(id, effective_parent(id));
+      if (was_self_referred != (a.referrer == id)) {
+         reattach_referrals(id);
+      }
+   }
+
+   const bool visited = is_visited(a);
+   if (visited != n.visited)
+   {
+      n.visited = visited;
+      update_key(id);
+      reattach_referrals(id);
+   }
+
+   sync();
+}
+
+void account_holder_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   update( b, b.balance > 0 );
+}
+
+void account_holder_index::object_loaded( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   // the accounts are loaded in parallel with the balances, their registration times are looked up afterwards
+   if( b.balance > 0 )
+      _loaded_holders.push_back( holder{ b.asset_type, fc::time_point_sec(), b.owner } );
+}
+
+void account_holder_index::all_objects_loaded()
+{
+   for( holder& h : _loaded_holders )
+   {
+      h.registered = registration_time( h.owner );
+      if( _holders.insert( h ).second )
+         ++_holder_counts[h.asset];
+   }
+   _loaded_holders.clear();
+   _loaded_holders.shrink_to_fit();
+}
+
+void account_holder_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   update( static_cast<const account_balance_object&>(obj), false );
+}
+
+void account_holder_index::object_modified( const object& after )
+{
+   assert( dynamic_cast<const account_balance_object*>(&after) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(after);
+   update( b, b.balance > 0 );
+}
+
+void account_holder_index::update( const account_balance_object& balance, bool holds )
+{
+   auto& by_asset_idx = _holders.get<by_asset_owner>();
+   auto itr = by_asset_idx.find( boost::make_tuple( balance.asset_type, balance.owner ) );
+   if( holds == ( itr != by_asset_idx.end() ) )
+      return;
+
+   if( holds )
+   {
+      // the account is looked up only here, the undo of an account creation may remove it before its balances
+      _holders.insert( holder{ balance.asset_type, registration_time( balance.owner ), balance.owner } );
+      ++_holder_counts[balance.asset_type];
+   }
+   else
+   {
+      by_asset_idx.erase( itr );
+      auto count_itr = _holder_counts.find( balance.asset_type );
+      if( --count_itr->second == 0 )
+         _holder_counts.erase( count_itr );
+   }
+}
+
+fc::time_point_sec account_holder_index::registration_time( account_id_type account )const
+{
+   // the genesis creates the balance of the committee account before the account
+   const account_object* a = _db.find( account );
+   return a ? a->register_datetime : fc::time_point_sec();
+}
+
+uint64_t account_holder_index::holder_count( asset_id_type asset )const
+{
+   auto itr = _holder_counts.find( asset );
+   return itr == _holder_counts.end() ? 0 : itr->second;
+}
+
+vector<account_id_type> account_holder_index::holders( asset_id_type asset, account_id_type start,
+                                                      uint32_t limit )const
+{
+   vector<account_id_type> result;
+   const auto& idx = _holders.get<by_asset_owner>();
+   for( auto itr = idx.lower_bound( boost::make_tuple( asset, start ) );
+        itr != idx.end() && itr->asset == asset && result.size() < limit; ++itr )
+      result.push_back( itr->owner );
+   return result;
+}
+
+uint64_t account_holder_index::holder_count( asset_id_type asset, fc::time_point_sec start,
+                                             fc::time_point_sec end )const
+{
+   if( start > end )
+      return 0;
+   const auto& idx = _holders.get<by_registration>();
+   return idx.rank( idx.upper_bound( boost::make_tuple( asset, end ) ) )
+        - idx.rank( idx.lower_bound( boost::make_tuple( asset, start ) ) );
+}
 
 } } // graphene::chain
 
@@ -511,4 +904,8 @@ GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::blind_transfer2_obje
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::bonus_balances_object )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::account_balance_object )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::account_mature_balance_object )
-GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::account_statistics_object )
\ No newline at end of file
+GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::account_statistics_object )
+
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::chain::account_object )
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::chain::account_balance_object )
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::chain::account_statistics_object )
@@ -163,3 +163,6 @@ FC_REFLECT_DERIVED_NO_TYPENAME( graphene::chain::asset_bitasset_data_object, (gr
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::asset_object )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::asset_bitasset_data_object )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::asset_dynamic_data_object )
+
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::chain::asset_object )
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::chain::asset_dynamic_data_object )
@@ -0,0 +1,52 @@
+// see LICENSE.txt
+
+#include <graphene/chain/block_builder.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace graphene { namespace chain {
+
+block_builder::block_builder( size_t maximum_block_size, size_t header_size )
+   : _maximum_size(maximum_block_size), _size(header_size)
+{}
+
+void block_builder::push( processed_transaction&& trx, size_t packed_size )
+{
+   // calculate_merkle_root() hashes the digests in pairs level by level, and carries an odd one up unchanged,
+   // which leaves complete subtrees for the binary digits of the number of transactions, the largest first
+   _merkle_peaks.emplace_back( trx.merkle_digest(), 0 );
+   while( _merkle_peaks.size() > 1 && _merkle_peaks[_merkle_peaks.size() - 2].second == _merkle_peaks.back().second )
+   {
+      auto right = _merkle_peaks.back();
+      _merkle_peaks.pop_back();
+      auto& left = _merkle_peaks.back();
+      left.first = digest_type::hash( std::make_pair( left.first, right.first ) );
+      ++left.second;
+   }
+
+   _size += packed_size;
+   _transactions.push_back( std::move(trx) );
+}
+
+checksum_type block_builder::merkle_root()const
+{
+   if( _merkle_peaks.empty() )
+      return checksum_type();
+
+   // the incomplete subtree on the right is the one of the smaller peaks
+   auto itr = _merkle_peaks.rbegin();
+   digest_type root = itr->first;
+   for( ++itr; itr != _merkle_peaks.rend(); ++itr )
+      root = digest_type::hash( std::make_pair( itr->first, root ) );
+   return checksum_type::hash( root );
+}
+
+void block_builder::finish( signed_block& block )
+{
+   block.transaction_merkle_root = merkle_root();
+   block.transactions = std::move( _transactions );
+   _transactions.clear();
+   _merkle_peaks.clear();
+}
+
+} } // graphene::chain
@@ -2,8 +2,12 @@
 
 #include <graphene/chain/block_database.hpp>
 #include <graphene/protocol/fee_schedule.hpp>
+#include <fc/compress/zlib.hpp>
 #include <fc/io/raw.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 namespace graphene { namespace chain {
 
 struct index_entry
@@ -12,28 +16,122 @@ struct index_entry
    uint32_t      block_size = 0;
    block_id_type block_id;
 };
+
+/// "BARC", marks the start of an archive_index file
+static const uint32_t archive_magic = 0x43524142;
+
+struct archive_header
+{
+   uint32_t magic = archive_magic;
+   uint32_t blocks_per_chunk = 0;
+   uint32_t chunk_count = 0;
+   uint32_t reserved = 0;
+};
+
+/**
+ * A chunk decompresses to blocks_per_chunk + 1 offsets, followed by the packed blocks of the chunk back to back.
+ * Block i of the chunk spans the offsets i and i + 1 relative to the end of the offsets, absent blocks are empty.
+ */
+struct archive_chunk
+{
+   uint64_t chunk_pos = 0;
+   uint32_t chunk_size = 0;
+   uint32_t data_size = 0;
+};
  }}
 FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
 
 namespace graphene { namespace chain {
 
+namespace {
+   /// files of the database replaced by convert()
+   const char* const converted_files[] = { "index", "blocks", "archive", "archive_index" };
+
+   /**
+    * convert() writes the new files to the @c convert subdirectory, and the @c complete marker once all of them are
+    * written. Only then are they moved into the database. A conversion found with its marker has been interrupted
+    * while the files were being moved, and the rest of them are moved. Without the marker the database was left
+    * untouched, and the partial conversion is dropped.
+    */
+   void finish_conversion( const fc::path& dbdir )
+   {
+      const fc::path convert_dir = dbdir / "convert";
+      if( !fc::exists( convert_dir ) )
+         return;
+      if( fc::exists( convert_dir / "complete" ) )
+      {
+         for( const char* name : converted_files )
+            if( fc::exists( convert_dir / name ) )
+               fc::rename( convert_dir / name, dbdir / name );
+      }
+      else
+         wlog( "Dropping an incomplete conversion of the block database in ${d}", ("d", dbdir) );
+      fc::remove_all( convert_dir );
+   }
+}
+
 void block_database::open( const fc::path& dbdir )
 { try {
    fc::create_directories(dbdir);
-   _block_num_to_pos.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+   finish_conversion( dbdir );
+   _index_path = dbdir/"index";
+   _blocks_path = dbdir/"blocks";
+
    _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
 
-   if( !fc::exists( dbdir/"index" ) )
+   if( !fc::exists( _index_path ) )
    {
-     _block_num_to_pos.open( (dbdir/"index").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
+     std::ofstream( _index_path.generic_string().c_str(), std::ofstream::binary | std::ofstream::trunc );
+     _blocks.open( _blocks_path.generic_string().c_str(), std::fstream::binary | std::fstream::out | std::fstream::trunc );
+     _blocks.close();
    }
-   else
+   _blocks.open( _blocks_path.generic_string().c_str(), std::fstream::binary | std::fstream::out | std::fstream::app );
+   _blocks_size = fc::file_size( _blocks_path );
+
+   _index_size = fc::file_size( _index_path ) / sizeof(index_entry);
+   map_index( _index_size );
+   // the index file is grown ahead of the stored blocks, and is only trimmed back on close
+   while( _index_size > 0 && find_entry( _index_size - 1 )->block_id == block_id_type() )
+      --_index_size;
+
+   _archive_path = dbdir/"archive";
+   _archive_index_path = dbdir/"archive_index";
+   open_archive();
+} FC_CAPTURE_AND_RETHROW( (dbdir) ) }
+
+void block_database::open_archive()
+{
+   if( !fc::exists( _archive_index_path ) )
+      return;
+
+   const uint64_t index_size = fc::file_size( _archive_index_path );
+   FC_ASSERT( index_size >= sizeof(archive_header), "Archive index ${f} is truncated", ("f", _archive_index_path) );
+   _archive_index_file.reset( new fc::file_mapping( _archive_index_path.generic_string().c_str(), fc::read_only ) );
+   _archive_index_region.reset( new fc::mapped_region( *_archive_index_file, fc::read_only ) );
+
+   const char* base = static_cast<const char*>( _archive_index_region->get_address() );
+   _archive_header = reinterpret_cast<const archive_header*>( base );
+   FC_ASSERT( _archive_header->magic == archive_magic && _archive_header->blocks_per_chunk > 0,
+              "Archive index ${f} is corrupt", ("f", _archive_index_path) );
+
+   const uint64_t chunk_count = _archive_header->chunk_count;
+   const uint64_t archive_size = chunk_count * _archive_header->blocks_per_chunk;
+   FC_ASSERT( index_size == sizeof(archive_header) + chunk_count * sizeof(archive_chunk)
+                            + archive_size * sizeof(block_id_type),
+              "Archive index ${f} is truncated", ("f", _archive_index_path) );
+   _archive_chunks = reinterpret_cast<const archive_chunk*>( base + sizeof(archive_header) );
+   _archive_ids = reinterpret_cast<const block_id_type*>( _archive_chunks + chunk_count );
+
+   if( chunk_count > 0 )
    {
-     _block_num_to_pos.open( (dbdir/"index").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+      const archive_chunk& last_chunk = _archive_chunks[chunk_count - 1];
+      FC_ASSERT( fc::file_size( _archive_path ) >= last_chunk.chunk_pos + last_chunk.chunk_size,
+                 "Archive ${f} is truncated", ("f", _archive_path) );
+      _archive_file.reset( new fc::file_mapping( _archive_path.generic_string().c_str(), fc::read_only ) );
+      _archive_region.reset( new fc::mapped_region( *_archive_file, fc::read_only ) );
    }
-} FC_CAPTURE_AND_RETHROW( (dbdir) ) }
+   _archive_size = archive_size;
+}
 
 bool block_database::is_open()const
 {
@@ -42,14 +140,185 @@ bool block_database::is_open()const
 
 void block_database::close()
 {
+  _blocks_region.reset();
+  _blocks_file.reset();
   _blocks.close();
-  _block_num_to_pos.close();
+
+  _archive_region.reset();
+  _archive_file.reset();
+  _archive_index_region.reset();
+  _archive_index_file.reset();
+  _archive_header = nullptr;
+  _archive_chunks = nullptr;
+  _archive_ids = nullptr;
+  _archive_size = 0;
+  _cached_chunk = -1;
+  _cached_chunk_data.clear();
+
+  map_index( 0 );
+  if( fc::exists( _index_path ) )
+     fc::resize_file( _index_path, _index_size * sizeof(index_entry) );
+  _index_size = 0;
+  _blocks_size = 0;
 }
 
 void block_database::flush()
 {
   _blocks.flush();
-  _block_num_to_pos.flush();
+  if( _index_region )
+     _index_region->flush();
+}
+
+void block_database::map_index( uint64_t capacity )
+{
+   _index_region.reset();
+   _index_file.reset();
+   _index_capacity = 0;
+   if( capacity == 0 )
+      return;
+
+   if( fc::file_size( _index_path ) < capacity * sizeof(index_entry) )
+      fc::resize_file( _index_path, capacity * sizeof(index_entry) );
+   _index_file.reset( new fc::file_mapping( _index_path.generic_string().c_str(), fc::read_write ) );
+   _index_region.reset( new fc::mapped_region( *_index_file, fc::read_write ) );
+   _index_capacity = capacity;
+}
+
+const index_entry* block_database::find_entry( uint32_t block_num )const
+{
+   if( block_num >= _index_size )
+      return nullptr;
+   return static_cast<const index_entry*>( _index_region->get_address() ) + block_num;
+}
+
+index_entry* block_database::mutable_entry( uint32_t block_num )
+{
+   if( block_num >= _index_capacity )
+      map_index( std::max<uint64_t>( { uint64_t(block_num) + 1, _index_capacity * 2, 1024 } ) );
+   if( block_num >= _index_size )
+      _index_size = uint64_t(block_num) + 1;
+   return static_cast<index_entry*>( _index_region->get_address() ) + block_num;
+}
+
+const index_entry* block_database::last_entry()const
+{
+   for( uint64_t num = _index_size; num > _archive_size; --num )
+   {
+      const index_entry* e = find_entry( num - 1 );
+      if( e->block_size != 0 )
+         return e;
+   }
+   return nullptr;
+}
+
+uint32_t block_database::last_archived_num()const
+{
+   for( uint32_t num = _archive_size; num > 0; --num )
+      if( _archive_ids[num - 1] != block_id_type() )
+         return num - 1;
+   return 0;
+}
+
+const block_id_type* block_database::find_archived_id( uint32_t block_num )const
+{
+   if( block_num >= _archive_size || _archive_ids[block_num] == block_id_type() )
+      return nullptr;
+   return _archive_ids + block_num;
+}
+
+template<typename Visitor>
+void block_database::visit_archived_block( uint32_t block_num, Visitor&& visit )const
+{
+   FC_ASSERT( find_archived_id( block_num ), "Block number ${n} is not contained in the archive", ("n", block_num) );
+
+   const uint32_t blocks_per_chunk = _archive_header->blocks_per_chunk;
+   const uint32_t chunk_num = block_num / blocks_per_chunk;
+   const uint64_t offsets_size = ( uint64_t(blocks_per_chunk) + 1 ) * sizeof(uint32_t);
+   std::lock_guard<std::mutex> lock( _read_mutex );
+   if( _cached_chunk != chunk_num )
+   {
+      const archive_chunk& c = _archive_chunks[chunk_num];
+      FC_ASSERT( c.chunk_pos + c.chunk_size <= _archive_region->get_size(),
+                 "Chunk ${c} is not contained in the archive", ("c", chunk_num) );
+      _cached_chunk = -1;
+      _cached_chunk_data = fc::zlib_decompress( static_cast<const char*>( _archive_region->get_address() )
+                                                + c.chunk_pos, c.chunk_size );
+      FC_ASSERT( _cached_chunk_data.size() == c.data_size && c.data_size >= offsets_size,
+                 "Chunk ${c} of the archive is corrupt", ("c", chunk_num) );
+      _cached_chunk = chunk_num;
+   }
+
+   const char* data = _cached_chunk_data.data();
+   uint32_t offsets[2];
+   memcpy( offsets, data + ( block_num % blocks_per_chunk ) * sizeof(uint32_t), sizeof(offsets) );
+   FC_ASSERT( offsets[0] < offsets[1] && offsets_size + offsets[1] <= _cached_chunk_data.size(),
+              "Block number ${n} is corrupt in the archive", ("n", block_num) );
+
+   visit( data + offsets_size + offsets[0], offsets[1] - offsets[0] );
+}
+
+signed_block block_database::read_archived_block( uint32_t block_num )const
+{
+   signed_block result;
+   visit_archived_block( block_num, [&result]( const char* data, size_t size ) {
+      fc::datastream<const char*> ds( data, size );
+      fc::raw::unpack( ds, result );
+   });
+   return result;
+}
+
+template<typename Visitor>
+void block_database::visit_block( const index_entry& e, Visitor&& visit )const
+{
+   FC_ASSERT( e.block_size > 0 && e.block_pos + e.block_size <= _blocks_size,
+              "Block ${id} is not contained in the blocks file", ("id", e.block_id) );
+
+   std::lock_guard<std::mutex> lock( _read_mutex );
+   if( !_blocks_region || e.block_pos + e.block_size > _blocks_region->get_size() )
+   {
+      // the block was appended after the blocks file was mapped, map it again up to the write cursor
+      _blocks.flush();
+      _blocks_region.reset();
+      _blocks_file.reset( new fc::file_mapping( _blocks_path.generic_string().c_str(), fc::read_only ) );
+      _blocks_region.reset( new fc::mapped_region( *_blocks_file, fc::read_only ) );
+   }
+
+   visit( static_cast<const char*>( _blocks_region->get_address() ) + e.block_pos, e.block_size );
+}
+
+signed_block block_database::read_block( const index_entry& e )const
+{
+   signed_block result;
+   visit_block( e, [&result]( const char* data, size_t size ) {
+      fc::datastream<const char*> ds( data, size );
+      fc::raw::unpack( ds, result );
+   });
+   return result;
+}
+
+std::vector<std::vector<char>> block_database::fetch_packed_range( uint32_t first, uint32_t count )const
+{
+   std::vector<std::vector<char>> result;
+   result.reserve( count );
+   auto copy = [&result]( const char* data, size_t size ) {
+      result.emplace_back( data, data + size );
+   };
+   for( uint64_t block_num = first; block_num < uint64_t(first) + count; ++block_num )
+   {
+      if( block_num < _archive_size )
+      {
+         if( !find_archived_id( block_num ) )
+            break;
+         visit_archived_block( block_num, copy );
+         continue;
+      }
+
+      const index_entry* e = find_entry( block_num );
+      if( !e || e->block_size == 0 )
+         break;
+      visit_block( *e, copy );
+   }
+   return result;
 }
 
 void block_database::store( const block_id_type& _id, const signed_block& b )
@@ -60,34 +329,27 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
       id = b.id();
       elog( "id argument of block_database::store() was not initialized for block ${id}", ("id", id) );
    }
-   _block_num_to_pos.seekp( sizeof( index_entry ) * int64_t(block_header::num_from_id(id)) );
+   FC_ASSERT( block_header::num_from_id(id) >= _archive_size, "Block ${id} belongs to the archive", ("id", id) );
    index_entry e;
-   _blocks.seekp( 0, _blocks.end );
    auto vec = fc::raw::pack( b );
-   e.block_pos  = _blocks.tellp();
+   e.block_pos  = _blocks_size;
    e.block_size = vec.size();
    e.block_id   = id;
    _blocks.write( vec.data(), vec.size() );
-   _block_num_to_pos.write( (char*)&e, sizeof(e) );
+   _blocks_size += vec.size();
+   *mutable_entry( block_header::num_from_id(id) ) = e;
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
-   index_entry e;
-   auto index_pos = sizeof(e)*block_header::num_from_id(id);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( (uint32_t)_block_num_to_pos.tellg() <= index_pos )
+   uint32_t block_num = block_header::num_from_id(id);
+   FC_ASSERT( block_num >= _archive_size, "Archived block ${id} can not be removed", ("id", id) );
+   if( block_num >= _index_size )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-   if( e.block_id == id )
-   {
-      e.block_size = 0;
-      _block_num_to_pos.seekp( sizeof(e)*block_header::num_from_id(id) );
-      _block_num_to_pos.write( (char*)&e, sizeof(e) );
-   }
+   index_entry* e = mutable_entry( block_num );
+   if( e->block_id == id )
+      e->block_size = 0;
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
 bool block_database::contains( const block_id_type& id )const
@@ -95,54 +357,53 @@ bool block_database::contains( const block_id_type& id )const
    if( id == block_id_type() )
       return false;
 
-   index_entry e;
-   auto index_pos = sizeof(e)*block_header::num_from_id(id);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( (size_t)_block_num_to_pos.tellg() <= index_pos )
-      return false;
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
+   const uint32_t block_num = block_header::num_from_id(id);
+   if( block_num < _archive_size )
+      return _archive_ids[block_num] == id;
 
-   return e.block_id == id && e.block_size > 0;
+   const index_entry* e = find_entry( block_header::num_from_id(id) );
+   return e && e->block_id == id && e->block_size > 0;
 }
 
 block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
-   index_entry e;
-   auto index_pos = sizeof(e)*block_num;
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= int64_t(index_pos) )
-      FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
+   if( block_num < _archive_size )
+   {
+      FC_ASSERT( _archive_ids[block_num] != block_id_type(), "Empty block_id in block archive" );
+      return _archive_ids[block_num];
+   }
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
+   const index_entry* e = find_entry( block_num );
+   if( !e )
+      FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
-   return e.block_id;
+   FC_ASSERT( e->block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
+   return e->block_id;
 }
 
 fc::optional<signed_block> block_database::fetch_optional( const block_id_type& id )const
 {
    try
    {
-      index_entry e;
-      auto index_pos = sizeof(e)*block_header::num_from_id(id);
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( (size_t)_block_num_to_pos.tellg() <= index_pos )
-         return {};
-
-      _block_num_to_pos.seekg( index_pos );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      if( e.block_id != id ) return fc::optional<signed_block>();
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      if (e.block_size)
-         _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
+      const uint32_t block_num = block_header::num_from_id(id);
+      if( block_num < _archive_size )
+      {
+         const block_id_type* archived_id = find_archived_id( block_num );
+         if( !archived_id || *archived_id != id )
+            return fc::optional<signed_block>();
+
+         auto result = read_archived_block( block_num );
+         FC_ASSERT( result.id() == id );
+         return result;
+      }
+
+      const index_entry* e = find_entry( block_num );
+      if( !e || e->block_id != id )
+         return fc::optional<signed_block>();
+
+      auto result = read_block( *e );
+      FC_ASSERT( result.id() == e->block_id );
       return result;
    }
    catch (const fc::exception&)
@@ -158,20 +419,23 @@ fc::optional<signed_block> block_database::fetch_by_number( uint32_t block_num )
 {
    try
    {
-      index_entry e;
-      auto index_pos = sizeof(e)*block_num;
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( (size_t)_block_num_to_pos.tellg() <= index_pos )
-         return {};
-
-      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
+      if( block_num < _archive_size )
+      {
+         const block_id_type* archived_id = find_archived_id( block_num );
+         if( !archived_id )
+            return fc::optional<signed_block>();
+
+         auto result = read_archived_block( block_num );
+         FC_ASSERT( result.id() == *archived_id );
+         return result;
+      }
+
+      const index_entry* e = find_entry( block_num );
+      if( !e )
+         return fc::optional<signed_block>();
+
+      auto result = read_block( *e );
+      FC_ASSERT( result.id() == e->block_id );
       return result;
    }
    catch (const fc::exception&)
@@ -187,30 +451,14 @@ fc::optional<signed_block> block_database::last()const
 {
    try
    {
-      index_entry e;
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-
-      if( (size_t)_block_num_to_pos.tellp() < sizeof(index_entry) )
-         return fc::optional<signed_block>();
-
-      _block_num_to_pos.seekg( -sizeof(index_entry), _block_num_to_pos.end );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-      uint64_t pos = _block_num_to_pos.tellg();
-      while( e.block_size == 0 && pos > 0 )
-      {
-         pos -= sizeof(index_entry);
-         _block_num_to_pos.seekg( pos );
-         _block_num_to_pos.read( (char*)&e, sizeof(e) );
-      }
+      const index_entry* e = last_entry();
+      if( e )
+         return read_block( *e );
 
-      if( e.block_size == 0 )
+      const uint32_t last_num = last_archived_num();
+      if( last_num == 0 )
          return fc::optional<signed_block>();
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      return result;
+      return read_archived_block( last_num );
    }
    catch (const fc::exception&)
    {
@@ -223,37 +471,97 @@ fc::optional<signed_block> block_database::last()const
 
 fc::optional<block_id_type> block_database::last_id()const
 {
-   try
-   {
-      index_entry e;
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-
-      if( (size_t)_block_num_to_pos.tellp() < sizeof(index_entry) )
-         return fc::optional<block_id_type>();
+   const index_entry* e = last_entry();
+   if( e )
+      return e->block_id;
+
+   const uint32_t last_num = last_archived_num();
+   if( last_num == 0 )
+      return fc::optional<block_id_type>();
+   return _archive_ids[last_num];
+}
 
-      _block_num_to_pos.seekg( -sizeof(index_entry), _block_num_to_pos.end );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-      uint64_t pos = _block_num_to_pos.tellg();
-      while( e.block_size == 0 && pos > 0 )
+void block_database::convert( const fc::path& dbdir, uint32_t blocks_per_chunk )
+{ try {
+   FC_ASSERT( blocks_per_chunk > 0 );
+   const fc::path target_dir = dbdir / "convert";
+   fc::remove_all( target_dir );
+
+   block_database source;
+   source.open( dbdir );
+   const optional<block_id_type> last_id = source.last_id();
+   const uint32_t last_num = last_id.valid() ? block_header::num_from_id( *last_id ) : 0;
+   const uint32_t chunk_count = ( uint64_t(last_num) + 1 ) / blocks_per_chunk;
+   const uint32_t archive_size = chunk_count * blocks_per_chunk;
+
+   block_database target;
+   target.open( target_dir );
+   {
+      std::ofstream archive( target._archive_path.generic_string().c_str(),
+                             std::ofstream::binary | std::ofstream::trunc );
+      std::ofstream archive_index( target._archive_index_path.generic_string().c_str(),
+                                   std::ofstream::binary | std::ofstream::trunc );
+      archive.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+      archive_index.exceptions( std::ios_base::failbit | std::ios_base::badbit );
+
+      archive_header header;
+      header.blocks_per_chunk = blocks_per_chunk;
+      header.chunk_count = chunk_count;
+      archive_index.write( (const char*)&header, sizeof(header) );
+
+      const uint64_t ids_pos = sizeof(archive_header) + uint64_t(chunk_count) * sizeof(archive_chunk);
+      uint64_t archive_pos = 0;
+      std::vector<block_id_type> ids( blocks_per_chunk );
+      std::vector<uint32_t> offsets( uint64_t(blocks_per_chunk) + 1 );
+      std::string blocks;
+      for( uint32_t chunk_num = 0; chunk_num < chunk_count; ++chunk_num )
       {
-         pos -= sizeof(index_entry);
-         _block_num_to_pos.seekg( pos );
-         _block_num_to_pos.read( (char*)&e, sizeof(e) );
+         blocks.clear();
+         for( uint32_t i = 0; i < blocks_per_chunk; ++i )
+         {
+            const uint32_t block_num = chunk_num * blocks_per_chunk + i;
+            offsets[i] = blocks.size();
+            ids[i] = block_id_type();
+            const optional<signed_block> b = block_num > 0 ? source.fetch_by_number( block_num )
+                                                           : optional<signed_block>();
+            if( !b.valid() )
+               continue;
+            ids[i] = b->id();
+            const auto packed = fc::raw::pack( *b );
+            blocks.append( packed.data(), packed.size() );
+         }
+         offsets[blocks_per_chunk] = blocks.size();
+
+         std::string data( (const char*)offsets.data(), offsets.size() * sizeof(uint32_t) );
+         data += blocks;
+         const std::string compressed = fc::zlib_compress( data );
+         archive.write( compressed.data(), compressed.size() );
+
+         archive_chunk c;
+         c.chunk_pos = archive_pos;
+         c.chunk_size = compressed.size();
+         c.data_size = data.size();
+         archive_pos += compressed.size();
+         archive_index.seekp( sizeof(archive_header) + uint64_t(chunk_num) * sizeof(archive_chunk) );
+         archive_index.write( (const char*)&c, sizeof(c) );
+         archive_index.seekp( ids_pos + uint64_t(chunk_num) * blocks_per_chunk * sizeof(block_id_type) );
+         archive_index.write( (const char*)ids.data(), ids.size() * sizeof(block_id_type) );
       }
-
-      if( e.block_size == 0 )
-         return fc::optional<block_id_type>();
-
-      return e.block_id;
    }
-   catch (const fc::exception&)
-   {
-   }
-   catch (const std::exception&)
+
+   // blocks of the last, incomplete chunk stay uncompressed
+   for( uint32_t block_num = std::max<uint32_t>( archive_size, 1 ); block_num <= last_num; ++block_num )
    {
+      const optional<signed_block> b = source.fetch_by_number( block_num );
+      if( b.valid() )
+         target.store( b->id(), *b );
    }
-   return fc::optional<block_id_type>();
-}
+   source.close();
+   target.close();
+
+   std::ofstream( ( target_dir / "complete" ).generic_string().c_str(), std::ofstream::binary | std::ofstream::trunc );
+   finish_conversion( dbdir );
+} FC_CAPTURE_AND_RETHROW( (dbdir)(blocks_per_chunk) ) }
 
 
 } }
@@ -8,5 +8,6 @@
 #include "db_maint.cpp"
 #include "db_management.cpp"
 #include "db_market.cpp"
+#include "db_snapshot.cpp"
 #include "db_update.cpp"
 #include "db_witness_schedule.cpp"
@@ -15,6 +15,9 @@
 #include <graphene/chain/evaluator.hpp>
 #include <graphene/chain/tree.hpp>
 
+#include <fc/thread/parallel.hpp>
+#include <fc/thread/thread.hpp>
+
 namespace graphene { namespace chain {
 
 bool database::is_known_block( const block_id_type& id )const
@@ -59,6 +62,13 @@ optional<signed_block> database::fetch_block_by_number( uint32_t num )const
    // return optional<signed_block>();
 }
 
+std::vector<std::vector<char>> database::fetch_packed_blocks( uint32_t first, uint32_t count )const
+{
+   if( first == 0 || first > head_block_num() )
+      return {};
+   return _block_id_to_block.fetch_packed_range( first, std::min( count, head_block_num() - first + 1 ) );
+}
+
 const signed_transaction& database::get_recent_transaction(const transaction_id_type& trx_id) const
 {
    auto& index = get_index_type<transaction_index>().indices().get<by_trx_id>();
@@ -94,14 +104,35 @@ std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
   //idump((new_block.block_num())(new_block.id())(new_block.timestamp)(new_block.previous));
+   std::lock_guard<read_write_gate> gate( _state_gate );
+   undo_stalled_checkpointed_batch();
+   if( _checkpointed_session.valid() )
+   {
+      // the run is not undone for a block which arrives meanwhile, the block joins it if it builds on the head block
+      if( _push_checkpointed_block( new_block ) || _block_id_to_block.contains( new_block.id() ) )
+         return false;
+      // a block which builds on the chain before the run competes with it, the run is undone for it
+      GRAPHENE_ASSERT( _fork_db.is_known_block( new_block.previous ), unlinkable_block_exception,
+                       "The block neither joins the run of blocks below the checkpoint nor links to the chain before it" );
+      wlog( "Block ${n} ${id} competes with the run of checkpointed blocks, undoing the run",
+            ("n", new_block.block_num())("id", new_block.id()) );
+      undo_checkpointed_batch();
+   }
    bool result = false;
    detail::with_skip_flags( *this, skip, [&]()
       {
          detail::without_pending_transactions( *this, std::move(_pending_tx),
             [&]() {
                result = _push_block(new_block);
+               save_snapshot_if_due();
             });
       });
+   // the keys of the transactions in this block are not looked up again, the pending ones are applied again
+   std::unordered_set<digest_type> pending_digests;
+   pending_digests.reserve( _pending_tx.size() );
+   for( const pending_transaction& pending : _pending_tx )
+      pending_digests.insert( pending.trx.sig_digest( get_chain_id() ) );
+   _signature_keys.retain( pending_digests );
    return result;
 }
 
@@ -197,6 +228,116 @@ bool database::_push_block(const signed_block& new_block)
    return false;
 } FC_CAPTURE_AND_RETHROW( (new_block) ) }
 
+bool database::push_checkpointed_block( const signed_block& new_block )
+{
+   std::lock_guard<read_write_gate> gate( _state_gate );
+   return _push_checkpointed_block( new_block );
+}
+
+bool database::_push_checkpointed_block( const signed_block& new_block )
+{ try {
+   if( _checkpoints.empty() || _checkpoints.rbegin()->second == block_id_type()
+       || new_block.block_num() > _checkpoints.rbegin()->first || new_block.previous != head_block_id() )
+      return false;
+   // the undo state of a run grows until the next checkpoint confirms it, farther blocks are pushed the usual way
+   const uint32_t next_checkpoint = _checkpoints.lower_bound( new_block.block_num() )->first;
+   if( next_checkpoint - new_block.block_num() >= GRAPHENE_CHECKPOINTED_BATCH_SIZE )
+      return false;
+
+   if( !_checkpointed_session.valid() )
+   {
+      // the pending transactions are pushed again by the push_block() after the run
+      _pending_tx_session.reset();
+      for( const pending_transaction& pending : _pending_tx )
+         _popped_tx.push_back( pending.trx );
+      _pending_tx.clear();
+      _pending_tx_due = false;
+      // the blocks up to the next checkpoint share one undo state, it is dropped once their ids are confirmed there
+      _checkpointed_session = _undo_db.start_undo_session();
+   }
+
+   try
+   {
+      // apply_block() skips the checks of blocks below the last checkpoint and only compares the ids at checkpoints,
+      // so the transactions are tied to the header here
+      FC_ASSERT( new_block.transaction_merkle_root == new_block.calculate_merkle_root(),
+                 "Merkle root of a checkpointed block does not match its transactions" );
+      apply_block( new_block );
+      _block_id_to_block.store( new_block.id(), new_block );
+      _checkpointed_blocks.push_back( new_block.id() );
+      _checkpointed_block_time = fc::time_point::now();
+   }
+   catch( ... )
+   {
+      undo_checkpointed_batch();
+      throw;
+   }
+
+   if( _checkpoints.find( new_block.block_num() ) != _checkpoints.end() )
+   {
+      // the run links back from a checkpoint, its blocks are never popped and neither are the ones before them
+      _checkpointed_session->commit();
+      _checkpointed_session.reset();
+      _checkpointed_blocks.clear();
+      _undo_db.discard_history();
+      _fork_db.reset();
+      _fork_db.start_block( new_block );
+   }
+   return true;
+} FC_CAPTURE_AND_RETHROW( (new_block) ) }
+
+void database::undo_checkpointed_batch()
+{
+   if( !_checkpointed_session.valid() )
+      return;
+   _checkpointed_session->undo();
+   _checkpointed_session.reset();
+   for( auto id = _checkpointed_blocks.rbegin(); id != _checkpointed_blocks.rend(); ++id )
+      _block_id_to_block.remove( *id );
+   _checkpointed_blocks.clear();
+}
+
+void database::undo_stalled_checkpointed_batch()
+{
+   // a run which no block joins any more, e.g. because the peer sending it went away, does not hold the node up
+   if( _checkpointed_session.valid()
+       && fc::time_point::now() - _checkpointed_block_time > fc::seconds( GRAPHENE_CHECKPOINTED_BATCH_TIMEOUT_SEC ) )
+   {
+      wlog( "No block joined the run of checkpointed blocks at ${n} for a while, undoing the run",
+            ("n", head_block_num()) );
+      undo_checkpointed_batch();
+   }
+}
+
+void database::precompute_parallel( const signed_block& block, uint32_t skip )const
+{ try {
+   if( (skip & skip_transaction_signatures) || block.transactions.empty() )
+      return;
+
+   // one task per worker thread, each recovers the keys of a contiguous chunk of transactions
+   const size_t workers = std::max<size_t>( 1, fc::asio::default_io_service_scope::get_num_threads() );
+   const size_t chunk_size = ( block.transactions.size() + workers - 1 ) / workers;
+   const chain_id_type chain_id = get_chain_id();
+   std::vector<fc::future<void>> tasks;
+   tasks.reserve( workers );
+   for( size_t first = 0; first < block.transactions.size(); first += chunk_size )
+   {
+      const size_t last = std::min( first + chunk_size, block.transactions.size() );
+      tasks.push_back( fc::do_parallel( [this, &block, first, last, chain_id]() {
+         for( size_t i = first; i < last; ++i )
+            _signature_keys.recover( block.transactions[i], chain_id );
+      }) );
+   }
+   for( auto& task : tasks )
+      task.wait();
+} FC_CAPTURE_AND_RETHROW( (block.block_num())(skip) ) }
+
+void database::precompute_parallel( const signed_transaction& trx )const
+{
+   const chain_id_type chain_id = get_chain_id();
+   fc::do_parallel( [this, &trx, chain_id]() { _signature_keys.recover( trx, chain_id ); } ).wait();
+}
+
 /**
  * Attempts to push the transaction into the pending queue
  *
@@ -208,6 +349,11 @@ bool database::_push_block(const signed_block& new_block)
  */
 processed_transaction database::push_transaction( const signed_transaction& trx, uint32_t skip )
 { try {
+   std::lock_guard<read_write_gate> gate( _state_gate );
+   undo_stalled_checkpointed_batch();
+   // the blocks of the run are not undone for a transaction, it waits for the head to pass the checkpoint
+   FC_ASSERT( !_checkpointed_session.valid(), "Transactions are not taken while blocks below a checkpoint are pushed" );
+   _apply_pending_transactions();
    processed_transaction result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -230,7 +376,7 @@ processed_transaction database::_push_transaction( const signed_transaction& trx
 
    auto temp_session = _undo_db.start_undo_session();
    auto processed_trx = _apply_transaction( trx, false );
-   _pending_tx.push_back(processed_trx);
+   _pending_tx.add(processed_trx);
 
    notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
@@ -243,12 +389,84 @@ processed_transaction database::_push_transaction( const signed_transaction& trx
 
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
+   std::lock_guard<read_write_gate> gate( _state_gate );
+   undo_stalled_checkpointed_batch();
+   FC_ASSERT( !_checkpointed_session.valid(), "Transactions are not taken while blocks below a checkpoint are pushed" );
+   _apply_pending_transactions();
    auto session = _undo_db.start_undo_session();
    return _apply_transaction( trx );
 }
 
+void database::apply_pending_transactions()
+{
+   std::lock_guard<read_write_gate> gate( _state_gate );
+   _apply_pending_transactions();
+}
+
+void database::restore_pending_transactions( pending_transaction_pool& pending )
+{
+   pending_transaction_pool restored;
+   for( const signed_transaction& tx : _popped_tx )
+      restored.add( processed_transaction( tx ) );
+   _popped_tx.clear();
+   restored.append( pending );
+   _pending_tx.swap( restored );
+
+   _pending_tx_due = true;
+   // the pending transactions are checked like the block whose push made them due, even when that is deferred
+   _pending_tx_skip = get_node_properties().skip_flags;
+   if( !_defer_pending_tx )
+      _apply_pending_transactions();
+   else if( !_pending_tx_reapply.valid() || _pending_tx_reapply.ready() )
+      // whoever pushed the block passes it on before the task gets to run
+      _pending_tx_reapply = fc::async( [this]() { apply_pending_transactions(); }, "apply_pending_transactions" );
+}
+
+void database::cancel_pending_tx_reapply()
+{
+   if( _pending_tx_reapply.valid() && !_pending_tx_reapply.ready() )
+      _pending_tx_reapply.cancel_and_wait( "database closed" );
+   _pending_tx_reapply = fc::future<void>();
+}
+
+void database::_apply_pending_transactions()
+{
+   if( !_pending_tx_due )
+      return;
+   _pending_tx_due = false;
+   _pending_tx_session.reset();
+
+   pending_transaction_pool pending;
+   pending.swap( _pending_tx );
+   detail::with_skip_flags( *this, _pending_tx_skip, [&]()
+   {
+      // these would fail the expiration check
+      if( !(get_node_properties().skip_flags & skip_tapos_check) )
+         pending.remove_expired( head_block_time() );
+      for( const pending_transaction& tx : pending )
+      {
+         try
+         {
+            if( !is_known_transaction( tx.id ) ) {
+               // since push_transaction() takes a signed_transaction,
+               // the operation_results field will be ignored.
+               _push_transaction( tx.trx );
+            }
+         }
+         catch( const fc::exception& e )
+         {
+            /*
+            wlog( "Pending transaction became invalid after switching to block ${b}  ${t}", ("b", head_block_id())("t",head_block_time()) );
+            wlog( "The invalid pending transaction caused exception ${e}", ("e", e.to_detail_string() ) );
+            */
+         }
+      }
+   } );
+}
+
 processed_transaction database::push_proposal(const proposal_object& proposal)
 { try {
+   std::lock_guard<read_write_gate> gate( _state_gate );
    transaction_evaluation_state eval_state(this);
    eval_state._is_proposed_trx = true;
 
@@ -293,13 +511,17 @@ signed_block database::generate_block(
    fc::time_point_sec when,
    witness_id_type witness_id,
    const fc::ecc::private_key& block_signing_private_key,
-   uint32_t skip /* = 0 */
+   uint32_t skip, /* = 0 */
+   fc::time_point deadline /* = fc::time_point::maximum() */
    )
 { try {
+   std::lock_guard<read_write_gate> gate( _state_gate );
+   undo_stalled_checkpointed_batch();
+   FC_ASSERT( !_checkpointed_session.valid(), "Blocks are not generated while blocks below a checkpoint are pushed" );
    signed_block result;
    detail::with_skip_flags( *this, skip, [&]()
    {
-      result = _generate_block( when, witness_id, block_signing_private_key );
+      result = _generate_block( when, witness_id, block_signing_private_key, deadline );
    } );
    return result;
 } FC_CAPTURE_AND_RETHROW() }
@@ -307,9 +529,11 @@ signed_block database::generate_block(
 signed_block database::_generate_block(
    fc::time_point_sec when,
    witness_id_type witness_id,
-   const fc::ecc::private_key& block_signing_private_key)
+   const fc::ecc::private_key& block_signing_private_key,
+   fc::time_point deadline /* = fc::time_point::maximum() */)
 {
    try {
+   const auto start = std::chrono::steady_clock::now();
    uint32_t skip = get_node_properties().skip_flags;
    uint32_t slot_num = get_slot_at_time( when );
    FC_ASSERT( slot_num > 0 );
@@ -347,56 +571,65 @@ signed_block database::_generate_block(
                                                        + 3; // max space to store size of transactions (out of block header),
    // +3 means 3*7=21 bits so it's practically safe
    const size_t max_block_header_size = max_partial_block_header_size + fc::raw::pack_size( witness_id );
-   auto maximum_block_size = get_global_properties().parameters.maximum_block_size;
-   size_t total_block_size = max_block_header_size;
-
-   signed_block pending_block;
+   block_builder builder( get_global_properties().parameters.maximum_block_size, max_block_header_size );
+   block_production_stats stats;
+   stats.block_num = head_block_num() + 1;
+   stats.block_time = when;
 
    _pending_tx_session = _undo_db.start_undo_session();
 
-   uint64_t postponed_tx_count = 0;
-   for( const processed_transaction& tx : _pending_tx )
+   for( const pending_transaction& pending : _pending_tx )
    {
-      size_t new_total_size = total_block_size + fc::raw::pack_size( tx );
-
       // postpone transaction if it would make block too big
-      if( new_total_size > maximum_block_size )
+      if( !builder.fits( pending.packed_size ) )
+      {
+         stats.postponed++;
+         continue;
+      }
+
+      if( stats.deadline_reached || fc::time_point::now() >= deadline )
       {
-         postponed_tx_count++;
+         stats.deadline_reached = true;
+         stats.not_tried++;
          continue;
       }
 
+      const processed_transaction& tx = pending.trx;
       try
       {
          auto temp_session = _undo_db.start_undo_session();
          processed_transaction ptx = _apply_transaction( tx );
 
-         // We have to recompute pack_size(ptx) because it may be different
-         // than pack_size(tx) (i.e. if one or more results increased
-         // their size)
-         new_total_size = total_block_size + fc::raw::pack_size( ptx );
+         // Only the operation results may differ from the ones tx was received with (i.e. if one or more
+         // results increased their size), so only they are packed again
+         const size_t packed_size = pending.packed_size - pending.results_size
+                                    + fc::raw::pack_size( ptx.operation_results );
          // postpone transaction if it would make block too big
-         if( new_total_size > maximum_block_size )
+         if( !builder.fits( packed_size ) )
          {
-            postponed_tx_count++;
+            stats.postponed++;
             continue;
          }
 
          temp_session.merge();
 
-         total_block_size = new_total_size;
-         pending_block.transactions.push_back( ptx );
+         builder.push( std::move(ptx), packed_size );
       }
       catch ( const fc::exception& e )
       {
          // Do nothing, transaction will not be re-applied
+         stats.failed++;
          wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
          wlog( "The transaction was ${t}", ("t", tx) );
       }
    }
-   if( postponed_tx_count > 0 )
+   if( stats.postponed > 0 )
    {
-      wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
+      wlog( "Postponed ${n} transactions due to block size limit", ("n", stats.postponed) );
+   }
+   if( stats.deadline_reached )
+   {
+      wlog( "Block production deadline reached, ${n} pending transactions were not tried", ("n", stats.not_tried) );
    }
 
    _pending_tx_session.reset();
@@ -407,14 +640,21 @@ signed_block database::_generate_block(
    // However, the push_block() call below will re-create the
    // _pending_tx_session.
 
+   signed_block pending_block;
    pending_block.previous = head_block_id();
    pending_block.timestamp = when;
-   pending_block.transaction_merkle_root = pending_block.calculate_merkle_root();
    pending_block.witness = witness_id;
+   stats.transactions = builder.transactions().size();
+   stats.block_size = builder.size();
+   builder.finish( pending_block );
 
    if( !(skip & skip_witness_signature) )
       pending_block.sign( block_signing_private_key );
 
+   stats.wall_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+         std::chrono::steady_clock::now() - start ).count();
+   _last_block_production = stats;
+
    push_block( pending_block, skip | skip_transaction_signatures ); // skip authority check when pushing self-generated blocks
 
    return pending_block;
@@ -426,10 +666,14 @@ signed_block database::_generate_block(
  */
 void database::pop_block()
 { try {
+   std::lock_guard<read_write_gate> gate( _state_gate );
+   undo_stalled_checkpointed_batch();
+   FC_ASSERT( !_checkpointed_session.valid(), "The blocks of a run below a checkpoint are not popped" );
    _pending_tx_session.reset();
    auto head_id = head_block_id();
    optional<signed_block> head_block = fetch_block_by_id( head_id );
    GRAPHENE_ASSERT( head_block.valid(), pop_empty_chain, "there are no blocks to pop" );
+   FC_ASSERT( _undo_db.size() > 0, "the head block has no undo history, it cannot be popped" );
 
    _fork_db.pop_block();
    _block_id_to_block.remove( head_id );
@@ -441,8 +685,10 @@ void database::pop_block()
 
 void database::clear_pending()
 { try {
-   assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
+   std::lock_guard<read_write_gate> gate( _state_gate );
+   assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() || _pending_tx_due );
    _pending_tx.clear();
+   _pending_tx_due = false;
    _pending_tx_session.reset();
 } FC_CAPTURE_AND_RETHROW() }
 
@@ -583,8 +829,9 @@ void database::notify_changed_objects()
    if( _undo_db.enabled() ) 
    {
       const auto& head_undo = _undo_db.head();
-      vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.old_values.size());
+      vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.old_values.size() + head_undo.old_deltas.size());
       for( const auto& item : head_undo.old_values ) changed_ids.push_back(item.first);
+      for( const auto& item : head_undo.old_deltas ) changed_ids.push_back(item.first);
       for( const auto& item : head_undo.new_ids ) changed_ids.push_back(item);
       vector<const object*> removed;
       removed.reserve( head_undo.removed.size() );
@@ -616,13 +863,15 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
 
    auto& trx_idx = get_mutable_index_type<transaction_index>();
    const chain_id_type& chain_id = get_chain_id();
-   auto trx_id = trx.id();
+   // the id is only needed for the dupe check, replays skip it
+   transaction_id_type trx_id;
    if( !(skip & skip_transaction_dupe_check) )
    {
-      GRAPHENE_ASSERT( trx_idx.indices().get<by_trx_id>().find(trx.id()) == trx_idx.indices().get<by_trx_id>().end(),
+      trx_id = trx.id();
+      GRAPHENE_ASSERT( trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end(),
                        duplicate_transaction,
                        "Transaction '${txid}' is already in the database",
-                       ("txid",trx.id()) );
+                       ("txid",trx_id) );
    }
    transaction_evaluation_state eval_state(this);
    const chain_parameters& chain_parameters = get_global_properties().parameters;
@@ -632,7 +881,8 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    {
       auto get_active = [&]( account_id_type id ) { return &id(*this).active; };
       auto get_owner  = [&]( account_id_type id ) { return &id(*this).owner;  };
-      trx.verify_authority( chain_id, get_active, get_owner, get_global_properties().parameters.max_authority_depth );
+      graphene::protocol::verify_authority( trx.operations, _signature_keys.get( trx, chain_id ), get_active, get_owner,
+                                            get_global_properties().parameters.max_authority_depth );
    }
 
    //Skip all manner of expiration and TaPoS checking if we're on block 1; It's impossible that the transaction is
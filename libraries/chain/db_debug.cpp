@@ -180,6 +180,8 @@ void database::apply_debug_updates()
 
 void database::debug_update( const fc::variant_object& update )
 {
+   // readers are kept out between popping the head block and pushing it again
+   std::lock_guard<read_write_gate> gate( _state_gate );
    block_id_type head_id = head_block_id();
    auto it = _node_property_object.debug_updates.find( head_id );
    if( it == _node_property_object.debug_updates.end() )
@@ -218,7 +218,8 @@ void database::initialize_indexes()
 
    auto acnt_index = add_index<primary_index<account_index>>();
    acnt_index->add_secondary_index<account_member_index>();
-   acnt_index->add_secondary_index<account_referrer_index>();
+   auto referrer_index = acnt_index->add_secondary_index<account_referrer_index>();
+   acnt_index->add_secondary_index<referral_forest_index>( std::cref( *referrer_index ) );
 
    add_index<primary_index<restricted_account_index>>();
    add_index<primary_index<committee_member_index>>();
@@ -237,7 +238,8 @@ void database::initialize_indexes()
 
    // implementation object indexes
    add_index<primary_index<transaction_index                            >>();
-   add_index<primary_index<account_balance_index                        >>();
+   auto acnt_balance_index = add_index<primary_index<account_balance_index>>();
+   acnt_balance_index->add_secondary_index<account_holder_index>( std::cref( *this ) );
    add_index<primary_index<account_mature_balance_index                 >>();
    add_index<primary_index<bonus_balances_index                         >>();
    add_index<primary_index<asset_bitasset_data_index                    >>();
@@ -261,6 +263,12 @@ void database::initialize_indexes()
    add_index<primary_index<simple_index<fund_history_object       >>>();
    add_index<primary_index<simple_index<settings_object           >>>();
    add_index<primary_index<simple_index<witnesses_info_object     >>>();
+
+   // these hold long histories of which a change touches only a few entries
+   _undo_db.keep_deltas<account_mature_balance_object>();
+   _undo_db.keep_deltas<bonus_balances_object>();
+   _undo_db.keep_deltas<accounts_online_object>();
+   _undo_db.keep_deltas<fund_history_object>();
 }
 
 void database::init_genesis(const genesis_state_type& genesis_state)
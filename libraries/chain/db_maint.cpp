@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <functional>
+#include <thread>
 
 #include <fc/uint128.hpp>
 
@@ -724,6 +725,7 @@ void deprecate_annual_members( database& db )
 void database::perform_chain_maintenance(const signed_block& next_block, const global_property_object& global_props)
 {
    std::chrono::steady_clock::time_point mt_time_begin = std::chrono::steady_clock::now();
+   _maintenance_profiler.begin( next_block.block_num(), next_block.timestamp );
 
    const auto& gpo = get_global_properties();
    start_notify_block_num = head_block_num() + 8;
@@ -733,67 +735,96 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
    struct vote_tally_helper {
       database& d;
       const global_property_object& props;
-
-      vote_tally_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo)
+      const time_point_sec now;
+      vector<uint64_t>& vote_tally;
+      vector<uint64_t>& witness_histogram;
+      vector<uint64_t>& committee_histogram;
+      uint64_t& total_voting_stake;
+
+      vote_tally_helper(database& d, const global_property_object& gpo,
+                        vector<uint64_t>& vote_tally, vector<uint64_t>& witness_histogram,
+                        vector<uint64_t>& committee_histogram, uint64_t& total_voting_stake)
+         : d(d), props(gpo), now(d.head_block_time()), vote_tally(vote_tally),
+           witness_histogram(witness_histogram), committee_histogram(committee_histogram),
+           total_voting_stake(total_voting_stake)
       {
-         d._vote_tally_buffer.resize(props.next_available_vote_id);
-         d._witness_count_histogram_buffer.resize(props.parameters.maximum_witness_count / 2 + 1);
-         d._committee_count_histogram_buffer.resize(props.parameters.maximum_committee_count / 2 + 1);
-         d._total_voting_stake = 0;
+         vote_tally.resize(props.next_available_vote_id);
+         witness_histogram.resize(props.parameters.maximum_witness_count / 2 + 1);
+         committee_histogram.resize(props.parameters.maximum_committee_count / 2 + 1);
+         total_voting_stake = 0;
       }
 
-      void operator()(const account_object& stake_account) {
-         if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
-         {
-            // There may be a difference between the account whose stake is voting and the one specifying opinions.
-            // Usually they're the same, but if the stake account has specified a voting_account, that account is the one
-            // specifying the opinions.
-            const account_object& opinion_account =
-                  (stake_account.options.voting_account ==
-                   GRAPHENE_PROXY_TO_SELF_ACCOUNT)? stake_account
-                                     : d.get(stake_account.options.voting_account);
-
-            const auto& stats = stake_account.statistics(d);
-            uint64_t voting_stake = stats.total_core_in_orders.value
-                  + (stake_account.cashback_vb.valid() ? (*stake_account.cashback_vb)(d).balance.amount.value: 0)
-                  + d.get_balance(stake_account.get_id(), asset_id_type()).amount.value;
-
-            for( vote_id_type id : opinion_account.options.votes )
-            {
-               uint32_t offset = id.instance();
-               // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake;
-            }
+      bool is_voting(const account_object& stake_account) const {
+         return props.parameters.count_non_member_votes || stake_account.is_member(now);
+      }
 
-            if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
-                                          d._witness_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_witness_count
-               // are turned into votes for maximum_witness_count.
-               //
-               // in particular, this takes care of the case where a
-               // member was voting for a high number, then the
-               // parameter was lowered.
-               d._witness_count_histogram_buffer[offset] += voting_stake;
-            }
-            if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
-                                          d._committee_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_committee_count
-               // are turned into votes for maximum_committee_count.
-               //
-               // same rationale as for witnesses
-               d._committee_count_histogram_buffer[offset] += voting_stake;
-            }
+      // There may be a difference between the account whose stake is voting and the one specifying opinions.
+      // Usually they're the same, but if the stake account has specified a voting_account, that account is the one
+      // specifying the opinions.
+      const account_object& opinion_account(const account_object& stake_account) const {
+         return (stake_account.options.voting_account ==
+                 GRAPHENE_PROXY_TO_SELF_ACCOUNT)? stake_account
+                                   : d.get(stake_account.options.voting_account);
+      }
+
+      uint64_t cashback_stake(const account_object& stake_account) const {
+         return stake_account.cashback_vb.valid() ? (*stake_account.cashback_vb)(d).balance.amount.value : 0;
+      }
 
-            d._total_voting_stake += voting_stake;
+      // All buffers are summed modulo 2^64, so stake can also be a (wrapped) correction to an earlier tally.
+      void add_stake(const account_object& opinion_account, uint64_t voting_stake) {
+         for( vote_id_type id : opinion_account.options.votes )
+         {
+            uint32_t offset = id.instance();
+            // if they somehow managed to specify an illegal offset, ignore it.
+            if( offset < vote_tally.size() )
+               vote_tally[offset] += voting_stake;
+         }
+
+         if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
+         {
+            uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
+                                       witness_histogram.size() - 1);
+            // votes for a number greater than maximum_witness_count
+            // are turned into votes for maximum_witness_count.
+            //
+            // in particular, this takes care of the case where a
+            // member was voting for a high number, then the
+            // parameter was lowered.
+            witness_histogram[offset] += voting_stake;
          }
+         if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
+         {
+            uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
+                                       committee_histogram.size() - 1);
+            // votes for a number greater than maximum_committee_count
+            // are turned into votes for maximum_committee_count.
+            //
+            // same rationale as for witnesses
+            committee_histogram[offset] += voting_stake;
+         }
+
+         total_voting_stake += voting_stake;
+      }
+
+      /// Tallies stake_account and returns the cashback part of its stake, as seen by this tally
+      uint64_t tally(const account_object& stake_account) {
+         if( !is_voting(stake_account) )
+            return 0;
+         const auto& stats = stake_account.statistics(d);
+         uint64_t cashback = cashback_stake(stake_account);
+         uint64_t voting_stake = stats.total_core_in_orders.value
+               + cashback
+               + d.get_balance(stake_account.get_id(), asset_id_type()).amount.value;
+         add_stake(opinion_account(stake_account), voting_stake);
+         return cashback;
       }
-   } tally_helper(*this, gpo);
+
+      void operator()(const account_object& stake_account) {
+         tally(stake_account);
+      }
+   } tally_helper(*this, gpo, _vote_tally_buffer, _witness_count_histogram_buffer,
+                  _committee_count_histogram_buffer, _total_voting_stake);
    struct process_fees_helper {
       database& d;
       const global_property_object& props;
@@ -806,10 +837,81 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
       }
    } fee_helper(*this, gpo);
 
-   perform_account_maintenance(std::tie(
-      tally_helper,
-      fee_helper
-      ));
+   {
+      maintenance_profiler::scoped_phase phase( _maintenance_profiler, "vote_tally" );
+      if( _maintenance_tally_threads <= 1 )
+      {
+         perform_account_maintenance(std::tie(
+            tally_helper,
+            fee_helper
+            ));
+      }
+      else
+      {
+         // perform_account_maintenance tallies each account right before paying out its fees, in name order.
+         // Paying out fees only ever changes cashback balances, so the stakes are tallied in parallel on
+         // the state before any fees are paid, and the cashback of an account is corrected afterwards
+         // if fees paid out to it earlier in the serial order changed it. All sums are taken modulo 2^64,
+         // so the result is identical to the serial loop.
+         const auto& accounts = get_index_type<account_index>().indices().get<by_id>();
+         const uint64_t end_instance = accounts.empty() ? 0 : accounts.rbegin()->id.instance() + 1;
+         const uint64_t num_threads = std::min<uint64_t>(_maintenance_tally_threads, std::max<uint64_t>(end_instance, 1));
+         const uint64_t chunk = (end_instance + num_threads - 1) / num_threads;
+
+         vector<uint64_t> tallied_cashback(end_instance);
+         vector<vector<uint64_t>> vote_tallies(num_threads), witness_histograms(num_threads), committee_histograms(num_threads);
+         vector<uint64_t> voting_stakes(num_threads);
+         vector<std::exception_ptr> errors(num_threads);
+         vector<std::thread> workers;
+         workers.reserve(num_threads);
+         for( uint64_t t = 0; t < num_threads; ++t )
+         {
+            workers.emplace_back([&, t]() {
+               try {
+                  vote_tally_helper worker_tally(*this, gpo, vote_tallies[t], witness_histograms[t],
+                                                 committee_histograms[t], voting_stakes[t]);
+                  const uint64_t last = std::min(end_instance, (t + 1) * chunk);
+                  for( auto itr = accounts.lower_bound(account_id_type(t * chunk));
+                       itr != accounts.end() && itr->id.instance() < last; ++itr )
+                     tallied_cashback[itr->id.instance()] = worker_tally.tally(*itr);
+               } catch( ... ) {
+                  errors[t] = std::current_exception();
+               }
+            });
+         }
+         for( std::thread& w : workers )
+            w.join();
+         for( const std::exception_ptr& e : errors )
+            if( e )
+               std::rethrow_exception(e);
+
+         for( uint64_t t = 0; t < num_threads; ++t )
+         {
+            for( size_t i = 0; i < _vote_tally_buffer.size(); ++i )
+               _vote_tally_buffer[i] += vote_tallies[t][i];
+            for( size_t i = 0; i < _witness_count_histogram_buffer.size(); ++i )
+               _witness_count_histogram_buffer[i] += witness_histograms[t][i];
+            for( size_t i = 0; i < _committee_count_histogram_buffer.size(); ++i )
+               _committee_count_histogram_buffer[i] += committee_histograms[t][i];
+            _total_voting_stake += voting_stakes[t];
+         }
+
+         bool fees_paid = false;
+         for( const account_object& a : get_index_type<account_index>().indices().get<by_name>() )
+         {
+            if( fees_paid && tally_helper.is_voting(a) )
+            {
+               uint64_t cashback = tally_helper.cashback_stake(a);
+               uint64_t tallied = tallied_cashback[a.id.instance()];
+               if( cashback != tallied )
+                  tally_helper.add_stake(tally_helper.opinion_account(a), cashback - tallied);
+            }
+            const auto& stats = a.statistics(*this);
+            fees_paid = fees_paid || stats.pending_fees > 0 || stats.pending_vested_fees > 0;
+            fee_helper(a);
+         }
+      }
+   }
 
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
@@ -821,10 +923,13 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                 b(_committee_count_histogram_buffer),
                 c(_vote_tally_buffer);
 
-   update_top_n_authorities(*this);
-   update_active_witnesses();
-   update_active_committee_members();
-   update_worker_votes();
+   {
+      maintenance_profiler::scoped_phase phase( _maintenance_profiler, "update_votes" );
+      update_top_n_authorities(*this);
+      update_active_witnesses();
+      update_active_committee_members();
+      update_worker_votes();
+   }
 
    modify(gpo, [this](global_property_object& p) {
       // Remove scaling of account registration fee
@@ -888,7 +993,10 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
 
    // process_budget needs to run at the bottom because
    //   it needs to know the next_maintenance_time
-   process_budget();
+   {
+      maintenance_profiler::scoped_phase phase( _maintenance_profiler, "process_budget" );
+      process_budget();
+   }
 
    std::ostringstream os;
    os << "[maintenance time: " << std::string(fc::time_point::now())
@@ -910,28 +1018,14 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
 
    if (head_block_time() > HARDFORK_637_TIME)
    {
-#ifdef DEBUG_TIMES
-      auto start = std::chrono::high_resolution_clock::now();
-#endif
+      maintenance_profiler::scoped_phase phase( _maintenance_profiler, "form_referral_map" );
       form_referral_map();
-#ifdef DEBUG_TIMES
-      auto stop = std::chrono::high_resolution_clock::now();
-      auto duration = std::chrono::duration_cast<std::chrono::seconds>(stop - start);
-      std::cout << "form_referral_map(): " << duration.count() << " seconds" << std::endl;
-#endif
    }
 
    if (head_block_time() > HARDFORK_627_TIME)
    {
-#ifdef DEBUG_TIMES
-      auto start = std::chrono::high_resolution_clock::now();
-#endif
+      maintenance_profiler::scoped_phase phase( _maintenance_profiler, "process_accounts" );
       process_accounts();
-#ifdef DEBUG_TIMES
-      auto stop = std::chrono::high_resolution_clock::now();
-      auto duration = std::chrono::duration_cast<std::chrono::seconds>(stop - start);
-      std::cout << "process_accounts(): " << duration.count() << " seconds" << std::endl;
-#endif
    }
 
    if (head_block_time() > HARDFORK_622_TIME)
@@ -949,42 +1043,21 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
       }
 
       {
-#ifdef DEBUG_TIMES
-         auto start = std::chrono::high_resolution_clock::now();
-#endif
+         maintenance_profiler::scoped_phase phase( _maintenance_profiler, "process_funds" );
          process_funds();
-#ifdef DEBUG_TIMES
-         auto stop = std::chrono::high_resolution_clock::now();
-         auto duration = std::chrono::duration_cast<std::chrono::seconds>(stop - start);
-         std::cout << "process_funds(): " << duration.count() << " seconds" << std::endl;
-#endif
       }
 
       {
-#ifdef DEBUG_TIMES
-         auto start = std::chrono::high_resolution_clock::now();
-#endif
+         maintenance_profiler::scoped_phase phase( _maintenance_profiler, "process_cheques" );
          process_cheques();
-#ifdef DEBUG_TIMES
-         auto stop = std::chrono::high_resolution_clock::now();
-         auto duration = std::chrono::duration_cast<std::chrono::seconds>(stop - start);
-         std::cout << "process_cheques(): " << duration.count() << " seconds" << std::endl;
-#endif
       }
    }
 
    if (head_block_time() > HARDFORK_620_TIME)
    {
       // for all assets except EDC (because backend doesn't have maturity functional for EDC)
-#ifdef DEBUG_TIMES
-      auto start = std::chrono::high_resolution_clock::now();
-#endif
+      maintenance_profiler::scoped_phase phase( _maintenance_profiler, "issue_bonuses" );
       issue_bonuses();
-#ifdef DEBUG_TIMES
-      auto stop = std::chrono::high_resolution_clock::now();
-      auto duration = std::chrono::duration_cast<std::chrono::seconds>(stop - start);
-      std::cout << "issue_bonuses(): " << duration.count() << " seconds" << std::endl;
-#endif
    } else if (head_block_time() > HARDFORK_617_TIME) {
       issue_bonuses_before_620();
    } else if (head_block_time() > HARDFORK_616_TIME) {
@@ -994,16 +1067,9 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
    // make fee-payments to witnesses
    if (head_block_time() > HARDFORK_633_TIME)
    {
-#ifdef DEBUG_TIMES
-      auto start = std::chrono::high_resolution_clock::now();
-#endif
+      maintenance_profiler::scoped_phase phase( _maintenance_profiler, "make_witness_payments" );
       make_witness_payments();
       process_witnesses();
-#ifdef DEBUG_TIMES
-      auto stop = std::chrono::high_resolution_clock::now();
-      auto duration = std::chrono::duration_cast<std::chrono::seconds>(stop - start);
-      std::cout << "make_witness_payments() & process_witnesses(): " << duration.count() << " seconds" << std::endl;
-#endif
    }
 
    if (settings.make_denominate && (head_block_time() > HARDFORK_635_TIME))
@@ -1014,15 +1080,8 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
    }
 
    {
-#ifdef DEBUG_TIMES
-      auto start = std::chrono::high_resolution_clock::now();
-#endif
+      maintenance_profiler::scoped_phase phase( _maintenance_profiler, "clear_old_entities" );
       clear_old_entities();
-#ifdef DEBUG_TIMES
-      auto stop = std::chrono::high_resolution_clock::now();
-      auto duration = std::chrono::duration_cast<std::chrono::seconds>(stop - start);
-      std::cout << "clear_old_entities(): " << duration.count() << " seconds" << std::endl;
-#endif
    }
 
    std::chrono::steady_clock::time_point mt_time_end = std::chrono::steady_clock::now();
@@ -1035,6 +1094,19 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
        || (replay_in_process() && mt_times_file_created()) ) {
       mt_times_add(mt_elapsed_time);
    }
+
+   _maintenance_profiler.end();
+   if( _maintenance_profile_file.valid() )
+   {
+      // the profile is for the operator, failing to write it must not fail the block
+      try {
+         _maintenance_profiler.save( *_maintenance_profile_file );
+      } catch( const fc::exception& e ) {
+         wlog( "Unable to write the maintenance profile to ${f}: ${e}", ("f", *_maintenance_profile_file)("e", e.to_detail_string()) );
+      } catch( const std::exception& e ) {
+         wlog( "Unable to write the maintenance profile to ${f}: ${e}", ("f", *_maintenance_profile_file)("e", e.what()) );
+      }
+   }
 }
 
 void database::clear_old_entities()
@@ -1090,12 +1162,10 @@ void database::clear_old_entities()
       fc::time_point tp = head_block_time() - fc::days(30);
 
       std::vector<fund_deposit_id_type> to_remove;
-      const auto& idx_deposits = get_index_type<fund_deposit_index>().indices().get<by_id>();
-      for (const fund_deposit_object& obj: idx_deposits)
-      {
-         if ((obj.datetime_end < tp) && obj.finished) {
-            to_remove.push_back(obj.get_id());
-         }
+      const auto& idx_deposits = get_index_type<fund_deposit_index>().indices().get<by_finished_end>();
+      auto end = idx_deposits.lower_bound(boost::make_tuple(true, fc::time_point_sec(tp)));
+      for (auto itr = idx_deposits.lower_bound(boost::make_tuple(true)); itr != end; ++itr) {
+         to_remove.push_back(itr->get_id());
       }
 
       for (const fund_deposit_id_type& obj_id: to_remove)
@@ -1121,70 +1191,56 @@ void database::form_referral_map()
    const settings_object& settings = *find(settings_id_type(0));
    if (!settings.referral_payments_enabled) { return; }
 
-   tree<leaf_info2>::iterator root = referral_tree_v2.insert(referral_tree_v2.begin(), leaf_info2{});
-
-   std::function<tree<leaf_info2>::iterator(
-      tree<leaf_info2>::iterator
-      , const account_object&
-      , const account_multi_index_type::index<by_id>::type&
-      , std::unordered_map<account_id_type, tree<leaf_info2>::iterator>&
-      , tree<leaf_info2>&)> create_leaf = [&](
-         tree<leaf_info2>::iterator root
-         , const account_object& acc
-         , const account_multi_index_type::index<by_id>::type& idx
-         , std::unordered_map<account_id_type, tree<leaf_info2>::iterator>& ref_map
-         , tree<leaf_info2>& ref_tree)
+   const auto& aidx = dynamic_cast<const primary_index<account_index>&>(get_index_type<account_index>());
+   referral_forest_v2.reset(aidx.get_next_id().instance());
+
+   if (head_block_time() >= HARDFORK_638_TIME)
    {
-      tree<leaf_info2>::iterator referrer = root;
+      // the forest is kept in the order the scan below would create the leaves,
+      // together with the deposit sums process_referrals() used to accumulate
+      const auto& forest = aidx.get_secondary_index<referral_forest_index>();
 
-      auto referrer_from_map = referral_map_v2.find(acc.referrer);
-      if (referrer_from_map == referral_map_v2.end())
+      forest.for_each_preorder([&](const referral_forest_index::node& n, const referral_forest_index::node* parent)
       {
-         auto itr = idx.find(acc.referrer);
-         if (itr != idx.end())
+         const uint32_t referrer = parent ? referral_forest_v2.find(parent->account->get_id()) : 0;
+         const uint32_t node = referral_forest_v2.add(referrer, *n.account);
+         referral_forest_v2.active_deposits_sum[node] = n.active_deposits_sum;
+         referral_forest_v2.active_deposits_count_sum[node] = n.active_deposits_count_sum;
+      });
+   }
+   else
+   {
+      const account_multi_index_type::index<by_id>::type& idx = get_index_type<account_index>().indices().get<by_id>();
+
+      std::function<uint32_t(const account_object&)> create_leaf = [&](const account_object& acc)
+      {
+         uint32_t referrer = referral_forest_v2.find(acc.referrer);
+         if (referrer == flat_referral_forest::npos)
          {
-            const account_object& ref_acc = *itr;
-            if (acc.referrer != ref_acc.referrer) {
-               referrer = create_leaf(root, ref_acc, idx, ref_map, ref_tree);
+            referrer = 0;
+            auto itr = idx.find(acc.referrer);
+            if (itr != idx.end())
+            {
+               const account_object& ref_acc = *itr;
+               if (acc.referrer != ref_acc.referrer) {
+                  referrer = create_leaf(ref_acc);
+               }
             }
          }
-      }
-      else {
-         referrer = referrer_from_map->second;
-      }
-
-      leaf_info2 leaf;
-      leaf.account_id = acc.get_id();
-      leaf.referral_payments_enabled = acc.referral_payments_enabled;
-      leaf.name = acc.name;
-      leaf.daily_deposits = acc.edc_in_deposits_daily;
-      leaf.active_deposits = acc.edc_in_deposits;
-      leaf.active_deposits_count = acc.edc_active_deposits_count;
-      leaf.nearest_return_datetime = acc.edc_deposit_nearest_dt;
+         return referral_forest_v2.add(referrer, acc);
+      };
 
-      auto account_pos = referral_tree_v2.append_child(referrer, std::move(leaf));
-      referral_map_v2.emplace(acc.get_id(), account_pos);
-
-      return account_pos;
-   };
-
-   const account_multi_index_type::index<by_id>::type& idx = get_index_type<account_index>().indices().get<by_id>();
-   for (auto itr = ++idx.begin(); itr != idx.end(); ++itr)
-   {
-      const account_object& acc = *itr;
-      if (acc.is_market_account) { continue; }
-
-      if (head_block_time() >= HARDFORK_638_TIME)
+      for (auto itr = ++idx.begin(); itr != idx.end(); ++itr)
       {
-         if (referral_map_v2.find(acc.get_id()) == referral_map_v2.end()) {
-            create_leaf(root, acc, idx, referral_map_v2, referral_tree_v2);
-         }
-      }
-      else {
-         create_leaf(root, acc, idx, referral_map_v2, referral_tree_v2);
+         const account_object& acc = *itr;
+         if (acc.is_market_account) { continue; }
+
+         create_leaf(acc);
       }
    }
 
+   referral_forest_v2.finish();
+
    process_referrals(settings);
 
    // new referral payments
@@ -1195,158 +1251,88 @@ void database::form_referral_map()
 
 void database::process_referral_payments_new(const settings_object& settings)
 {
-   for (tree<leaf_info2>::iterator tree_item = referral_tree_v2.begin();
-        tree_item != referral_tree_v2.end(); ++tree_item)
+   flat_referral_forest& forest = referral_forest_v2;
+   const uint32_t percents[3] = { settings.referral_level1_percent, settings.referral_level2_percent, settings.referral_level3_percent };
+
+   for (uint32_t node = 0; node < forest.size(); ++node)
    {
-      tree<leaf_info2>::iterator current_node = tree_item;
-      leaf_info2& current_account = *current_node;
+      const share_type daily_deposits = forest.daily_deposits[node];
+      if (daily_deposits <= 0) { continue; }
 
-      if (current_account.daily_deposits > 0)
+      uint32_t parent = forest.parent[node];
+      for (int level = 1; (level <= 3) && forest.is_referrer(parent); ++level)
       {
-         auto current_parent_node = referral_tree_v2.parent(current_node);
-         for (int level = 1;; ++level)
-         {
-            if ((current_parent_node == nullptr) || (current_parent_node->account_id == GRAPHENE_COMMITTEE_ACCOUNT) || (level > 3)) { break; }
-            leaf_info2& current_parent = *current_parent_node;
-
-            if (current_parent.level >= level)
-            {
-               if (level == 1)
-               {
-                  const share_type& amnt = std::round(current_account.daily_deposits.value * get_percent(settings.referral_level1_percent));
-                  if (amnt > 0) {
-                     current_parent.level1_payment += amnt;
-                  }
-               }
-               else if (level == 2)
-               {
-                  const share_type& amnt = std::round(current_account.daily_deposits.value * get_percent(settings.referral_level2_percent));
-                  if (amnt > 0) {
-                     current_parent.level2_payment += amnt;
-                  }
-               }
-               else if (level == 3)
-               {
-                  const share_type& amnt = std::round(current_account.daily_deposits.value * get_percent(settings.referral_level3_percent));
-                  if (amnt > 0) {
-                     current_parent.level3_payment += amnt;
-                  }
-               }
-            }
-            else { break; }
+         if (forest.level[parent] < level) { break; }
 
-            current_parent_node = referral_tree_v2.parent(current_parent_node);
+         const share_type& amnt = std::round(daily_deposits.value * get_percent(percents[level - 1]));
+         if (amnt > 0) {
+            forest.level_payment[level - 1][parent] += amnt;
          }
+
+         parent = forest.parent[parent];
       }
    }
 }
 
 void database::process_referrals(const settings_object& settings)
 {
-   for (tree<leaf_info2>::iterator tree_item = referral_tree_v2.begin();
-        tree_item != referral_tree_v2.end(); ++tree_item)
+   flat_referral_forest& forest = referral_forest_v2;
+   const fc::time_point_sec now = head_block_time();
+   const std::pair<share_type, share_type>* min_limits[3] = {
+      &settings.referral_min_limit_edc_level1, &settings.referral_min_limit_edc_level2, &settings.referral_min_limit_edc_level3 };
+   const uint32_t percents[3] = { settings.referral_level1_percent, settings.referral_level2_percent, settings.referral_level3_percent };
+
+   // the nodes are visited in pre-order and the levels found so far decide the next ones, so the order is kept
+   for (uint32_t node = 0; node < forest.size(); ++node)
    {
-      int level = 0;
-      for (tree<leaf_info2>::iterator current_node = tree_item;; ++level)
+      uint32_t current = node;
+      for (uint16_t level = 0; level < 3; ++level)
       {
-         auto parent_node = referral_tree_v2.parent(current_node);
-         if ((parent_node == nullptr) || (parent_node->account_id == GRAPHENE_COMMITTEE_ACCOUNT) || (level > 2)) { break; }
-
-         leaf_info2& current_account = *current_node;
-         leaf_info2& parent_account = *parent_node;
+         const uint32_t parent = forest.parent[current];
+         if (!forest.is_referrer(parent)) { break; }
 
-         parent_account.active_deposits_sum += current_account.active_deposits;
-         parent_account.active_deposits_count_sum += current_account.active_deposits_count;
-
-         if (current_account.nearest_return_datetime >= head_block_time())
+         // since HARDFORK_638 the sums come from referral_forest_index
+         if (now < HARDFORK_638_TIME)
          {
-            if ( (parent_account.nearest_return_datetime.sec_since_epoch() == 0)
-                 || (parent_account.nearest_return_datetime < head_block_time())
-                 || (parent_account.nearest_return_datetime.sec_since_epoch() > current_account.nearest_return_datetime.sec_since_epoch()) ) {
-               parent_account.nearest_return_datetime = current_account.nearest_return_datetime;
-            }
+            forest.active_deposits_sum[parent] += forest.active_deposits[current];
+            forest.active_deposits_count_sum[parent] += forest.active_deposits_count[current];
          }
 
-         // level 1
-         if (level == 0)
+         const fc::time_point_sec current_return = forest.nearest_return_datetime[current];
+         fc::time_point_sec& parent_return = forest.nearest_return_datetime[parent];
+         if (current_return >= now)
          {
-            if ( (current_account.level == level)
-                 && (current_account.active_deposits >= settings.referral_min_limit_edc_level1.second)
-                 && (parent_account.active_deposits >= settings.referral_min_limit_edc_level1.first) )
-            {
-               ++parent_account.level1_valid_referrals_count;
-               if (parent_account.level1_valid_referrals_count == 3)
-               {
-                  if (head_block_time() >= HARDFORK_638_TIME) {
-                     if (parent_account.level < 1)  { parent_account.level = 1; }
-                  }
-                  else {
-                     parent_account.level = 1;
-                  }
-               }
-            }
-            if ((head_block_time() < HARDFORK_640_TIME) && (current_account.daily_deposits > 0))
-            {
-               const share_type& amnt = std::round(current_account.daily_deposits.value * get_percent(settings.referral_level1_percent));
-               if (amnt > 0) {
-                  parent_account.level1_payment += amnt;
-               }
+            if ( (parent_return.sec_since_epoch() == 0)
+                 || (parent_return < now)
+                 || (parent_return.sec_since_epoch() > current_return.sec_since_epoch()) ) {
+               parent_return = current_return;
             }
          }
-         // level 2
-         else if (level == 1)
+
+         // level 1 to 3
+         if ( (forest.level[current] == level)
+              && (forest.active_deposits[current] >= min_limits[level]->second)
+              && (forest.active_deposits[parent] >= min_limits[level]->first) )
          {
-            if ( (current_account.level == level)
-                 && (current_account.active_deposits >= settings.referral_min_limit_edc_level2.second)
-                 && (parent_account.active_deposits >= settings.referral_min_limit_edc_level2.first) )
+            if (++forest.level_valid_referrals_count[level][parent] == 3)
             {
-               ++parent_account.level2_valid_referrals_count;
-               if (parent_account.level2_valid_referrals_count == 3)
-               {
-                  if (head_block_time() >= HARDFORK_638_TIME) {
-                     if (parent_account.level < 2)  { parent_account.level = 2; }
-                  }
-                  else {
-                     parent_account.level = 2;
-                  }
+               if (now >= HARDFORK_638_TIME) {
+                  if (forest.level[parent] < level + 1)  { forest.level[parent] = level + 1; }
                }
-            }
-            if ((head_block_time() < HARDFORK_640_TIME) && (current_account.daily_deposits > 0))
-            {
-               const share_type& amnt = std::round(current_account.daily_deposits.value * get_percent(settings.referral_level2_percent));
-               if (amnt > 0) {
-                  parent_account.level2_payment += amnt;
+               else {
+                  forest.level[parent] = level + 1;
                }
             }
          }
-         // level 3
-         else if (level == 2)
+         if ((now < HARDFORK_640_TIME) && (forest.daily_deposits[current] > 0))
          {
-            if ( (current_account.level == level)
-                 && (current_account.active_deposits >= settings.referral_min_limit_edc_level3.second)
-                 && (parent_account.active_deposits >= settings.referral_min_limit_edc_level3.first) )
-            {
-               ++parent_account.level3_valid_referrals_count;
-               if (parent_account.level3_valid_referrals_count == 3)
-               {
-                  if (head_block_time() >= HARDFORK_638_TIME) {
-                     if (parent_account.level < 3)  { parent_account.level = 3; }
-                  }
-                  else {
-                     parent_account.level = 3;
-                  }
-               }
-            }
-            if ((head_block_time() < HARDFORK_640_TIME) && (current_account.daily_deposits > 0))
-            {
-               const share_type& amnt = std::round(current_account.daily_deposits.value * get_percent(settings.referral_level3_percent));
-               if (amnt > 0) {
-                  parent_account.level3_payment += amnt;
-               }
+            const share_type& amnt = std::round(forest.daily_deposits[current].value * get_percent(percents[level]));
+            if (amnt > 0) {
+               forest.level_payment[level][parent] += amnt;
             }
          }
 
-         current_node = parent_node;
+         current = parent;
       }
    }
 }
@@ -1394,21 +1380,19 @@ void database::process_accounts()
       share_type amnt = 0;
       if (head_block_time() > HARDFORK_637_TIME)
       {
-         auto idx = referral_map_v2.find(acc_obj.get_id());
-         if (idx != referral_map_v2.end())
+         const flat_referral_forest& forest = referral_forest_v2;
+         const uint32_t node = forest.find(acc_obj.get_id());
+         if (node != flat_referral_forest::npos)
          {
-            const leaf_info2& acc_from_map = *idx->second;
+            const uint16_t level = forest.level[node];
 
-            if ( (acc_from_map.level > 0) && acc_from_map.referral_payments_enabled)
+            if ( (level > 0) && forest.referral_payments_enabled[node])
             {
-               if (acc_from_map.level1_payment > 0) {
-                  amnt += acc_from_map.level1_payment;
-               }
-               if ((acc_from_map.level > 1) && (acc_from_map.level2_payment > 0)) {
-                  amnt += acc_from_map.level2_payment;
-               }
-               if ((acc_from_map.level > 2) && (acc_from_map.level3_payment > 0)) {
-                  amnt += acc_from_map.level3_payment;
+               for (uint16_t l = 0; l < level && l < 3; ++l)
+               {
+                  if (forest.level_payment[l][node] > 0) {
+                     amnt += forest.level_payment[l][node];
+                  }
                }
                amnt = check_supply_overflow(asset(amnt, EDC_ASSET)).amount;
                if (amnt > 0)
@@ -1419,7 +1403,7 @@ void database::process_accounts()
                      asset_issue_operation op;
                      op.issuer = edc_asset.issuer;
                      op.asset_to_issue = asset(amnt, EDC_ASSET);
-                     op.issue_to_account = acc_from_map.account_id;
+                     op.issue_to_account = forest.account[node];
                      op.extensions.insert(e_asset_issue_type::_referral_payment);
                      transaction_evaluation_state eval(this);
                      apply_operation(eval, op);
@@ -1427,11 +1411,11 @@ void database::process_accounts()
                }
             }
 
-            referral_level = acc_from_map.level;
-            referral_group_edc_turnover = acc_obj.edc_in_deposits + acc_from_map.active_deposits_sum;
+            referral_level = level;
+            referral_group_edc_turnover = acc_obj.edc_in_deposits + forest.active_deposits_sum[node];
             referral_edc_payments_from_partners = amnt;
-            referral_deposits_count = acc_obj.edc_active_deposits_count + acc_from_map.active_deposits_count_sum;
-            referral_nearest_return_datetime = acc_from_map.nearest_return_datetime;
+            referral_deposits_count = acc_obj.edc_active_deposits_count + forest.active_deposits_count_sum[node];
+            referral_nearest_return_datetime = forest.nearest_return_datetime[node];
          }
       }
 
@@ -1480,8 +1464,7 @@ void database::process_accounts()
 
    if (head_block_time() > HARDFORK_637_TIME)
    {
-      referral_tree_v2.clear();
-      referral_map_v2.clear();
+      referral_forest_v2.clear();
    }
 
    if ((supply_reducer > 0) && (head_block_time() > HARDFORK_635_TIME))
@@ -1498,9 +1481,17 @@ void database::process_funds()
    const dynamic_global_property_object& dpo = get_dynamic_global_properties();
    const global_property_object& gpo = get_global_properties();
 
-   const auto& idx_funds = get_index_type<fund_index>().indices().get<by_id>();
-   for (const fund_object& fund_obj: idx_funds)
+   // disabled funds are never processed, and finishing a fund disables it, so collect the enabled ones first
+   const auto& idx_funds = get_index_type<fund_index>().indices().get<by_enabled>();
+   std::vector<fund_id_type> enabled_funds;
+   for (auto itr = idx_funds.lower_bound(boost::make_tuple(true)); itr != idx_funds.end(); ++itr) {
+      enabled_funds.push_back(itr->get_id());
+   }
+
+   for (const fund_id_type& fund_id: enabled_funds)
    {
+      const fund_object& fund_obj = fund_id(*this);
+
       // fund is already finished
       if ( (head_block_time() >= HARDFORK_642_TIME) && !fund_obj.enabled) { continue; }
       else if (head_block_time() < HARDFORK_642_TIME) {
@@ -1520,19 +1511,44 @@ void database::process_cheques()
 {
    const dynamic_global_property_object& dpo = get_dynamic_global_properties();
    const global_property_object& gpo = get_global_properties();
-   const auto& idx_cheques = get_index_type<cheque_index>().indices().get<by_id>();
+   const auto& idx_cheques = get_index_type<cheque_index>().indices().get<by_status_expiration>();
    transaction_evaluation_state eval(this);
 
+   const fc::time_point_sec maint_time = dpo.next_maintenance_time - gpo.parameters.maintenance_interval;
+   fc::time_point_sec history_time = fc::time_point_sec::min();
+   if (get_history_size() > 0)
+   {
+      const time_point& tp = head_block_time() - fc::days(get_history_size());
+      if (tp > time_point()) {
+         history_time = tp;
+      }
+   }
+
+   // only overdue cheques can be reversed or removed, visit them in the order of their ids
+   std::vector<cheque_id_type> overdue;
+   auto collect = [&](cheque_status status, fc::time_point_sec before) {
+      auto end = idx_cheques.lower_bound(boost::make_tuple(status, before));
+      for (auto itr = idx_cheques.lower_bound(boost::make_tuple(status)); itr != end; ++itr) {
+         overdue.push_back(itr->get_id());
+      }
+   };
+   collect(cheque_status::cheque_new, std::max(maint_time + 1, history_time));
+   collect(cheque_status::cheque_used, history_time);
+   collect(cheque_status::cheque_undo, history_time);
+   std::sort(overdue.begin(), overdue.end());
+
    std::vector<cheque_id_type> to_remove;
 
    // we need to remove expired cheques and return amounts to the owners balances
-   for (const cheque_object& cheque_obj: idx_cheques)
+   for (const cheque_id_type& cheque_id: overdue)
    {
+      const cheque_object& cheque_obj = cheque_id(*this);
+
       /**
        * change cheque status from 'cheque_status::new' to 'cheque_status::cheque_undo'
        * and return amount to the maker if overdue */
       if ( (cheque_obj.status == cheque_status::cheque_new)
-           && ((dpo.next_maintenance_time - gpo.parameters.maintenance_interval) >= cheque_obj.datetime_expiration) )
+           && (maint_time >= cheque_obj.datetime_expiration) )
       {
          cheque_reverse_operation op;
          op.cheque_id  = cheque_obj.get_id();
@@ -1548,8 +1564,7 @@ void database::process_cheques()
 
       if (get_history_size() > 0)
       {
-         const time_point& tp = head_block_time() - fc::days(get_history_size());
-         if ((cheque_obj.status != cheque_status::cheque_new) && (cheque_obj.datetime_expiration < tp)) {
+         if ((cheque_obj.status != cheque_status::cheque_new) && (cheque_obj.datetime_expiration < history_time)) {
             to_remove.push_back(cheque_obj.get_id());
          }
       }
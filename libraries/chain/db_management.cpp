@@ -3,6 +3,7 @@
 #include <graphene/chain/database.hpp>
 
 #include <graphene/chain/operation_history_object.hpp>
+#include <graphene/chain/replay_pipeline.hpp>
 #include <graphene/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
@@ -21,10 +22,12 @@ database::database()
 
 database::~database()
 {
+   wait_for_snapshot();
+   cancel_pending_tx_reapply();
    clear_pending();
 }
 
-void database::reindex(fc::path data_dir, const genesis_state_type& initial_allocation)
+void database::reindex(fc::path data_dir, const genesis_state_type& initial_allocation, bool from_snapshot)
 { try {
    set_registrar_mode(true);
    enable_replay_process_status(true);
@@ -35,7 +38,26 @@ void database::reindex(fc::path data_dir, const genesis_state_type& initial_allo
 
    ilog( "reindexing blockchain" );
    wipe(data_dir, false);
-   open(data_dir, [&initial_allocation]{return initial_allocation;});
+   const uint32_t snapshot_block_num = from_snapshot ? restore_snapshot(data_dir) : 0;
+   bool snapshot_loaded = true;
+   try {
+      open(data_dir, [&initial_allocation]{return initial_allocation;});
+   } catch( const fc::exception& e ) {
+      // a snapshot written by an older version may not match the current serialization of objects
+      if( snapshot_block_num == 0 )
+         throw;
+      wlog( "${e}", ("e", e.to_detail_string()) );
+      if( _block_id_to_block.is_open() )
+         _block_id_to_block.close();
+      snapshot_loaded = false;
+   }
+   if (snapshot_block_num != 0 && (!snapshot_loaded || head_block_num() != snapshot_block_num)) {
+      wlog( "Snapshot of block ${n} could not be loaded, replaying all blocks", ("n", snapshot_block_num) );
+      wipe(data_dir, false);
+      // the indexes still hold what was loaded from the snapshot
+      clear();
+      open(data_dir, [&initial_allocation]{return initial_allocation;});
+   }
 
    auto start = fc::time_point::now();
    auto last_block = _block_id_to_block.last();
@@ -46,39 +68,57 @@ void database::reindex(fc::path data_dir, const genesis_state_type& initial_allo
    }
 
    const auto last_block_num = last_block->block_num();
+   const uint32_t first_block_num = head_block_num() + 1;
 
-   ilog( "Replaying blocks..." );
+   ilog( "Replaying blocks from ${n}...", ("n", first_block_num) );
    _undo_db.disable();
 
-   for( uint32_t i = 1; i <= last_block_num; ++i )
+   const uint32_t skip = skip_witness_signature |
+                         skip_transaction_signatures |
+                         skip_transaction_dupe_check |
+                         skip_tapos_check |
+                         skip_witness_schedule_check |
+                         skip_authority_check;
+   uint32_t gap_block_num = 0;
    {
-      if( i % 2000 == 0 ) std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num<<"   \n";
-      fc::optional< signed_block > block = _block_id_to_block.fetch_by_number(i);
-      if( !block.valid() )
+      replay_pipeline pipeline( _block_id_to_block, first_block_num, last_block_num, _replay_threads );
+      for( uint32_t i = first_block_num; i <= last_block_num; ++i )
       {
-         wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
-         uint32_t dropped_count = 0;
-         while( true )
+         if( i % 2000 == 0 ) std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num<<"   \n";
+         replay_pipeline::item next = pipeline.next();
+         if( !next.block.valid() )
          {
-            fc::optional< block_id_type > last_id = _block_id_to_block.last_id();
-            // this can trigger if we attempt to e.g. read a file that has block #2 but no block #1
-            if( !last_id.valid() )
-               break;
-            // we've caught up to the gap
-            if( block_header::num_from_id( *last_id ) <= i )
-               break;
-            _block_id_to_block.remove( *last_id );
-            dropped_count++;
+            gap_block_num = i;
+            break;
          }
-         wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
-         break;
+
+         // the merkle root and the size have been checked ahead by the pipeline
+         uint32_t block_skip = skip;
+         if( next.merkle_root_valid )
+            block_skip |= skip_merkle_check;
+         if( next.size <= get_global_properties().parameters.maximum_block_size )
+            block_skip |= skip_block_size_check;
+         apply_block( *next.block, block_skip );
       }
-      apply_block(*block, skip_witness_signature |
-                          skip_transaction_signatures |
-                          skip_transaction_dupe_check |
-                          skip_tapos_check |
-                          skip_witness_schedule_check |
-                          skip_authority_check);
+   }
+
+   if( gap_block_num != 0 )
+   {
+      wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", gap_block_num) );
+      uint32_t dropped_count = 0;
+      while( true )
+      {
+         fc::optional< block_id_type > last_id = _block_id_to_block.last_id();
+         // this can trigger if we attempt to e.g. read a file that has block #2 but no block #1
+         if( !last_id.valid() )
+            break;
+         // we've caught up to the gap
+         if( block_header::num_from_id( *last_id ) <= gap_block_num )
+            break;
+         _block_id_to_block.remove( *last_id );
+         dropped_count++;
+      }
+      wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
    }
    _undo_db.enable();
    enable_replay_process_status(false);
@@ -139,6 +179,7 @@ void database::wipe(const fc::path& data_dir, bool include_blocks)
    object_database::wipe(data_dir);
    if (include_blocks) {
       fc::remove_all(data_dir / "database");
+      fc::remove_all(data_dir / "snapshots");
    }
 }
 
@@ -163,10 +204,12 @@ void database::open(
       {
          _fork_db.start_block(*last_block);
          idump((last_block->id())(last_block->block_num()));
+         // a replay may start from a snapshot behind the last block
          if (last_block->id() != head_block_id()) {
-              FC_ASSERT( head_block_num() == 0, "last block ID does not match current chain state" );
+              FC_ASSERT( head_block_num() == 0 || replay_in_process(), "last block ID does not match current chain state" );
          }
       }
+      _last_snapshot_block_num = newest_snapshot(data_dir / "snapshots");
       _opened = true;
       //idump((head_block_id())(head_block_num()));
    }
@@ -177,6 +220,10 @@ void database::close(bool rewind)
 {
    if (!_opened) { return; }
 
+   wait_for_snapshot();
+   cancel_pending_tx_reapply();
+   undo_checkpointed_batch();
+
    // TODO:  Save pending tx's on close()
    clear_pending();
 
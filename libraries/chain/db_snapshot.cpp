@@ -0,0 +1,187 @@
+// see LICENSE.txt
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/global_property_object.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <algorithm>
+#include <shared_mutex>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   const char* const snapshot_info_file = "snapshot.json";
+
+   /// Block numbers of the complete snapshots in @p snapshots_dir, oldest first
+   std::vector<uint32_t> snapshot_block_nums( const fc::path& snapshots_dir )
+   {
+      std::vector<uint32_t> result;
+      if( !fc::is_directory( snapshots_dir ) )
+         return result;
+      for( fc::directory_iterator itr( snapshots_dir ), end; itr != end; ++itr )
+      {
+         // snapshots being written have a .tmp suffix
+         const std::string name = (*itr).filename().generic_string();
+         if( fc::is_directory( *itr ) && !name.empty()
+             && std::all_of( name.begin(), name.end(), []( char c ) { return c >= '0' && c <= '9'; } ) )
+            result.push_back( std::stoul( name ) );
+      }
+      std::sort( result.begin(), result.end() );
+      return result;
+   }
+
+   void link_or_copy( const fc::path& from, const fc::path& to )
+   {
+      try
+      {
+         fc::create_hard_link( from, to );
+      }
+      catch( ... )
+      {
+         fc::copy( from, to );
+      }
+   }
+
+}
+
+void database::wait_for_snapshot()
+{
+   if( _snapshot_writer.valid() )
+      _snapshot_writer.get();
+}
+
+void database::save_snapshot_if_due()
+{ try {
+   if( _snapshot_interval == 0 || !_undo_db.enabled() )
+      return;
+
+   const uint32_t last_irreversible = get_dynamic_global_properties().last_irreversible_block_num;
+   if( last_irreversible == 0 || last_irreversible < _last_snapshot_block_num + _snapshot_interval )
+      return;
+   // skip this one if the previous snapshot is still being written
+   if( _snapshot_writer.valid()
+       && _snapshot_writer.wait_for( std::chrono::seconds(0) ) != std::future_status::ready )
+      return;
+   wait_for_snapshot();
+   _last_snapshot_block_num = last_irreversible;
+
+   // the state is packed by the writer between blocks, the gate keeps the next block out until it is captured
+   const fc::path snapshots_dir = get_data_dir() / "snapshots";
+   _snapshot_writer = std::async( std::launch::async, [this, snapshots_dir]()
+   {
+      uint32_t block_num = 0;
+      try
+      {
+         std::vector<db::packed_index> state;
+         block_id_type block_id;
+         {
+            std::shared_lock<read_write_gate> gate( _state_gate );
+            block_num = get_dynamic_global_properties().last_irreversible_block_num;
+            // every block above the last irreversible one has its own undo state, these are rolled back in the
+            // snapshot together with the state of the pending transactions on top of them
+            const uint32_t block_depth = head_block_num() - block_num;
+            const uint32_t undo_depth = block_depth + ( _pending_tx_session.valid() ? 1 : 0 );
+            if( undo_depth > _undo_db.size() )
+               return;
+            if( block_depth > 0 )
+            {
+               const auto& old_values = _undo_db.at_depth( undo_depth - 1 ).old_values;
+               auto itr = old_values.find( dynamic_global_property_id_type() );
+               if( itr == old_values.end()
+                   || static_cast<const dynamic_global_property_object&>( *itr->second ).head_block_number
+                      != block_num )
+               {
+                  wlog( "Undo history does not match the blocks since ${n}, skipping snapshot", ("n", block_num) );
+                  return;
+               }
+            }
+            state = capture( undo_depth );
+            block_id = get_block_id_for_num( block_num );
+         }
+
+         const fc::path dir = snapshots_dir / fc::to_string( block_num );
+         const fc::path tmp_dir = snapshots_dir / ( fc::to_string( block_num ) + ".tmp" );
+         fc::remove_all( tmp_dir );
+         object_database::save( state, tmp_dir );
+         fc::json::save_to_file( fc::mutable_variant_object( "block_num", block_num )
+                                                           ( "block_id", fc::variant( block_id, 1 ) ),
+                                 tmp_dir / snapshot_info_file );
+         fc::remove_all( dir );
+         fc::rename( tmp_dir, dir );
+         remove_old_snapshots( snapshots_dir );
+         ilog( "Saved snapshot of block ${n}", ("n", block_num) );
+      }
+      catch( const fc::exception& e )
+      {
+         elog( "Failed to save snapshot of block ${n}: ${e}", ("n", block_num)("e", e.to_detail_string()) );
+      }
+      catch( const std::exception& e )
+      {
+         elog( "Failed to save snapshot of block ${n}: ${e}", ("n", block_num)("e", e.what()) );
+      }
+   });
+} FC_CAPTURE_AND_RETHROW() }
+
+uint32_t database::newest_snapshot( const fc::path& snapshots_dir )
+{
+   const std::vector<uint32_t> block_nums = snapshot_block_nums( snapshots_dir );
+   return block_nums.empty() ? 0 : block_nums.back();
+}
+
+void database::remove_old_snapshots( const fc::path& snapshots_dir )const
+{
+   const std::vector<uint32_t> block_nums = snapshot_block_nums( snapshots_dir );
+   for( size_t i = 0; i + _snapshot_count < block_nums.size(); ++i )
+      fc::remove_all( snapshots_dir / fc::to_string( block_nums[i] ) );
+}
+
+uint32_t database::restore_snapshot( const fc::path& data_dir )
+{
+   const fc::path snapshots_dir = data_dir / "snapshots";
+   const std::vector<uint32_t> block_nums = snapshot_block_nums( snapshots_dir );
+   if( block_nums.empty() )
+      return 0;
+
+   block_database blocks;
+   blocks.open( data_dir / "database" / "block_num_to_block" );
+   const fc::path objects_dir = data_dir / "object_database";
+   for( auto num = block_nums.rbegin(); num != block_nums.rend(); ++num )
+   {
+      const fc::path dir = snapshots_dir / fc::to_string( *num );
+      try
+      {
+         const fc::variant_object info = fc::json::from_file( dir / snapshot_info_file ).get_object();
+         const block_id_type block_id = info["block_id"].as<block_id_type>( 1 );
+         if( !blocks.contains( block_id ) )
+         {
+            wlog( "Snapshot of block ${n} does not match the stored blocks", ("n", *num) );
+            continue;
+         }
+
+         // the object database is written to a new directory on flush, so the snapshot files can be shared
+         fc::remove_all( objects_dir );
+         for( fc::directory_iterator space( dir ), end; space != end; ++space )
+         {
+            if( !fc::is_directory( *space ) )
+               continue;
+            fc::create_directories( objects_dir / (*space).filename() );
+            for( fc::directory_iterator file( *space ); file != end; ++file )
+               link_or_copy( *file, objects_dir / (*space).filename() / (*file).filename() );
+         }
+         ilog( "Loading snapshot of block ${n}", ("n", *num) );
+         blocks.close();
+         return *num;
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Skipping snapshot of block ${n}: ${e}", ("n", *num)("e", e.to_detail_string()) );
+         fc::remove_all( objects_dir );
+      }
+   }
+   blocks.close();
+   return 0;
+}
+
+} }
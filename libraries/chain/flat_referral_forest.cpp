@@ -0,0 +1,182 @@
+// see LICENSE.txt
+
+#include <graphene/chain/flat_referral_forest.hpp>
+#include <graphene/chain/account_object.hpp>
+
+namespace graphene { namespace chain {
+
+const uint32_t flat_referral_forest::npos;
+
+void flat_referral_forest::clear()
+{
+   parent.clear();
+   account.clear();
+   referral_payments_enabled.clear();
+   daily_deposits.clear();
+   active_deposits.clear();
+   active_deposits_count.clear();
+   nearest_return_datetime.clear();
+   active_deposits_sum.clear();
+   active_deposits_count_sum.clear();
+   level.clear();
+   for( int i = 0; i < 3; ++i )
+   {
+      level_payment[i].clear();
+      level_valid_referrals_count[i].clear();
+   }
+   children_offset.clear();
+   children.clear();
+   _node_of_account.clear();
+}
+
+void flat_referral_forest::reset( uint64_t max_instance )
+{
+   clear();
+   _node_of_account.assign( max_instance + 1, npos );
+
+   const size_t expected_size = max_instance + 2;
+   parent.reserve( expected_size );
+   account.reserve( expected_size );
+   referral_payments_enabled.reserve( expected_size );
+   daily_deposits.reserve( expected_size );
+   active_deposits.reserve( expected_size );
+   active_deposits_count.reserve( expected_size );
+   nearest_return_datetime.reserve( expected_size );
+   active_deposits_sum.reserve( expected_size );
+   active_deposits_count_sum.reserve( expected_size );
+   level.reserve( expected_size );
+   for( int i = 0; i < 3; ++i )
+   {
+      level_payment[i].reserve( expected_size );
+      level_valid_referrals_count[i].reserve( expected_size );
+   }
+
+   // the root, its account is the default one, i.e. the committee account
+   parent.push_back( npos );
+   account.push_back( account_id_type() );
+   referral_payments_enabled.push_back( true );
+   daily_deposits.emplace_back();
+   active_deposits.emplace_back();
+   active_deposits_count.push_back( 0 );
+   nearest_return_datetime.emplace_back();
+   active_deposits_sum.emplace_back();
+   active_deposits_count_sum.push_back( 0 );
+   level.push_back( 0 );
+   for( int i = 0; i < 3; ++i )
+   {
+      level_payment[i].emplace_back();
+      level_valid_referrals_count[i].push_back( 0 );
+   }
+}
+
+uint32_t flat_referral_forest::add( uint32_t parent_node, const account_object& acc )
+{
+   FC_ASSERT( parent_node < size() );
+   const uint32_t node = size();
+
+   parent.push_back( parent_node );
+   account.push_back( acc.get_id() );
+   referral_payments_enabled.push_back( acc.referral_payments_enabled );
+   daily_deposits.push_back( acc.edc_in_deposits_daily );
+   active_deposits.push_back( acc.edc_in_deposits );
+   active_deposits_count.push_back( acc.edc_active_deposits_count );
+   nearest_return_datetime.push_back( acc.edc_deposit_nearest_dt );
+   active_deposits_sum.emplace_back();
+   active_deposits_count_sum.push_back( 0 );
+   level.push_back( 0 );
+   for( int i = 0; i < 3; ++i )
+   {
+      level_payment[i].emplace_back();
+      level_valid_referrals_count[i].push_back( 0 );
+   }
+
+   const uint64_t instance = acc.get_id().instance.value;
+   if( instance >= _node_of_account.size() )
+      _node_of_account.resize( instance + 1, npos );
+   if( _node_of_account[instance] == npos )
+      _node_of_account[instance] = node;
+
+   return node;
+}
+
+uint32_t flat_referral_forest::find( account_id_type id )const
+{
+   const uint64_t instance = id.instance.value;
+   return instance < _node_of_account.size() ? _node_of_account[instance] : npos;
+}
+
+template<typename T>
+void flat_referral_forest::permute( vector<T>& values, const vector<uint32_t>& order )
+{
+   vector<T> result;
+   result.reserve( values.capacity() );
+   for( uint32_t i : order )
+      result.push_back( values[i] );
+   values.swap( result );
+}
+
+void flat_referral_forest::finish()
+{
+   const uint32_t n = size();
+
+   // a parent is always added before its children, counting sort keeps the siblings in the order they were added
+   auto build_children = [this, n]() {
+      children_offset.assign( n + 1, 0 );
+      for( uint32_t i = 1; i < n; ++i )
+         ++children_offset[ parent[i] + 1 ];
+      for( uint32_t i = 0; i < n; ++i )
+         children_offset[i + 1] += children_offset[i];
+      children.resize( n - 1 );
+      vector<uint32_t> next( children_offset.begin(), children_offset.end() - 1 );
+      for( uint32_t i = 1; i < n; ++i )
+         children[ next[ parent[i] ]++ ] = i;
+   };
+   build_children();
+
+   vector<uint32_t> order;
+   order.reserve( n );
+   vector<uint32_t> stack( 1, 0 );
+   while( !stack.empty() )
+   {
+      const uint32_t node = stack.back();
+      stack.pop_back();
+      order.push_back( node );
+      for( uint32_t i = children_offset[node + 1]; i-- > children_offset[node]; )
+         stack.push_back( children[i] );
+   }
+
+   bool sorted = true;
+   for( uint32_t i = 0; i < n && sorted; ++i )
+      sorted = ( order[i] == i );
+   // the forest of referral_forest_index is added in pre-order already
+   if( sorted )
+      return;
+
+   vector<uint32_t> rank( n );
+   for( uint32_t i = 0; i < n; ++i )
+      rank[ order[i] ] = i;
+
+   vector<uint32_t> new_parent;
+   new_parent.reserve( parent.capacity() );
+   for( uint32_t i : order )
+      new_parent.push_back( parent[i] == npos ? npos : rank[ parent[i] ] );
+   parent.swap( new_parent );
+
+   permute( account, order );
+   permute( referral_payments_enabled, order );
+   permute( daily_deposits, order );
+   permute( active_deposits, order );
+   permute( active_deposits_count, order );
+   permute( nearest_return_datetime, order );
+   permute( active_deposits_sum, order );
+   permute( active_deposits_count_sum, order );
+   // the levels, payments and counts are still zero, they need not be moved
+
+   for( uint32_t& node : _node_of_account )
+      if( node != npos )
+         node = rank[node];
+
+   build_children();
+}
+
+} }
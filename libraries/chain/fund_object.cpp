@@ -121,9 +121,7 @@ void fund_object::process(database& db) const
    const auto& users_idx = db.get_index_type<account_index>().indices().get<by_id>();
    fc::time_point_sec maint_time = dpo.next_maintenance_time - gpo.parameters.maintenance_interval;
 
-   // find own fund deposits
-   auto range = db.get_index_type<fund_deposit_index>().indices().get<by_fund_id>().equal_range(id);
-   std::for_each(range.first, range.second, [&](const fund_deposit_object& dep)
+   auto process_deposit = [&](const fund_deposit_object& dep)
    {
       auto user_ptr = users_idx.find(dep.account_id);
       const account_object& acc = *user_ptr;
@@ -302,7 +300,28 @@ void fund_object::process(database& db) const
             }
          }
       }
-   });
+   };
+
+   if (db.head_block_time() >= HARDFORK_640_TIME)
+   {
+      // finished deposits are left untouched, so only the unfinished ones are visited. They are collected
+      // first, because processing a deposit may finish it and move it within by_fund_finished
+      const auto& idx_deposits = db.get_index_type<fund_deposit_index>().indices().get<by_fund_finished>();
+      std::vector<fund_deposit_id_type> unfinished;
+      auto range = idx_deposits.equal_range(boost::make_tuple(id, false));
+      for (auto itr = range.first; itr != range.second; ++itr) {
+         unfinished.push_back(itr->get_id());
+      }
+      for (const fund_deposit_id_type& dep_id: unfinished) {
+         process_deposit(dep_id(db));
+      }
+   }
+   else
+   {
+      // find own fund deposits
+      auto range = db.get_index_type<fund_deposit_index>().indices().get<by_fund_id>().equal_range(id);
+      std::for_each(range.first, range.second, process_deposit);
+   }
 
    /***************** make payment to fund owner *****************/
 
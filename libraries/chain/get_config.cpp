@@ -30,6 +30,8 @@ fc::variant_object get_config()
    result[ "GRAPHENE_DEFAULT_MAINTENANCE_SKIP_SLOTS" ] = GRAPHENE_DEFAULT_MAINTENANCE_SKIP_SLOTS;
    result[ "GRAPHENE_MIN_UNDO_HISTORY" ] = GRAPHENE_MIN_UNDO_HISTORY;
    result[ "GRAPHENE_MAX_UNDO_HISTORY" ] = GRAPHENE_MAX_UNDO_HISTORY;
+   result[ "GRAPHENE_CHECKPOINTED_BATCH_SIZE" ] = GRAPHENE_CHECKPOINTED_BATCH_SIZE;
+   result[ "GRAPHENE_CHECKPOINTED_BATCH_TIMEOUT_SEC" ] = GRAPHENE_CHECKPOINTED_BATCH_TIMEOUT_SEC;
    result[ "GRAPHENE_MIN_BLOCK_SIZE_LIMIT" ] = GRAPHENE_MIN_BLOCK_SIZE_LIMIT;
    result[ "GRAPHENE_MIN_TRANSACTION_EXPIRATION_LIMIT" ] = GRAPHENE_MIN_TRANSACTION_EXPIRATION_LIMIT;
    result[ "GRAPHENE_BLOCKCHAIN_PRECISION" ] = GRAPHENE_BLOCKCHAIN_PRECISION;
@@ -8,8 +8,10 @@
 #include <graphene/protocol/referral_classes.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 
 #include <iostream>
+#include <limits>
 
 namespace graphene { namespace chain {
    class database;
@@ -494,8 +496,107 @@ namespace graphene { namespace chain {
 
          /** maps the referrer to the set of accounts that they have referred */
          map< account_id_type, set<account_id_type> > referred_by;
+
+      protected:
+         account_id_type before_referrer;
    };
-   
+
+   /**
+    *  @brief This secondary index keeps the referral forest used by maintenance up to date between maintenances.
+    *
+    *  Accounts are attached to their referrers by the same rules database::form_referral_map() applies when it
+    *  builds the tree from scratch, and siblings are ordered the way that build would create them (by the first
+    *  account of the subtree met while scanning accounts by id), so a pre-order walk yields the same tree.
+    *  Deposit aggregates of every node are adjusted on each account change, and the index is undo-aware as
+    *  it only reacts to the primary index callbacks.
+    *
+    *  The referrals of an account are read from account_referrer_index, which must be added to the account index
+    *  before this one so that it is up to date when this index is notified.
+    */
+   class referral_forest_index : public secondary_index
+   {
+      public:
+         referral_forest_index( const account_referrer_index& referrer_index ) : referrers(referrer_index) {}
+
+         static const uint64_t no_key = std::numeric_limits<uint64_t>::max();
+
+         typedef std::set< std::pair<uint64_t, account_id_type> > ordered_nodes;
+
+         struct node
+         {
+            const account_object*     account = nullptr;
+            account_id_type           referrer;
+            bool                      visited = false;
+            /** empty for the top-level nodes */
+            optional<account_id_type> parent;
+            /** instance of the first account of the subtree visited by maintenance, no_key if there is none */
+            uint64_t                  key = no_key;
+            ordered_nodes             children;
+
+            /** children and grandchildren whose referral walk reaches this node */
+            uint32_t                  level1_count = 0;
+            uint32_t                  level2_count = 0;
+            /** the same values process_referrals() used to accumulate into the referral forest of maintenance */
+            share_type                active_deposits_sum;
+            uint32_t                  active_deposits_count_sum = 0;
+
+            /** what this node currently adds to the aggregates of its ancestors */
+            optional<account_id_type> counted_in_parent;
+            optional<account_id_type> counted_in_grandparent;
+            optional<account_id_type> summed_in;
+            share_type                summed_deposits;
+            uint32_t                  summed_deposits_count = 0;
+
+            bool in_forest()const { return key != no_key; }
+         };
+
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         const node* find( account_id_type id )const;
+
+         /** visits the nodes of the forest in pre-order, calling v(node, parent) with parent == nullptr for top-level nodes */
+         template<typename Visitor>
+         void for_each_preorder( Visitor&& v )const
+         {
+            std::vector< std::pair<const node*, ordered_nodes::const_iterator> > stack;
+            for( const auto& top : roots )
+            {
+               if( top.first == no_key ) break;
+               const node& n = nodes.at( top.second );
+               v( n, (const node*)nullptr );
+               stack.emplace_back( &n, n.children.begin() );
+               while( !stack.empty() )
+               {
+                  auto& current = stack.back();
+                  if( current.second == current.first->children.end() || current.second->first == no_key )
+                  {
+                     stack.pop_back();
+                     continue;
+                  }
+                  const node& child = nodes.at( (current.second++)->second );
+                  v( child, current.first );
+                  stack.emplace_back( &child, child.children.begin() );
+               }
+            }
+         }
+
+      private:
+         bool is_visited( const account_object& a )const;
+         optional<account_id_type> effective_parent( account_id_type id )const;
+         ordered_nodes& siblings( const node& n );
+         void set_parent( account_id_type id, const optional<account_id_type>& parent );
+         void update_key( account_id_type id );
+         void reattach_referrals( account_id_type id );
+         void sync();
+
+         const account_referrer_index&                 referrers;
+         map< account_id_type, node >                  nodes;
+         ordered_nodes                                 roots;
+         set< account_id_type >                        touched;
+   };
+
    struct SimpleUnit
    {
       std::string rank = "";
@@ -589,6 +690,70 @@ namespace graphene { namespace chain {
     */
    typedef generic_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
 
+   /**
+    *  @brief This secondary index of the account balances counts the holders of every asset, and the ones of them
+    *  registered in a period of time, without going through the accounts.
+    *
+    *  A holder is an account with a positive balance of the asset. The holders are kept ordered by asset and
+    *  account_object::register_datetime in a ranked index, so the holders registered in a period are counted from the
+    *  ranks of its ends. They are also ordered by asset and account, so they can be listed a page at a time.
+    */
+   class account_holder_index : public secondary_index
+   {
+      public:
+         account_holder_index( const graphene::db::object_database& db ) : _db(db) {}
+
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_loaded( const object& obj ) override;
+         virtual void all_objects_loaded() override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /** @return the number of accounts with a positive balance of @p asset */
+         uint64_t holder_count( asset_id_type asset )const;
+         /** @return the number of accounts with a positive balance of @p asset registered from @p start to @p end */
+         uint64_t holder_count( asset_id_type asset, fc::time_point_sec start, fc::time_point_sec end )const;
+         /** @return the accounts with a positive balance of @p asset from @p start on, ordered by id, at most @p limit */
+         vector<account_id_type> holders( asset_id_type asset, account_id_type start, uint32_t limit )const;
+
+      private:
+         struct holder
+         {
+            asset_id_type      asset;
+            fc::time_point_sec registered;
+            account_id_type    owner;
+         };
+         struct by_registration;
+         struct by_asset_owner;
+         typedef multi_index_container<
+            holder,
+            indexed_by<
+               ranked_unique< tag<by_registration>,
+                  composite_key< holder,
+                     member< holder, asset_id_type, &holder::asset >,
+                     member< holder, fc::time_point_sec, &holder::registered >,
+                     member< holder, account_id_type, &holder::owner >
+                  >
+               >,
+               ordered_unique< tag<by_asset_owner>,
+                  composite_key< holder,
+                     member< holder, asset_id_type, &holder::asset >,
+                     member< holder, account_id_type, &holder::owner >
+                  >
+               >
+            >
+         > holder_multi_index_type;
+
+         void update( const account_balance_object& balance, bool holds );
+         fc::time_point_sec registration_time( account_id_type account )const;
+
+         const graphene::db::object_database& _db;
+         holder_multi_index_type              _holders;
+         flat_map< asset_id_type, uint64_t >  _holder_counts;
+         /// the holders opened from disk, added once the accounts they were registered by are loaded as well
+         vector< holder >                     _loaded_holders;
+   };
+
    /////////////////////////////////////
 
    /**
@@ -781,4 +946,8 @@ GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::accounts_online_object
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::market_address_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::blind_transfer2_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::bonus_balances_object )
-GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::account_mature_balance_object )
\ No newline at end of file
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::account_mature_balance_object )
+
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::account_object )
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::account_balance_object )
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::account_statistics_object )
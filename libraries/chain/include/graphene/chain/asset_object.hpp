@@ -265,3 +265,6 @@ FC_REFLECT_TYPENAME( graphene::chain::asset_dynamic_data_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::asset_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::asset_bitasset_data_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::asset_dynamic_data_object )
+
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::asset_object )
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::asset_dynamic_data_object )
@@ -0,0 +1,69 @@
+// see LICENSE.txt
+
+#pragma once
+#include <graphene/protocol/block.hpp>
+
+#include <graphene/chain/types.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+namespace graphene { namespace chain {
+
+   struct block_production_stats
+   {
+      uint32_t           block_num = 0;
+      fc::time_point_sec block_time;
+      /// number of transactions included in the block
+      uint32_t           transactions = 0;
+      /// number of transactions left for a later block because the block was full
+      uint32_t           postponed = 0;
+      /// number of transactions which failed to apply
+      uint32_t           failed = 0;
+      /// number of transactions not tried because the production deadline was reached
+      uint32_t           not_tried = 0;
+      /// packed size of the block, including the maximum header size
+      uint64_t           block_size = 0;
+      /// wall time spent from the start of production until the block was signed, in microseconds
+      uint64_t           wall_time_us = 0;
+      bool               deadline_reached = false;
+   };
+
+   /**
+    * @brief Assembles the transactions of a block as they are accepted
+    *
+    * The builder keeps the packed size of the block and the roots of the complete merkle subtrees of the transactions
+    * accepted so far, so neither the block nor its transactions have to be packed or hashed again when the block is
+    * finished. The merkle root is the one signed_block::calculate_merkle_root() computes.
+    */
+   class block_builder
+   {
+      public:
+         /// @param header_size the maximum packed size of the header of the block
+         block_builder( size_t maximum_block_size, size_t header_size );
+
+         /// @return whether a transaction of @p packed_size bytes fits into the block
+         bool fits( size_t packed_size )const { return _size + packed_size <= _maximum_size; }
+         /// Adds @p trx, which takes @p packed_size bytes, to the block
+         void push( processed_transaction&& trx, size_t packed_size );
+
+         size_t size()const { return _size; }
+         const vector<processed_transaction>& transactions()const { return _transactions; }
+         checksum_type merkle_root()const;
+
+         /// Moves the transactions and the merkle root into @p block
+         void finish( signed_block& block );
+
+      private:
+         size_t                                 _maximum_size;
+         size_t                                 _size;
+         vector<processed_transaction>          _transactions;
+         /// roots of the complete subtrees, the largest first, with the number of their levels below the root
+         vector<std::pair<digest_type,uint32_t>> _merkle_peaks;
+   };
+
+} }
+
+FC_REFLECT( graphene::chain::block_production_stats,
+            (block_num)(block_time)(transactions)(postponed)(failed)(not_tried)(block_size)(wall_time_us)
+            (deadline_reached) )
@@ -2,10 +2,31 @@
 
 #pragma once
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <fc/filesystem.hpp>
+#include <fc/interprocess/file_mapping.hpp>
 #include <graphene/protocol/block.hpp>
 
 namespace graphene { namespace chain {
-   class block_database 
+   struct index_entry;
+   struct archive_header;
+   struct archive_chunk;
+
+   /**
+    * @brief Stores irreversible blocks by number
+    *
+    * The @c index file is an array of index_entry, one per block number, and the @c blocks file holds the packed
+    * blocks back to back. Both files are memory mapped: lookups in the index are plain array accesses, and blocks are
+    * unpacked straight from the mapped @c blocks file. New blocks are appended to @c blocks through a write cursor,
+    * the mapping is extended lazily when a block beyond its end is read.
+    *
+    * Older blocks may instead live in a compressed archive made by convert(). The @c archive file holds zlib
+    * compressed chunks of a fixed number of consecutive blocks, and the @c archive_index file holds a header, the
+    * directory of chunks and the ids of all archived blocks. Block numbers below archive_size() are served from the
+    * archive, the ones above from the @c index / @c blocks pair. Archived blocks can not be removed.
+    */
+   class block_database
    {
       public:
          void open( const fc::path& dbdir );
@@ -22,8 +43,68 @@ namespace graphene { namespace chain {
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
+
+         /**
+          * Reads the blocks numbered @p first to @p first + @p count - 1 as they are stored, without unpacking them.
+          * Stops at the first block missing from the database.
+          */
+         std::vector<std::vector<char>> fetch_packed_range( uint32_t first, uint32_t count )const;
+
+         /// Number of block numbers served by the archive, all blocks below it are archived
+         uint32_t               archive_size()const { return _archive_size; }
+
+         /**
+          * Moves all complete chunks of @p blocks_per_chunk blocks of the database in @p dbdir into the archive.
+          * Blocks already archived are recompressed, the remaining blocks are kept in the @c index / @c blocks pair.
+          * The database must not be open while it is converted. A conversion interrupted by a crash is completed or
+          * dropped by the next open(), so the database never holds a mix of old and new files.
+          */
+         static void convert( const fc::path& dbdir, uint32_t blocks_per_chunk = 1000 );
       private:
-         mutable std::fstream _blocks;
-         mutable std::fstream _block_num_to_pos;
+         const index_entry* find_entry( uint32_t block_num )const;
+         index_entry*       mutable_entry( uint32_t block_num );
+         const index_entry* last_entry()const;
+         /// calls visit(data, size) with the packed block while the blocks file is locked for reading
+         template<typename Visitor>
+         void               visit_block( const index_entry& e, Visitor&& visit )const;
+         signed_block       read_block( const index_entry& e )const;
+         void               map_index( uint64_t capacity );
+         void               open_archive();
+         const block_id_type* find_archived_id( uint32_t block_num )const;
+         uint32_t           last_archived_num()const;
+         template<typename Visitor>
+         void               visit_archived_block( uint32_t block_num, Visitor&& visit )const;
+         signed_block       read_archived_block( uint32_t block_num )const;
+
+         fc::path                                   _index_path;
+         fc::path                                   _blocks_path;
+         std::unique_ptr<fc::file_mapping>          _index_file;
+         std::unique_ptr<fc::mapped_region>         _index_region;
+         /// number of entries the index file holds
+         uint64_t                                   _index_size = 0;
+         /// number of entries the index file has room for
+         uint64_t                                   _index_capacity = 0;
+
+         mutable std::fstream                       _blocks;
+         /// write cursor, the end of the last block appended to the blocks file
+         uint64_t                                   _blocks_size = 0;
+         mutable std::unique_ptr<fc::file_mapping>  _blocks_file;
+         mutable std::unique_ptr<fc::mapped_region> _blocks_region;
+
+         fc::path                                   _archive_path;
+         fc::path                                   _archive_index_path;
+         std::unique_ptr<fc::file_mapping>          _archive_file;
+         std::unique_ptr<fc::mapped_region>         _archive_region;
+         std::unique_ptr<fc::file_mapping>          _archive_index_file;
+         std::unique_ptr<fc::mapped_region>         _archive_index_region;
+         const archive_header*                      _archive_header = nullptr;
+         const archive_chunk*                       _archive_chunks = nullptr;
+         const block_id_type*                       _archive_ids = nullptr;
+         uint32_t                                   _archive_size = 0;
+         /// the last chunk read from the archive, decompressed
+         mutable int64_t                            _cached_chunk = -1;
+         mutable std::string                        _cached_chunk_data;
+         /// guards the lazy mapping of the blocks file and the chunk cache, blocks may be read from several threads
+         mutable std::mutex                         _read_mutex;
    };
 } }
@@ -80,6 +80,7 @@ namespace graphene { namespace chain {
    struct by_code;
    struct by_datetime_exp;
    struct by_datetime_creation;
+   struct by_status_expiration;
 
    /**
     * @ingroup object_index
@@ -91,7 +92,14 @@ namespace graphene { namespace chain {
          ordered_unique<tag<by_code>, member<cheque_object, std::string, &cheque_object::code>>,
          ordered_non_unique<tag<by_drawer>, member<cheque_object, account_id_type, &cheque_object::drawer>>,
          ordered_non_unique<tag<by_datetime_creation>, member<cheque_object, fc::time_point_sec, &cheque_object::datetime_creation>>,
-         ordered_non_unique<tag<by_datetime_exp>, member<cheque_object, fc::time_point_sec, &cheque_object::datetime_expiration>>
+         ordered_non_unique<tag<by_datetime_exp>, member<cheque_object, fc::time_point_sec, &cheque_object::datetime_expiration>>,
+         ordered_unique<tag<by_status_expiration>,
+            composite_key<cheque_object,
+               member<cheque_object, cheque_status, &cheque_object::status>,
+               member<cheque_object, fc::time_point_sec, &cheque_object::datetime_expiration>,
+               member<object, object_id_type, &object::id>
+            >
+         >
       >
    > cheque_object_index_type;
 
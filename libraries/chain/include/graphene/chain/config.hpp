@@ -6,10 +6,12 @@
 
 #define GRAPHENE_MIN_UNDO_HISTORY 10
 #define GRAPHENE_MAX_UNDO_HISTORY 50000
+#define GRAPHENE_CHECKPOINTED_BATCH_SIZE 1000
+#define GRAPHENE_CHECKPOINTED_BATCH_TIMEOUT_SEC 60
 
 #define GRAPHENE_MAX_NESTED_OBJECTS (200)
 
-#define GRAPHENE_CURRENT_DB_VERSION              "GPH2.5"
+#define GRAPHENE_CURRENT_DB_VERSION              "GPH2.6"
 
 #define GRAPHENE_RECENTLY_MISSED_COUNT_INCREMENT 4
 #define GRAPHENE_RECENTLY_MISSED_COUNT_DECREMENT 3
@@ -9,16 +9,24 @@
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/genesis_state.hpp>
+#include <graphene/chain/maintenance_profiler.hpp>
+#include <graphene/chain/read_write_gate.hpp>
+#include <graphene/chain/signature_keys_cache.hpp>
 #include <graphene/chain/evaluator.hpp>
+#include <graphene/chain/flat_referral_forest.hpp>
+#include <graphene/chain/pending_transaction_pool.hpp>
+#include <graphene/chain/block_builder.hpp>
 #include <graphene/chain/tree.hpp>
 
 #include <graphene/db/object_database.hpp>
 #include <graphene/db/object.hpp>
 #include <graphene/db/simple_index.hpp>
 #include <fc/signals.hpp>
+#include <fc/thread/future.hpp>
 
 #include <fc/log/logger.hpp>
 
+#include <future>
 #include <map>
 
 namespace graphene { namespace chain {
@@ -87,8 +95,12 @@ namespace graphene { namespace chain {
           *
           * This method may be called after or instead of @ref database::open, and will rebuild the object graph by
           * replaying blockchain history. When this method exits successfully, the database will be open.
+          *
+          * @param from_snapshot If true, the newest snapshot matching the stored blocks is loaded and only the blocks
+          * after it are replayed
           */
-         void reindex(fc::path data_dir, const genesis_state_type& initial_allocation = genesis_state_type());
+         void reindex(fc::path data_dir, const genesis_state_type& initial_allocation = genesis_state_type(),
+                      bool from_snapshot = false);
 
          void mt_times_create_file(const fc::path& data_dir);
          void mt_times_add(uint32_t seconds);
@@ -103,6 +115,37 @@ namespace graphene { namespace chain {
          void wipe(const fc::path& data_dir, bool include_blocks);
          void close(bool rewind = true);
          void set_history_size(int _history_size) { history_size = _history_size; }
+         /// Number of threads used to tally votes during maintenance, 0 or 1 to tally in the calling thread
+         void set_maintenance_tally_threads(uint16_t threads) { _maintenance_tally_threads = threads; }
+         /// Number of threads checking blocks ahead of a replay, besides the one reading them
+         void set_replay_threads(uint16_t threads) { _replay_threads = threads; }
+         /// Number of maintenance profiles to keep in memory
+         void set_maintenance_profile_size(size_t size) { _maintenance_profiler.set_max_size(size); }
+         /// If set, the maintenance profiles are written to this file as JSON after every maintenance
+         void set_maintenance_profile_file(const fc::path& file) { _maintenance_profile_file = file; }
+         const maintenance_profiler& get_maintenance_profiler()const { return _maintenance_profiler; }
+
+         //////////////////// db_snapshot.cpp ////////////////////
+
+         /// Number of irreversible blocks between snapshots of the object database, 0 disables snapshots
+         void set_snapshot_interval(uint32_t blocks) { _snapshot_interval = blocks; }
+         /// Number of snapshots to keep on disk
+         void set_snapshot_count(uint32_t count) { _snapshot_count = std::max<uint32_t>(count, 1); }
+         /**
+          * If set, the pending transactions are not applied again at the end of push_block(), but by a task which
+          * push_block() posts to the calling thread, so the caller can pass the block on first. A push_transaction()
+          * or validate_transaction() before that task applies them as well. Until then the state is the one of the
+          * head block.
+          */
+         void defer_pending_transactions(bool defer) { _defer_pending_tx = defer; }
+         /// Blocks until the snapshot being written in the background, if any, is on disk
+         void wait_for_snapshot();
+
+         /**
+          * Readers on other threads hold the gate shared while they read the state. The database holds it exclusively
+          * while it pushes, pops or generates blocks and pushes or validates transactions.
+          */
+         read_write_gate& state_gate()const { return _state_gate; }
 
          void set_registrar_mode(bool enabled) { _registrar_mode_enabled = enabled; }
          bool registrar_mode_is_enabled() { return _registrar_mode_enabled; }
@@ -118,6 +161,11 @@ namespace graphene { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /**
+          * Reads the blocks numbered @p first to @p first + @p count - 1 of the current chain as they are stored, in
+          * order and without unpacking them. Fewer blocks are returned if the head block is reached.
+          */
+         std::vector<std::vector<char>> fetch_packed_blocks( uint32_t first, uint32_t count )const;
          const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -132,24 +180,55 @@ namespace graphene { namespace chain {
          bool before_last_checkpoint()const;
 
          bool push_block( const signed_block& b, uint32_t skip = skip_nothing );
+         /**
+          * Pushes a block at or below the last checkpoint which builds on the head block and lies less than
+          * GRAPHENE_CHECKPOINTED_BATCH_SIZE blocks below the next checkpoint. Such blocks are never popped, so a run of
+          * them is applied like a replay, without the fork database and within a single undo state. Once the run
+          * reaches the checkpoint with the expected id, the undo history is dropped and the fork database restarts from
+          * that block. A block which fails undoes the run back to the last checkpoint it reached.
+          * Meanwhile push_block() undoes the run for a block which links to the chain before it and rejects other blocks
+          * which do not join it; transactions, pop_block() and generate_block() are rejected. A run which no block joined
+          * for GRAPHENE_CHECKPOINTED_BATCH_TIMEOUT_SEC seconds is undone by the next of these calls.
+          * @return false if the block does not qualify, it is to be pushed with push_block()
+          */
+         bool push_checkpointed_block( const signed_block& b );
+         /// @return true while push_checkpointed_block() has applied blocks which no checkpoint has confirmed yet
+         bool in_checkpointed_batch()const { return _checkpointed_session.valid(); }
          processed_transaction push_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          bool _push_block( const signed_block& b );
          processed_transaction _push_transaction( const signed_transaction& trx );
 
+         /**
+          * Recovers the signature keys of the transactions of @p block on the worker pool and waits for them, so that
+          * checking the signatures when the block is pushed only looks them up in signature_keys().
+          * Nothing is done if @p skip skips the transaction signatures.
+          */
+         void precompute_parallel( const signed_block& block, uint32_t skip = skip_nothing )const;
+         void precompute_parallel( const signed_transaction& trx )const;
+         /// Keys recovered by precompute_parallel() for the block or transactions about to be pushed
+         const signature_keys_cache& signature_keys()const { return _signature_keys; }
+
          ///@throws fc::exception if the proposed transaction fails to apply.
          processed_transaction push_proposal( const proposal_object& proposal );
 
+         /**
+          * Pending transactions are no longer tried once @p deadline has passed, they are left for a later block.
+          */
          signed_block generate_block(
             const fc::time_point_sec when,
             witness_id_type witness_id,
             const fc::ecc::private_key& block_signing_private_key,
-            uint32_t skip
+            uint32_t skip,
+            fc::time_point deadline = fc::time_point::maximum()
             );
          signed_block _generate_block(
             const fc::time_point_sec when,
             witness_id_type witness_id,
-            const fc::ecc::private_key& block_signing_private_key
+            const fc::ecc::private_key& block_signing_private_key,
+            fc::time_point deadline = fc::time_point::maximum()
             );
+         /// How the last block generated by this node was produced
+         const block_production_stats& get_last_block_production()const { return _last_block_production; }
 
          void pop_block();
          void clear_pending();
@@ -444,6 +523,12 @@ namespace graphene { namespace chain {
           */
          processed_transaction validate_transaction( const signed_transaction& trx );
 
+         /// Applies the pending transactions again if push_block() left them, see defer_pending_transactions()
+         void apply_pending_transactions();
+         const pending_transaction_pool& get_pending_transactions()const { return _pending_tx; }
+         /// Makes the transactions of popped blocks, then @p pending, the pending transactions after a block was pushed
+         void restore_pending_transactions( pending_transaction_pool& pending );
+
 
          /** when popping a block, the transactions that were removed get cached here so they
           * can be reapplied at the proper time */
@@ -464,6 +549,16 @@ namespace graphene { namespace chain {
          template<class Index>
          vector<std::reference_wrapper<const typename Index::object_type>> sort_votable_objects(size_t count)const;
 
+         //////////////////// db_snapshot.cpp ////////////////////
+
+         /// Starts a writer that captures the last irreversible state after the current block and saves it, if one is due
+         void save_snapshot_if_due();
+         /// Links the newest snapshot matching the stored blocks into the object database, returns its block number
+         uint32_t restore_snapshot(const fc::path& data_dir);
+         void remove_old_snapshots(const fc::path& snapshots_dir)const;
+         /// Block number of the newest snapshot in the directory, 0 if there is none
+         static uint32_t newest_snapshot(const fc::path& snapshots_dir);
+
          //////////////////// db_block.cpp ////////////////////
 
       public:
@@ -475,6 +570,14 @@ namespace graphene { namespace chain {
 
       private:
          void                  _apply_block( const signed_block& next_block );
+         bool                  _push_checkpointed_block( const signed_block& b );
+         /// Undoes the blocks which push_checkpointed_block() applied after the last checkpoint it reached
+         void                  undo_checkpointed_batch();
+         /// Undoes the run of push_checkpointed_block() if no block joined it for GRAPHENE_CHECKPOINTED_BATCH_TIMEOUT_SEC
+         void                  undo_stalled_checkpointed_batch();
+         void                  _apply_pending_transactions();
+         /// Stops the task applying the deferred pending transactions, see defer_pending_transactions()
+         void                  cancel_pending_tx_reapply();
          processed_transaction _apply_transaction( const signed_transaction& trx, bool need_apply_address_creation = true );
 
          ///Steps involved in applying a new block
@@ -536,14 +639,30 @@ namespace graphene { namespace chain {
          ///@}
          ///@}
 
-         tree<leaf_info2> referral_tree_v2;
-         std::unordered_map<account_id_type, tree<leaf_info2>::iterator> referral_map_v2;
+         flat_referral_forest referral_forest_v2;
 
          int history_size = 0;
+         uint16_t _maintenance_tally_threads = 0;
+         uint16_t _replay_threads = 1;
+         maintenance_profiler _maintenance_profiler{ *this };
+         optional<fc::path> _maintenance_profile_file;
+         uint32_t _snapshot_interval = 0;
+         uint32_t _snapshot_count = 2;
+         uint32_t _last_snapshot_block_num = 0;
+         std::future<void> _snapshot_writer;
+         mutable read_write_gate _state_gate;
+         mutable signature_keys_cache _signature_keys;
          // any LTM-member can create accounts if true
          bool _registrar_mode_enabled = false;
 
-         vector< processed_transaction >        _pending_tx;
+         pending_transaction_pool               _pending_tx;
+         /// the pending transactions are to be applied again, _pending_tx_session does not hold them
+         bool                                   _pending_tx_due = false;
+         /// skip flags of the push_block() which made the pending transactions due
+         uint32_t                               _pending_tx_skip = skip_nothing;
+         bool                                   _defer_pending_tx = false;
+         fc::future<void>                       _pending_tx_reapply;
+         block_production_stats                 _last_block_production;
          fork_database                          _fork_db;
 
          /**
@@ -575,6 +694,9 @@ namespace graphene { namespace chain {
          uint64_t                          _total_voting_stake;
 
          flat_map<uint32_t,block_id_type>  _checkpoints;
+         optional<undo_database::session>  _checkpointed_session;
+         vector<block_id_type>             _checkpointed_blocks;
+         fc::time_point                    _checkpointed_block_time;
 
          node_property_object              _node_property_object;
 
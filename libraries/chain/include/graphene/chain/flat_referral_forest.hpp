@@ -0,0 +1,76 @@
+// see LICENSE.txt
+
+#pragma once
+#include <graphene/chain/types.hpp>
+#include <graphene/protocol/config.hpp>
+
+#include <array>
+#include <limits>
+
+namespace graphene { namespace chain {
+
+   class account_object;
+
+   /**
+    * @brief The referral forest walked by the referral phase of chain maintenance
+    *
+    * The nodes are kept as a structure of arrays. Node 0 is the root, it stands for the committee account and ends
+    * the walks towards the top of the forest. Nodes are added under their parent, then finish() sorts them in pre-order,
+    * so that the referral passes are linear sweeps and a parent is found by its index only.
+    *
+    * clear() keeps the capacity of the arrays, the forest of the next maintenance is built without allocating.
+    */
+   class flat_referral_forest
+   {
+      public:
+         static const uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+         /** Starts a forest holding the root only, @p max_instance is an upper bound of the account instances */
+         void reset( uint64_t max_instance );
+         void clear();
+
+         /**
+          * Adds a node for @p acc as the last child of @p parent and returns its index, which finish() changes.
+          * If the account already has a node, find() still returns the first one.
+          */
+         uint32_t add( uint32_t parent, const account_object& acc );
+         /** Builds the children offsets and sorts the nodes in pre-order, children in the order they were added */
+         void finish();
+
+         /** @return the node of the account, npos if it has none */
+         uint32_t find( account_id_type account )const;
+         uint32_t size()const { return uint32_t(parent.size()); }
+
+         /** @return whether the referral walks continue from a node to @p parent_node */
+         bool is_referrer( uint32_t parent_node )const
+         {
+            return parent_node != npos && account[parent_node] != GRAPHENE_COMMITTEE_ACCOUNT;
+         }
+
+         vector<uint32_t>           parent;
+         vector<account_id_type>    account;
+         vector<bool>               referral_payments_enabled;
+         vector<share_type>         daily_deposits;
+         vector<share_type>         active_deposits;
+         vector<uint32_t>           active_deposits_count;
+         vector<fc::time_point_sec> nearest_return_datetime;
+         vector<share_type>         active_deposits_sum;
+         vector<uint32_t>           active_deposits_count_sum;
+         vector<uint16_t>           level;
+         /** per referral level 1 to 3, at index 0 to 2 */
+         std::array<vector<share_type>, 3> level_payment;
+         std::array<vector<uint32_t>, 3>   level_valid_referrals_count;
+
+         /** the children of node i are children[children_offset[i]] to children[children_offset[i + 1] - 1] */
+         vector<uint32_t>           children_offset;
+         vector<uint32_t>           children;
+
+      private:
+         template<typename T>
+         static void permute( vector<T>& values, const vector<uint32_t>& order );
+
+         /** node of each account instance */
+         vector<uint32_t>           _node_of_account;
+   };
+
+} }
@@ -159,6 +159,8 @@ namespace graphene { namespace chain {
    struct by_account_id;
    struct by_fund_id;
    struct by_period;
+   struct by_fund_finished;
+   struct by_finished_end;
 
    /**
     * @ingroup object_index
@@ -169,7 +171,21 @@ namespace graphene { namespace chain {
             ordered_unique<tag<by_id>, member<object, object_id_type, &object::id>>,
             ordered_non_unique<tag<by_account_id>, member<fund_deposit_object, account_id_type, &fund_deposit_object::account_id>>,
             ordered_non_unique<tag<by_fund_id>, member<fund_deposit_object, fund_id_type, &fund_deposit_object::fund_id>>,
-            ordered_non_unique<tag<by_period>, member<fund_deposit_object, uint32_t, &fund_deposit_object::period>>
+            ordered_non_unique<tag<by_period>, member<fund_deposit_object, uint32_t, &fund_deposit_object::period>>,
+            ordered_unique<tag<by_fund_finished>,
+               composite_key<fund_deposit_object,
+                  member<fund_deposit_object, fund_id_type, &fund_deposit_object::fund_id>,
+                  member<fund_deposit_object, bool, &fund_deposit_object::finished>,
+                  member<object, object_id_type, &object::id>
+               >
+            >,
+            ordered_unique<tag<by_finished_end>,
+               composite_key<fund_deposit_object,
+                  member<fund_deposit_object, bool, &fund_deposit_object::finished>,
+                  member<fund_deposit_object, fc::time_point_sec, &fund_deposit_object::datetime_end>,
+                  member<object, object_id_type, &object::id>
+               >
+            >
          >
    > fund_deposit_object_index_type;
 
@@ -266,6 +282,7 @@ namespace graphene { namespace chain {
 
    struct by_name;
    struct by_owner;
+   struct by_enabled;
 
    /**
     * @ingroup object_index
@@ -275,7 +292,13 @@ namespace graphene { namespace chain {
          indexed_by<
             ordered_unique<tag<by_id>, member<object, object_id_type, &object::id>>,
             ordered_unique<tag<by_name>, member<fund_object, std::string, &fund_object::name>>,
-            ordered_unique<tag<by_owner>, member<fund_object, account_id_type, &fund_object::owner>>
+            ordered_unique<tag<by_owner>, member<fund_object, account_id_type, &fund_object::owner>>,
+            ordered_unique<tag<by_enabled>,
+               composite_key<fund_object,
+                  member<fund_object, bool, &fund_object::enabled>,
+                  member<object, object_id_type, &object::id>
+               >
+            >
          >
    > fund_object_index_type;
 
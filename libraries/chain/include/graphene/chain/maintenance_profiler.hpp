@@ -0,0 +1,83 @@
+// see LICENSE.txt
+
+#pragma once
+#include <graphene/chain/types.hpp>
+#include <graphene/db/object_database.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <chrono>
+#include <deque>
+
+namespace graphene { namespace chain {
+
+   struct maintenance_phase_profile
+   {
+      std::string name;
+      /// wall time spent in the phase, in microseconds
+      uint64_t    wall_time_us = 0;
+      /// number of objects created, modified or removed by the phase
+      uint64_t    objects_touched = 0;
+      /// number of entries in the undo state when the phase finished
+      uint64_t    undo_size = 0;
+   };
+
+   struct maintenance_profile
+   {
+      uint32_t                          block_num = 0;
+      fc::time_point_sec                block_time;
+      uint64_t                          wall_time_us = 0;
+      uint64_t                          objects_touched = 0;
+      uint64_t                          undo_size = 0;
+      vector<maintenance_phase_profile> phases;
+   };
+
+   /**
+    * @brief Records per-phase timings of chain maintenance
+    *
+    * Keeps the profiles of the last max_size() maintenances, oldest first.
+    */
+   class maintenance_profiler
+   {
+      public:
+         class scoped_phase
+         {
+            public:
+               scoped_phase( maintenance_profiler& profiler, const char* name );
+               ~scoped_phase();
+            private:
+               maintenance_profiler&                 _profiler;
+               const char*                           _name;
+               std::chrono::steady_clock::time_point _start;
+               uint64_t                              _start_changes;
+         };
+
+         maintenance_profiler( const graphene::db::object_database& db ) : _db(db) {}
+
+         void begin( uint32_t block_num, fc::time_point_sec block_time );
+         void end();
+
+         void   set_max_size( size_t new_max_size );
+         size_t max_size()const { return _max_size; }
+
+         const std::deque<maintenance_profile>& profiles()const { return _profiles; }
+         /// Writes the recorded profiles to a file as JSON
+         void save( const fc::path& file )const;
+
+      private:
+         uint64_t undo_size()const;
+
+         const graphene::db::object_database&  _db;
+         size_t                                _max_size = 32;
+         std::deque<maintenance_profile>       _profiles;
+         optional<maintenance_profile>         _current;
+         std::chrono::steady_clock::time_point _start;
+         uint64_t                              _start_changes = 0;
+   };
+
+} }
+
+FC_REFLECT( graphene::chain::maintenance_phase_profile, (name)(wall_time_us)(objects_touched)(undo_size) )
+FC_REFLECT( graphene::chain::maintenance_profile,
+            (block_num)(block_time)(wall_time_us)(objects_touched)(undo_size)(phases) )
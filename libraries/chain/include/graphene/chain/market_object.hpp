@@ -188,3 +188,6 @@ FC_REFLECT_TYPENAME( graphene::chain::force_settlement_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::limit_order_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::call_order_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::force_settlement_object )
+
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::limit_order_object )
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::call_order_object )
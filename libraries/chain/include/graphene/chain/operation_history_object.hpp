@@ -94,6 +94,7 @@ public:
    uint32_t                             sequence = 0; /// the operation position within the given account
    account_transaction_history_id_type  next;
    fc::time_point_sec                   block_time;
+   uint16_t                             op_type = 0; /// the operation's position in the operation variant
 
    //std::pair<account_id_type,operation_history_id_type>  account_op()const  { return std::tie( account, operation_id ); }
    //std::pair<account_id_type,uint32_t>                   account_seq()const { return std::tie( account, sequence );     }
@@ -102,6 +103,7 @@ public:
 struct by_time;
 struct by_seq;
 struct by_op;
+struct by_op_type;
 
 typedef multi_index_container<
    account_transaction_history_object,
@@ -119,6 +121,13 @@ typedef multi_index_container<
             member<account_transaction_history_object, account_id_type, &account_transaction_history_object::account>,
             member<account_transaction_history_object, operation_history_id_type, &account_transaction_history_object::operation_id>
          >
+      >,
+      ordered_unique<tag<by_op_type>,
+         composite_key<account_transaction_history_object,
+            member<account_transaction_history_object, account_id_type, &account_transaction_history_object::account>,
+            member<account_transaction_history_object, uint16_t, &account_transaction_history_object::op_type>,
+            member<account_transaction_history_object, uint32_t, &account_transaction_history_object::sequence>
+         >
       >
    >
 > account_transaction_history_multi_index_type;
@@ -135,3 +144,5 @@ FC_REFLECT_TYPENAME( graphene::chain::account_transaction_history_object )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::operation_history_object )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::account_transaction_history_object )
+
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::operation_history_object )
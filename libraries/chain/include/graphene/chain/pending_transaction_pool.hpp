@@ -0,0 +1,76 @@
+// see LICENSE.txt
+
+#pragma once
+#include <graphene/protocol/block.hpp>
+
+#include <graphene/chain/types.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+
+namespace graphene { namespace chain {
+
+   struct pending_transaction
+   {
+      explicit pending_transaction( processed_transaction t );
+
+      processed_transaction trx;
+      transaction_id_type   id;
+      fc::time_point_sec    expiration;
+      /// fc::raw::pack_size() of trx, which generate_block() checks against the maximum block size
+      size_t                packed_size;
+      /// fc::raw::pack_size() of trx.operation_results, the part of packed_size which changes when trx is applied again
+      size_t                results_size;
+   };
+
+   /**
+    *  @brief The transactions waiting to be included in a block, in the order they were received
+    *
+    *  A transaction is found by its id and the expired ones by their expiration, without going through the whole
+    *  pool. There is no index by fee payer and no per-account sequence: the transactions of an account keep their
+    *  order only because the whole pool is applied in the order it was received. Nothing tracks which pending
+    *  transactions a block affects either, so after each block all of them are applied again.
+    */
+   class pending_transaction_pool
+   {
+      public:
+         struct by_id;
+         struct by_expiration;
+         typedef boost::multi_index_container<
+            pending_transaction,
+            boost::multi_index::indexed_by<
+               boost::multi_index::sequenced<>,
+               boost::multi_index::hashed_unique< boost::multi_index::tag<by_id>,
+                  boost::multi_index::member<pending_transaction, transaction_id_type, &pending_transaction::id>,
+                  std::hash<fc::ripemd160> >,
+               boost::multi_index::ordered_non_unique< boost::multi_index::tag<by_expiration>,
+                  boost::multi_index::member<pending_transaction, fc::time_point_sec, &pending_transaction::expiration> >
+            >
+         > index_type;
+         typedef index_type::const_iterator const_iterator;
+
+         /// Appends @p trx, @return false if a transaction with its id is in the pool already
+         bool add( const processed_transaction& trx );
+         /// Appends the transactions of @p other which are not in this pool, their packed sizes are kept
+         void append( const pending_transaction_pool& other );
+
+         bool contains( const transaction_id_type& id )const;
+         /// Removes the transactions which expire before @p now, @return their number
+         size_t remove_expired( fc::time_point_sec now );
+
+         const_iterator begin()const { return _index.begin(); }
+         const_iterator end()const { return _index.end(); }
+         size_t size()const { return _index.size(); }
+         bool empty()const { return _index.empty(); }
+         void clear() { _index.clear(); }
+         void swap( pending_transaction_pool& other ) { _index.swap( other._index ); }
+         const index_type& indices()const { return _index; }
+
+      private:
+         index_type _index;
+   };
+
+} } // graphene::chain
@@ -74,3 +74,5 @@ MAP_OBJECT_ID_TO_TYPE(graphene::chain::proposal_object)
 FC_REFLECT_TYPENAME( graphene::chain::proposal_object )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::proposal_object )
+
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::proposal_object )
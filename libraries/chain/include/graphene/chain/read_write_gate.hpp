@@ -0,0 +1,49 @@
+// see LICENSE.txt
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Lets readers on other threads in between the changes to the chain state
+    *
+    * Readers share the gate, a writer holds it alone. A waiting writer keeps new readers out, so readers are only
+    * admitted between writes and can not delay a block for longer than the reads already running. The task holding
+    * the gate exclusively may take it again, as the writing methods of the database call each other.
+    *
+    * The fc tasks of a thread share its id, so the holder is told apart by its fc task. A task waiting for another
+    * task of its own thread yields to it instead of blocking the thread.
+    *
+    * Meets the Lockable and SharedLockable requirements, use it with std::unique_lock and std::shared_lock.
+    */
+   class read_write_gate
+   {
+      public:
+         void lock();
+         bool try_lock();
+         void unlock();
+
+         void lock_shared();
+         void unlock_shared();
+
+      private:
+         /// waits until @p ready, called with the mutex locked
+         void wait( std::unique_lock<std::mutex>& lock, const std::function<bool()>& ready );
+
+         std::mutex               _mutex;
+         std::condition_variable  _cv;
+         uint32_t                 _readers = 0;
+         uint32_t                 _waiting_writers = 0;
+         /// the task holding the gate exclusively, its thread and how many times it took the gate
+         const void*              _writer = nullptr;
+         std::thread::id          _writer_thread;
+         uint32_t                 _writer_depth = 0;
+   };
+
+} }
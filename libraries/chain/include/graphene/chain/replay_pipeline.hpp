@@ -0,0 +1,76 @@
+// see LICENSE.txt
+
+#pragma once
+#include <graphene/chain/block_database.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Prepares the blocks of a replay ahead of applying them
+    *
+    * A reader thread fetches and unpacks the blocks in order, worker threads then check their merkle roots and
+    * measure their sizes. At most @c capacity blocks are buffered ahead of the consumer, which takes them in order
+    * from next(). The block database must not be modified while the pipeline is alive.
+    */
+   class replay_pipeline
+   {
+      public:
+         struct item
+         {
+            /// invalid if the block does not exist or is past the last block
+            optional<signed_block> block;
+            /// packed size of the block
+            uint64_t               size = 0;
+            /// whether the transaction merkle root of the block has been verified
+            bool                   merkle_root_valid = false;
+         };
+
+         replay_pipeline( const block_database& blocks, uint32_t first_block_num, uint32_t last_block_num,
+                          size_t workers = 1, size_t capacity = 1024 );
+         ~replay_pipeline();
+
+         /**
+          * Waits for the next block in order, the pipeline stops after the first missing block
+          * @throws the exception which reading or processing the block threw on the pipeline's threads
+          */
+         item next();
+
+      private:
+         enum slot_state { slot_free, slot_read, slot_processing, slot_ready };
+         struct slot
+         {
+            slot_state         state = slot_free;
+            item               data;
+            /// thrown by next() in place of the item, set if reading or processing the block failed
+            std::exception_ptr error;
+         };
+
+         void read_loop();
+         void work_loop();
+         slot& slot_of( uint32_t block_num ) { return _slots[ block_num % _slots.size() ]; }
+
+         const block_database&    _blocks;
+         const uint32_t           _last_block_num;
+         std::vector<slot>        _slots;
+
+         std::mutex               _mutex;
+         std::condition_variable  _cv;
+         /// the next block to read, to process and to hand out
+         uint32_t                 _next_read;
+         uint32_t                 _next_work;
+         uint32_t                 _next_apply;
+         /// set when the reader has met a missing block
+         bool                     _gap = false;
+         bool                     _stopping = false;
+
+         std::thread              _reader;
+         std::vector<std::thread> _workers;
+   };
+
+} }
@@ -0,0 +1,46 @@
+// see LICENSE.txt
+
+#pragma once
+#include <graphene/protocol/transaction.hpp>
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace graphene { namespace chain {
+
+   using namespace graphene::protocol;
+
+   /**
+    * @brief Keys recovered from the signatures of transactions ahead of applying them
+    *
+    * Filled from the worker threads by database::precompute_parallel() and read when the signatures are checked.
+    * The keys are stored by the signature digest of the transaction along with the signatures they were recovered
+    * from, so a changed transaction or signature is recovered again. Keys which get() has to recover are stored as
+    * well. After each block the database keeps only the keys of the pending transactions, which it applies again; the
+    * transactions themselves carry nothing.
+    */
+   class signature_keys_cache
+   {
+      public:
+         /// Recovers the keys of @p trx and stores them, a failure is left to the check of the signatures
+         void recover( const signed_transaction& trx, const chain_id_type& chain_id );
+         /// @return the stored keys of @p trx, or the keys recovered and stored now if there are none
+         flat_set<public_key_type> get( const signed_transaction& trx, const chain_id_type& chain_id )const;
+         bool contains( const signed_transaction& trx, const chain_id_type& chain_id )const;
+         /// Drops the keys of the transactions whose signature digests are not in @p digests
+         void retain( const std::unordered_set<digest_type>& digests );
+         void clear();
+
+      private:
+         struct entry
+         {
+            vector<signature_type>    signatures;
+            flat_set<public_key_type> keys;
+         };
+
+         mutable std::mutex                       _mutex;
+         mutable std::unordered_map<digest_type, entry> _entries;
+   };
+
+} }
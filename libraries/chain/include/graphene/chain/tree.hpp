@@ -59,6 +59,8 @@ class referral_tree {
     asset get_mature_balance(account_id_type owner);
     asset get_balance(account_id_type owner);
     void set_bonus_percents();
+    /** sets the rank and bonus percent of a leaf of form_old() */
+    static void set_bonus_percent(leaf_info& leaf);
     void set_bonus_percents_new();
 };
 
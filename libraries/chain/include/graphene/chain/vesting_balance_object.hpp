@@ -193,6 +193,8 @@ GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::linear_vesting_policy
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::cdd_vesting_policy )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::chain::vesting_balance_object )
 
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::chain::vesting_balance_object )
+
 /**
 FC_REFLECT(graphene::chain::linear_vesting_policy,
            (begin_timestamp)
@@ -215,4 +217,4 @@ FC_REFLECT_DERIVED(graphene::chain::vesting_balance_object, (graphene::db::objec
                    (balance)
                    (policy)
                   )
-*/
\ No newline at end of file
+*/
@@ -0,0 +1,77 @@
+// see LICENSE.txt
+
+#include <graphene/chain/maintenance_profiler.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <iostream>
+
+namespace graphene { namespace chain {
+
+maintenance_profiler::scoped_phase::scoped_phase( maintenance_profiler& profiler, const char* name )
+   : _profiler(profiler), _name(name), _start(std::chrono::steady_clock::now()),
+     _start_changes(profiler._db.object_changes())
+{}
+
+maintenance_profiler::scoped_phase::~scoped_phase()
+{
+   auto elapsed = std::chrono::steady_clock::now() - _start;
+   if( !_profiler._current.valid() )
+      return;
+
+   maintenance_phase_profile phase;
+   phase.name = _name;
+   phase.wall_time_us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+   phase.objects_touched = _profiler._db.object_changes() - _start_changes;
+   phase.undo_size = _profiler.undo_size();
+   _profiler._current->phases.push_back( std::move(phase) );
+
+#ifdef DEBUG_TIMES
+   std::cout << _name << "(): " << std::chrono::duration_cast<std::chrono::seconds>(elapsed).count()
+             << " seconds" << std::endl;
+#endif
+}
+
+void maintenance_profiler::begin( uint32_t block_num, fc::time_point_sec block_time )
+{
+   _current = maintenance_profile();
+   _current->block_num = block_num;
+   _current->block_time = block_time;
+   _start = std::chrono::steady_clock::now();
+   _start_changes = _db.object_changes();
+}
+
+void maintenance_profiler::end()
+{
+   if( !_current.valid() )
+      return;
+
+   _current->wall_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+         std::chrono::steady_clock::now() - _start ).count();
+   _current->objects_touched = _db.object_changes() - _start_changes;
+   _current->undo_size = undo_size();
+
+   _profiles.push_back( std::move(*_current) );
+   _current.reset();
+   while( _profiles.size() > _max_size )
+      _profiles.pop_front();
+}
+
+void maintenance_profiler::set_max_size( size_t new_max_size )
+{
+   _max_size = new_max_size;
+   while( _profiles.size() > _max_size )
+      _profiles.pop_front();
+}
+
+void maintenance_profiler::save( const fc::path& file )const
+{
+   fc::json::save_to_file( _profiles, file );
+}
+
+uint64_t maintenance_profiler::undo_size()const
+{
+   return _db._undo_db.head_size();
+}
+
+} }
@@ -43,3 +43,6 @@ FC_REFLECT_DERIVED_NO_TYPENAME( graphene::chain::force_settlement_object,
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::limit_order_object )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::call_order_object )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::force_settlement_object )
+
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::chain::limit_order_object )
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::chain::call_order_object )
@@ -0,0 +1,40 @@
+// see LICENSE.txt
+
+#include <graphene/chain/pending_transaction_pool.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace graphene { namespace chain {
+
+pending_transaction::pending_transaction( processed_transaction t )
+: trx( std::move(t) ), id( trx.id() ), expiration( trx.expiration ), packed_size( fc::raw::pack_size( trx ) ),
+  results_size( fc::raw::pack_size( trx.operation_results ) )
+{
+}
+
+bool pending_transaction_pool::add( const processed_transaction& trx )
+{
+   return _index.push_back( pending_transaction( trx ) ).second;
+}
+
+void pending_transaction_pool::append( const pending_transaction_pool& other )
+{
+   for( const pending_transaction& pending : other )
+      _index.push_back( pending );
+}
+
+bool pending_transaction_pool::contains( const transaction_id_type& id )const
+{
+   return _index.get<by_id>().find( id ) != _index.get<by_id>().end();
+}
+
+size_t pending_transaction_pool::remove_expired( fc::time_point_sec now )
+{
+   auto& by_exp = _index.get<by_expiration>();
+   const auto end = by_exp.lower_bound( now );
+   const size_t count = std::distance( by_exp.begin(), end );
+   by_exp.erase( by_exp.begin(), end );
+   return count;
+}
+
+} } // graphene::chain
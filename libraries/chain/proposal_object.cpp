@@ -79,3 +79,5 @@ FC_REFLECT_DERIVED_NO_TYPENAME( graphene::chain::proposal_object, (graphene::cha
                     (available_key_approvals) )
 
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::proposal_object )
+
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::chain::proposal_object )
@@ -0,0 +1,104 @@
+// see LICENSE.txt
+
+#include <graphene/chain/read_write_gate.hpp>
+
+#include <fc/thread/thread.hpp>
+#include <fc/thread/thread_specific.hpp>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   /// a token of the fc task running, or of the thread outside of tasks, the tasks of a thread share its id
+   fc::task_specific_ptr<char> task_token;
+
+   const void* current_task()
+   {
+      if( !task_token )
+         task_token.reset( new char() );
+      return task_token.get();
+   }
+
+}
+
+void read_write_gate::wait( std::unique_lock<std::mutex>& lock, const std::function<bool()>& ready )
+{
+   while( !ready() )
+   {
+      if( _writer_depth > 0 && _writer_thread == std::this_thread::get_id() )
+      {
+         // the writer is another task of this thread, it only gets on if this one yields
+         lock.unlock();
+         fc::yield();
+         lock.lock();
+      }
+      else
+         _cv.wait( lock );
+   }
+}
+
+void read_write_gate::lock()
+{
+   const void* self = current_task();
+   std::unique_lock<std::mutex> lock( _mutex );
+   if( _writer_depth > 0 && _writer == self )
+   {
+      ++_writer_depth;
+      return;
+   }
+   ++_waiting_writers;
+   wait( lock, [this]() { return _writer_depth == 0 && _readers == 0; } );
+   --_waiting_writers;
+   _writer = self;
+   _writer_thread = std::this_thread::get_id();
+   _writer_depth = 1;
+}
+
+bool read_write_gate::try_lock()
+{
+   const void* self = current_task();
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( _writer_depth > 0 && _writer == self )
+   {
+      ++_writer_depth;
+      return true;
+   }
+   if( _writer_depth > 0 || _readers > 0 )
+      return false;
+   _writer = self;
+   _writer_thread = std::this_thread::get_id();
+   _writer_depth = 1;
+   return true;
+}
+
+void read_write_gate::unlock()
+{
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      if( --_writer_depth > 0 )
+         return;
+      _writer = nullptr;
+      _writer_thread = std::thread::id();
+   }
+   _cv.notify_all();
+}
+
+void read_write_gate::lock_shared()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   wait( lock, [this]() { return _writer_depth == 0 && _waiting_writers == 0; } );
+   ++_readers;
+}
+
+void read_write_gate::unlock_shared()
+{
+   bool last = false;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      last = ( --_readers == 0 );
+   }
+   if( last )
+      _cv.notify_all();
+}
+
+} }
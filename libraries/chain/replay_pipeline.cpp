@@ -0,0 +1,130 @@
+// see LICENSE.txt
+
+#include <graphene/chain/replay_pipeline.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace graphene { namespace chain {
+
+replay_pipeline::replay_pipeline( const block_database& blocks, uint32_t first_block_num, uint32_t last_block_num,
+                                  size_t workers, size_t capacity )
+   : _blocks(blocks), _last_block_num(last_block_num), _slots( std::max<size_t>( capacity, 1 ) ),
+     _next_read(first_block_num), _next_work(first_block_num), _next_apply(first_block_num)
+{
+   _reader = std::thread( [this]() { read_loop(); } );
+   for( size_t i = 0; i < std::max<size_t>( workers, 1 ); ++i )
+      _workers.emplace_back( [this]() { work_loop(); } );
+}
+
+replay_pipeline::~replay_pipeline()
+{
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _stopping = true;
+   }
+   _cv.notify_all();
+   _reader.join();
+   for( auto& worker : _workers )
+      worker.join();
+}
+
+void replay_pipeline::read_loop()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   while( !_stopping && !_gap && _next_read <= _last_block_num )
+   {
+      const uint32_t block_num = _next_read;
+      slot& s = slot_of( block_num );
+      if( s.state != slot_free )
+      {
+         _cv.wait( lock );
+         continue;
+      }
+
+      lock.unlock();
+      optional<signed_block> block;
+      std::exception_ptr error;
+      try
+      {
+         block = _blocks.fetch_by_number( block_num );
+      }
+      catch( ... )
+      {
+         error = std::current_exception();
+      }
+      lock.lock();
+
+      s.data = item();
+      s.data.block = std::move( block );
+      s.error = error;
+      s.state = slot_read;
+      // a block which cannot be read ends the pipeline like a missing one, next() throws the error
+      _gap = !s.data.block.valid();
+      ++_next_read;
+      _cv.notify_all();
+   }
+}
+
+void replay_pipeline::work_loop()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   while( !_stopping )
+   {
+      if( _next_work == _next_read )
+      {
+         // nothing is left to process once the reader has finished
+         if( _gap || _next_read > _last_block_num )
+            return;
+         _cv.wait( lock );
+         continue;
+      }
+
+      slot& s = slot_of( _next_work++ );
+      s.state = slot_processing;
+      lock.unlock();
+      std::exception_ptr error;
+      try
+      {
+         if( s.data.block.valid() )
+         {
+            const signed_block& block = *s.data.block;
+            s.data.size = fc::raw::pack_size( block );
+            s.data.merkle_root_valid = block.transaction_merkle_root == block.calculate_merkle_root();
+         }
+      }
+      catch( ... )
+      {
+         error = std::current_exception();
+      }
+      lock.lock();
+
+      if( error )
+         s.error = error;
+
+      s.state = slot_ready;
+      _cv.notify_all();
+   }
+}
+
+replay_pipeline::item replay_pipeline::next()
+{
+   std::unique_lock<std::mutex> lock( _mutex );
+   if( _next_apply > _last_block_num || ( _gap && _next_apply == _next_read ) )
+      return item();
+
+   slot& s = slot_of( _next_apply );
+   _cv.wait( lock, [&]() { return s.state == slot_ready; } );
+   item result = std::move( s.data );
+   std::exception_ptr error = s.error;
+   s.data = item();
+   s.error = nullptr;
+   s.state = slot_free;
+   ++_next_apply;
+   _cv.notify_all();
+   // the errors of the reader and the workers are thrown on the thread applying the blocks
+   if( error )
+      std::rethrow_exception( error );
+   return result;
+}
+
+} }
@@ -0,0 +1,66 @@
+// see LICENSE.txt
+
+#include <graphene/chain/signature_keys_cache.hpp>
+
+namespace graphene { namespace chain {
+
+void signature_keys_cache::recover( const signed_transaction& trx, const chain_id_type& chain_id )
+{
+   entry recovered;
+   try
+   {
+      recovered.keys = trx.get_signature_keys( chain_id );
+   }
+   catch( const fc::exception& )
+   {
+      return;
+   }
+   recovered.signatures = trx.signatures;
+   const digest_type digest = trx.sig_digest( chain_id );
+   std::lock_guard<std::mutex> lock( _mutex );
+   _entries[digest] = std::move( recovered );
+}
+
+flat_set<public_key_type> signature_keys_cache::get( const signed_transaction& trx, const chain_id_type& chain_id )const
+{
+   const digest_type digest = trx.sig_digest( chain_id );
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto itr = _entries.find( digest );
+      if( itr != _entries.end() && itr->second.signatures == trx.signatures )
+         return itr->second.keys;
+   }
+   entry recovered;
+   recovered.keys = trx.get_signature_keys( chain_id );
+   recovered.signatures = trx.signatures;
+   std::lock_guard<std::mutex> lock( _mutex );
+   return ( _entries[digest] = std::move( recovered ) ).keys;
+}
+
+bool signature_keys_cache::contains( const signed_transaction& trx, const chain_id_type& chain_id )const
+{
+   const digest_type digest = trx.sig_digest( chain_id );
+   std::lock_guard<std::mutex> lock( _mutex );
+   auto itr = _entries.find( digest );
+   return itr != _entries.end() && itr->second.signatures == trx.signatures;
+}
+
+void signature_keys_cache::retain( const std::unordered_set<digest_type>& digests )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   for( auto itr = _entries.begin(); itr != _entries.end(); )
+   {
+      if( digests.count( itr->first ) )
+         ++itr;
+      else
+         itr = _entries.erase( itr );
+   }
+}
+
+void signature_keys_cache::clear()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _entries.clear();
+}
+
+} }
@@ -127,7 +127,7 @@ FC_REFLECT_DERIVED_NO_TYPENAME( graphene::chain::operation_history_object, (grap
                     (op)(result)(block_num)(trx_in_block)(op_in_trx)(virtual_op)(block_time) )
 
 FC_REFLECT_DERIVED_NO_TYPENAME( graphene::chain::account_transaction_history_object, (graphene::chain::object),
-                    (account)(operation_id)(sequence)(next)(block_time) )
+                    (account)(operation_id)(sequence)(next)(block_time)(op_type) )
 
 FC_REFLECT_DERIVED_NO_TYPENAME(
    graphene::chain::special_authority_object,
@@ -247,3 +247,5 @@ GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::witness_schedule_obj
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::settings_object )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::worker_object )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::chain::witnesses_info_object )
+
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::chain::operation_history_object )
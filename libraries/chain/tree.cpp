@@ -79,44 +79,48 @@ namespace graphene { namespace chain {
 
   void referral_tree::set_bonus_percents() {
      for (auto &leaf: tree_data) {
-        if (leaf.balance < 200 * PRECISION) continue;
-        // if (leaf.mature_balance == 0) continue;
-        if (leaf.level_1_partners < 5) continue;
-        if (leaf.level_2_partners >= 25) {
-           if (leaf.balance < 500 * PRECISION) continue;
-           if (leaf.all_partners < 125) {
-              leaf.rank = "B";
-              leaf.bonus_percent = 0.2;
-           } else if (leaf.all_partners < 625) {
-              if (leaf.balance >= 1000 * PRECISION) {
-                 leaf.rank = "C";
-                 leaf.bonus_percent = 0.15;
-              }
-           } else if (leaf.all_partners < 3125) {
-              if (leaf.balance >= 2000 * PRECISION) {
-                 leaf.rank = "D";
-                 leaf.bonus_percent = 0.10;
-              }
-           } else if (leaf.all_partners < 15625) {
-              if (leaf.balance >= 3000 * PRECISION) {
-                 leaf.rank = "E";
-                 leaf.bonus_percent = 0.05;
-              }
-           } else if (leaf.all_partners < 78125) {
-              if (leaf.balance >= 4000 * PRECISION) {
-                 leaf.rank = "F";
-                 leaf.bonus_percent = 0.025;
-              }
-           } else {
-              if (leaf.balance >= 5000 * PRECISION) {
-                 leaf.rank = "G";
-                 leaf.bonus_percent = 0.025;
-              }
+        set_bonus_percent(leaf);
+     }
+  }
+
+  void referral_tree::set_bonus_percent(leaf_info& leaf) {
+     if (leaf.balance < 200 * PRECISION) return;
+     // if (leaf.mature_balance == 0) return;
+     if (leaf.level_1_partners < 5) return;
+     if (leaf.level_2_partners >= 25) {
+        if (leaf.balance < 500 * PRECISION) return;
+        if (leaf.all_partners < 125) {
+           leaf.rank = "B";
+           leaf.bonus_percent = 0.2;
+        } else if (leaf.all_partners < 625) {
+           if (leaf.balance >= 1000 * PRECISION) {
+              leaf.rank = "C";
+              leaf.bonus_percent = 0.15;
+           }
+        } else if (leaf.all_partners < 3125) {
+           if (leaf.balance >= 2000 * PRECISION) {
+              leaf.rank = "D";
+              leaf.bonus_percent = 0.10;
+           }
+        } else if (leaf.all_partners < 15625) {
+           if (leaf.balance >= 3000 * PRECISION) {
+              leaf.rank = "E";
+              leaf.bonus_percent = 0.05;
+           }
+        } else if (leaf.all_partners < 78125) {
+           if (leaf.balance >= 4000 * PRECISION) {
+              leaf.rank = "F";
+              leaf.bonus_percent = 0.025;
            }
         } else {
-           leaf.rank = "A";
-           leaf.bonus_percent = 0.25;
+           if (leaf.balance >= 5000 * PRECISION) {
+              leaf.rank = "G";
+              leaf.bonus_percent = 0.025;
+           }
         }
+     } else {
+        leaf.rank = "A";
+        leaf.bonus_percent = 0.25;
      }
   }
 
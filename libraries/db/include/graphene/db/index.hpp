@@ -76,7 +76,14 @@ namespace graphene { namespace db {
           *  Opens the index loading objects from a file
           */
          virtual void open( const fc::path& db ) = 0;
+         /** Called once the indexes of all types have been opened, the objects of other types can be looked up */
+         virtual void all_objects_loaded() {}
          virtual void save( const fc::path& db ) = 0;
+         /**
+          *  Saves objects packed by object::pack() in the format open() reads, the index itself is not inspected
+          */
+         virtual void save( const fc::path& db, object_id_type next_id,
+                            const std::vector<std::vector<char>>& packed_objects )const = 0;
 
 
 
@@ -121,6 +128,12 @@ namespace graphene { namespace db {
       public:
          virtual ~secondary_index(){};
          virtual void object_inserted( const object& obj ){};
+         /**
+          *  Called for each object opened from disk. The indexes of other types are opened in parallel, so this must not
+          *  look up their objects, which is left to all_objects_loaded().
+          */
+         virtual void object_loaded( const object& obj ){ object_inserted( obj ); };
+         virtual void all_objects_loaded(){};
          virtual void object_removed( const object& obj ){};
          virtual void about_to_modify( const object& before ){};
          virtual void object_modified( const object& after  ){};
@@ -358,14 +371,32 @@ namespace graphene { namespace db {
             });
          }
 
+         virtual void save( const path& db, object_id_type next_id,
+                            const std::vector<std::vector<char>>& packed_objects )const override
+         {
+            std::ofstream out( db.generic_string(),
+                               std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+            FC_ASSERT( out );
+            fc::raw::pack( out, next_id );
+            fc::raw::pack( out, get_object_version() );
+            for( const auto& packed : packed_objects )
+               fc::raw::pack( out, packed );
+         }
+
          virtual const object&  load( const std::vector<char>& data )override
          {
             const auto& result = DerivedIndex::insert( fc::raw::unpack<object_type>( data ) );
             for( const auto& item : _sindex )
-               item->object_inserted( result );
+               item->object_loaded( result );
             return result;
          }
 
+         virtual void all_objects_loaded()override
+         {
+            for( const auto& item : _sindex )
+               item->all_objects_loaded();
+         }
+
 
          virtual const object&  create(const std::function<void(object&)>& constructor )override
          {
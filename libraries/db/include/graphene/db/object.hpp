@@ -60,6 +60,8 @@ namespace graphene { namespace db {
          virtual variant            to_variant()const  = 0;
          virtual vector<char>       pack()const = 0;
          virtual fc::uint128_t      hash()const = 0;
+         /// @return a new object of the same type unpacked from @p data
+         virtual unique_ptr<object> unpack_clone( const vector<char>& data )const = 0;
    };
 
    /**
@@ -88,6 +90,12 @@ namespace graphene { namespace db {
              auto tmp = this->pack();
              return fc::city_hash_crc_128( tmp.data(), tmp.size() );
          }
+         virtual unique_ptr<object> unpack_clone( const vector<char>& data )const
+         {
+            unique_ptr<DerivedClass> result( new DerivedClass() );
+            fc::raw::unpack( data, *result, MAX_NESTING );
+            return unique_ptr<object>( std::move( result ) );
+         }
    };
 
    typedef flat_map<uint8_t, object_id_type> annotation_map;
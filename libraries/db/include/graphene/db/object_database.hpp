@@ -11,6 +11,14 @@
 
 namespace graphene { namespace db {
 
+   /// Packed objects of one index, see object_database::capture()
+   struct packed_index
+   {
+      const index*                   idx = nullptr;
+      object_id_type                 next_id;
+      std::vector<std::vector<char>> objects;
+   };
+
    /**
     *   @class object_database
     *   @brief maintains a set of indexed objects that can be modified with multi-level rollback support
@@ -29,7 +37,17 @@ namespace graphene { namespace db {
           * Saves the complete state of the object_database to disk, this could take a while
           */
          void flush();
+
+         /**
+          * Packs all objects as they were before the newest @p undo_depth undo states. The result does not refer to
+          * the objects, so it can be saved by another thread while the database keeps changing.
+          */
+         std::vector<packed_index> capture( size_t undo_depth = 0 )const;
+         /// Saves a captured state to @p dir in the layout open() reads
+         static void save( const std::vector<packed_index>& state, const fc::path& dir );
          void wipe(const fc::path& data_dir); // remove from disk
+         /// Removes all objects from the indexes and resets their next ids, without undo history
+         void clear();
          void close();
 
          template<typename T, typename F>
@@ -130,6 +148,9 @@ namespace graphene { namespace db {
 
          void pop_undo();
 
+         /// Number of objects created, modified or removed since the database was constructed
+         uint64_t object_changes()const { return _object_changes; }
+
          fc::path get_data_dir()const { return _data_dir; }
 
          bool replay_in_process() const { return _is_replay_process; }
@@ -166,6 +187,7 @@ namespace graphene { namespace db {
 
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+         uint64_t                                                  _object_changes = 0;
    };
 
 } } // graphene::db
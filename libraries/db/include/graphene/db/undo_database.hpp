@@ -2,6 +2,7 @@
 
 #pragma once
 #include <graphene/db/object.hpp>
+#include <bitset>
 #include <deque>
 #include <fc/exception/exception.hpp>
 
@@ -11,9 +12,33 @@ using std::unordered_map;
 using fc::flat_set;
 class object_database;
 
+/**
+ * The old value of an object whose type keeps deltas, see undo_database::keep_deltas().
+ *
+ * While its undo state is the head, the complete packed old value is kept. Once the state above it packs the object
+ * for its own old value, or is itself followed by another state, only the bytes between the common prefix and suffix
+ * with the object's packed value at the end of the state are kept. That value is the one the object has again when
+ * the state is undone, since all newer states are undone first. Reusing the packed value of the state above keeps an
+ * object changed in every block to one pack per block, this saves memory but not the cost of packing.
+ */
+struct packed_delta
+{
+   bool                 relative = false;
+   /// number of bytes shared with the base at the front and at the back
+   uint32_t             prefix = 0;
+   uint32_t             suffix = 0;
+   std::vector<char>    bytes;
+
+   /// @return the packed old value, given the packed value of the object at the end of the undo state
+   std::vector<char> old_value( const std::vector<char>& base )const;
+   void              make_relative( const std::vector<char>& base );
+   void              make_absolute( const std::vector<char>& base );
+};
+
 struct undo_state
 {
    unordered_map<object_id_type, unique_ptr<object> > old_values;
+   unordered_map<object_id_type, packed_delta>        old_deltas;
    unordered_map<object_id_type, object_id_type>      old_index_next_ids;
    std::unordered_set<object_id_type>                 new_ids;
    unordered_map<object_id_type, unique_ptr<object> > removed;
@@ -64,6 +89,20 @@ public:
    void    disable();
    void    enable();
    bool    enabled()const { return !_disabled; }
+   /** Forgets the undo states of the committed sessions, the current state cannot be undone past this point */
+   void    discard_history();
+
+   /**
+    * Old values of objects of the given type are kept as packed_delta instead of clones. This suits objects holding
+    * large containers of which a modification changes only a small part.
+    */
+   void    keep_deltas( uint8_t space_id, uint8_t type_id );
+   template<typename ObjectType>
+   void    keep_deltas() { keep_deltas( ObjectType::space_id, ObjectType::type_id ); }
+   bool    keeps_deltas( object_id_type id )const { return _delta_types.test( (id.space() << 8) | id.type() ); }
+
+   /// @return the value @p obj had before the changes of @p state, which has a delta for it
+   static unique_ptr<object> old_value( const object& obj, const packed_delta& delta );
 
    session start_undo_session( bool force_enable = false );
    /**
@@ -102,6 +141,10 @@ public:
    uint32_t active_sessions()const { return _active_sessions; }
 
    const undo_state& head()const;
+   /// The undo state @p depth levels below the head, 0 being the head
+   const undo_state& at_depth( size_t depth )const;
+   /// Number of objects saved in the head undo state, 0 if there is none
+   size_t head_size()const;
 
 private:
    void undo();
@@ -113,6 +156,7 @@ private:
    std::deque<undo_state>  _stack;
    object_database&        _db;
    size_t                  _max_size = 256;
+   std::bitset<0x10000>    _delta_types;
 };
 
 } } // graphene::db
@@ -6,6 +6,10 @@
 #include <fc/container/flat.hpp>
 #include <fc/thread/parallel.hpp>
 
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
 namespace graphene { namespace db {
 
 object_database::object_database()
@@ -77,6 +81,88 @@ void object_database::flush()
    fc::remove_all( _data_dir / "object_database.old" );
 }
 
+std::vector<packed_index> object_database::capture( size_t undo_depth )const
+{ try {
+   FC_ASSERT( undo_depth <= _undo_db.size() );
+
+   // walk the undo states from the newest to the oldest, so that the oldest saved value of an object wins
+   std::unordered_map<object_id_type, fc::optional<std::vector<char>>> restored;
+   std::unordered_map<object_id_type, object_id_type> restored_next_ids;
+   for( size_t depth = 0; depth < undo_depth; ++depth )
+   {
+      const undo_state& state = _undo_db.at_depth( depth );
+      for( const auto& item : state.old_values )
+         restored[item.first] = item.second->pack();
+      for( const auto& item : state.old_deltas )
+      {
+         // a delta is relative to the value at the end of its state, that is the one restored from a newer state
+         std::vector<char> base;
+         if( item.second.relative )
+         {
+            auto newer = restored.find( item.first );
+            base = newer != restored.end() ? *newer->second : get_object( item.first ).pack();
+         }
+         restored[item.first] = item.second.old_value( base );
+      }
+      for( const auto& id : state.new_ids )
+         restored[id] = fc::optional<std::vector<char>>();
+      for( const auto& item : state.removed )
+         restored[item.first] = item.second->pack();
+      for( const auto& item : state.old_index_next_ids )
+         restored_next_ids[item.first] = item.second;
+   }
+
+   std::vector<packed_index> result;
+   std::map<std::pair<uint8_t,uint8_t>, size_t> positions;
+   for( uint32_t space = 0; space < _index.size(); ++space )
+      for( uint32_t type = 0; type < _index[space].size(); ++type )
+         if( _index[space][type] )
+         {
+            positions[ std::make_pair( uint8_t(space), uint8_t(type) ) ] = result.size();
+            result.emplace_back();
+            result.back().idx = _index[space][type].get();
+            auto itr = restored_next_ids.find( object_id_type( space, type, 0 ) );
+            result.back().next_id = itr != restored_next_ids.end() ? itr->second
+                                                                   : _index[space][type]->get_next_id();
+         }
+
+   // the indexes are only read, so they are packed in parallel
+   std::atomic<size_t> next_index( 0 );
+   auto pack_indexes = [&]()
+   {
+      for( size_t i = next_index++; i < result.size(); i = next_index++ )
+      {
+         packed_index& packed = result[i];
+         packed.idx->inspect_all_objects( [&]( const object& o ) {
+            if( restored.find( o.id ) == restored.end() )
+               packed.objects.push_back( o.pack() );
+         });
+      }
+   };
+   std::vector<std::thread> threads;
+   for( size_t i = 1; i < std::max( 1u, std::thread::hardware_concurrency() ); ++i )
+      threads.emplace_back( pack_indexes );
+   pack_indexes();
+   for( auto& thread : threads )
+      thread.join();
+
+   for( auto& item : restored )
+      if( item.second.valid() )
+         result[ positions.at( std::make_pair( item.first.space(), item.first.type() ) ) ].objects
+            .push_back( std::move( *item.second ) );
+   return result;
+} FC_CAPTURE_AND_RETHROW( (undo_depth) ) }
+
+void object_database::save( const std::vector<packed_index>& state, const fc::path& dir )
+{ try {
+   for( const auto& packed : state )
+   {
+      const fc::path space_dir = dir / fc::to_string( packed.idx->object_space_id() );
+      fc::create_directories( space_dir );
+      packed.idx->save( space_dir / fc::to_string( packed.idx->object_type_id() ), packed.next_id, packed.objects );
+   }
+} FC_CAPTURE_AND_RETHROW( (dir) ) }
+
 void object_database::wipe(const fc::path& data_dir)
 {
    close();
@@ -85,6 +171,20 @@ void object_database::wipe(const fc::path& data_dir)
    ilog("Done wiping object database.");
 }
 
+void object_database::clear()
+{
+   for( uint32_t space = 0; space < _index.size(); ++space )
+      for( uint32_t type = 0; type < _index[space].size(); ++type )
+         if( _index[space][type] )
+         {
+            std::vector<const object*> objects;
+            _index[space][type]->inspect_all_objects( [&]( const object& o ) { objects.push_back( &o ); } );
+            for( const object* o : objects )
+               _index[space][type]->remove( *o );
+            _index[space][type]->set_next_id( object_id_type( space, type, 0 ) );
+         }
+}
+
 void object_database::open(const fc::path& data_dir)
 { try {
    _data_dir = data_dir;
@@ -105,6 +205,10 @@ void object_database::open(const fc::path& data_dir)
          }
    for( auto& task : tasks )
    task.wait();
+   for( uint32_t space = 0; space < _index.size(); ++space )
+      for( uint32_t type = 0; type  < _index[space].size(); ++type )
+         if( _index[space][type] )
+            _index[space][type]->all_objects_loaded();
    ilog( "Done opening object database." );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
@@ -117,16 +221,19 @@ void object_database::pop_undo()
 
 void object_database::save_undo( const object& obj )
 {
+   ++_object_changes;
    _undo_db.on_modify( obj );
 }
 
 void object_database::save_undo_add( const object& obj )
 {
+   ++_object_changes;
    _undo_db.on_create( obj );
 }
 
 void object_database::save_undo_remove(const object& obj)
 {
+   ++_object_changes;
    _undo_db.on_remove( obj );
 }
 
@@ -6,9 +6,67 @@
 
 namespace graphene { namespace db {
 
+std::vector<char> packed_delta::old_value( const std::vector<char>& base )const
+{
+   if( !relative )
+      return bytes;
+   FC_ASSERT( size_t(prefix) + suffix <= base.size() );
+   std::vector<char> result;
+   result.reserve( prefix + bytes.size() + suffix );
+   result.insert( result.end(), base.begin(), base.begin() + prefix );
+   result.insert( result.end(), bytes.begin(), bytes.end() );
+   result.insert( result.end(), base.end() - suffix, base.end() );
+   return result;
+}
+
+void packed_delta::make_relative( const std::vector<char>& base )
+{
+   if( relative )
+      return;
+   const size_t common = std::min( bytes.size(), base.size() );
+   size_t front = 0;
+   while( front < common && bytes[front] == base[front] )
+      ++front;
+   size_t back = 0;
+   while( back < common - front && bytes[bytes.size() - 1 - back] == base[base.size() - 1 - back] )
+      ++back;
+   bytes = std::vector<char>( bytes.begin() + front, bytes.end() - back );
+   prefix = front;
+   suffix = back;
+   relative = true;
+}
+
+void packed_delta::make_absolute( const std::vector<char>& base )
+{
+   if( !relative )
+      return;
+   bytes = old_value( base );
+   prefix = 0;
+   suffix = 0;
+   relative = false;
+}
+
 void undo_database::enable()  { _disabled = false; }
 void undo_database::disable() { _disabled = true; }
 
+void undo_database::discard_history()
+{
+   FC_ASSERT( _active_sessions == 0 );
+   _stack.clear();
+}
+
+void undo_database::keep_deltas( uint8_t space_id, uint8_t type_id )
+{
+   _delta_types.set( (space_id << 8) | type_id );
+}
+
+unique_ptr<object> undo_database::old_value( const object& obj, const packed_delta& delta )
+{
+   auto result = obj.unpack_clone( delta.old_value( delta.relative ? obj.pack() : std::vector<char>() ) );
+   result->id = obj.id;
+   return result;
+}
+
 undo_database::~undo_database() {}
 
 undo_database::session::~session()
@@ -34,6 +92,16 @@ undo_database::session undo_database::start_undo_session( bool force_enable )
    while( size() > max_size() )
       _stack.pop_front();
 
+   // deltas become relative in on_modify() when the state above packs the object anyway, the objects left
+   // unchanged by the state that stops being the head still have the value the deltas below it are relative to
+   if( _stack.size() >= 2 )
+   {
+      const undo_state& head = _stack.back();
+      for( auto& item : _stack[_stack.size() - 2].old_deltas )
+         if( !item.second.relative && head.removed.find( item.first ) == head.removed.end() )
+            item.second.make_relative( _db.get_object( item.first ).pack() );
+   }
+
    _stack.emplace_back();
    ++_active_sessions;
    return session(*this, disable_on_exit );
@@ -62,6 +130,25 @@ void undo_database::on_modify( const object& obj )
       return;
    auto itr =  state.old_values.find(obj.id);
    if( itr != state.old_values.end() ) return;
+   if( keeps_deltas( obj.id ) )
+   {
+      auto delta = state.old_deltas.find( obj.id );
+      if( delta != state.old_deltas.end() )
+      {
+         // this state became the head again, the object is about to change
+         delta->second.make_absolute( obj.pack() );
+         return;
+      }
+      const std::vector<char>& packed = state.old_deltas[obj.id].bytes = obj.pack();
+      // the value before this state is the one the delta of the state below is relative to
+      if( _stack.size() >= 2 )
+      {
+         auto below = _stack[_stack.size() - 2].old_deltas.find( obj.id );
+         if( below != _stack[_stack.size() - 2].old_deltas.end() && !below->second.relative )
+            below->second.make_relative( packed );
+      }
+      return;
+   }
    state.old_values[obj.id] = obj.clone();
 }
 void undo_database::on_remove( const object& obj )
@@ -82,6 +169,13 @@ void undo_database::on_remove( const object& obj )
       state.old_values.erase(obj.id);
       return;
    }
+   auto delta = state.old_deltas.find( obj.id );
+   if( delta != state.old_deltas.end() )
+   {
+      state.removed[obj.id] = old_value( obj, delta->second );
+      state.old_deltas.erase( delta );
+      return;
+   }
    if( state.removed.count(obj.id) > 0 ) return;
    state.removed[obj.id] = obj.clone();
 }
@@ -97,6 +191,12 @@ void undo_database::undo()
       {
          _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
       }
+      for( auto& item : state.old_deltas )
+      {
+         const object& current = _db.get_object( item.first );
+         auto value = old_value( current, item.second );
+         _db.modify( current, [&]( object& obj ){ obj.move_from( *value ); } );
+      }
 
       for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
       {
@@ -131,7 +231,7 @@ void undo_database::merge()
 
    // An object's relationship to a state can be:
    // in new_ids            : new
-   // in old_values (was=X) : upd(was=X)
+   // in old_values or old_deltas (was=X) : upd(was=X)
    // in removed (was=X)    : del(was=X)
    // not in any of above   : nop
    //
@@ -189,6 +289,30 @@ void undo_database::merge()
       // nop+upd(was=Y) -> upd(was=Y), type B
       prev_state.old_values[obj.second->id] = std::move(obj.second);
    }
+   for( auto& item : state.old_deltas )
+   {
+      if( prev_state.new_ids.find(item.first) != prev_state.new_ids.end() )
+      {
+         // new+upd -> new, type A
+         continue;
+      }
+      auto it = prev_state.old_deltas.find(item.first);
+      if( it != prev_state.old_deltas.end() )
+      {
+         // upd(was=X) + upd(was=Y) -> upd(was=X), type A, but X may be relative to Y which is now gone
+         if( it->second.relative )
+         {
+            const object& current = _db.get_object( item.first );
+            it->second.make_absolute( item.second.old_value( item.second.relative ? current.pack()
+                                                                                  : std::vector<char>() ) );
+         }
+         continue;
+      }
+      // del+upd -> N/A
+      assert( prev_state.removed.find(item.first) == prev_state.removed.end() );
+      // nop+upd(was=Y) -> upd(was=Y), type B
+      prev_state.old_deltas[item.first] = std::move(item.second);
+   }
 
    // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
    for( auto id : state.new_ids )
@@ -228,6 +352,14 @@ void undo_database::merge()
          prev_state.old_values.erase(obj.second->id);
          continue;
       }
+      auto delta = prev_state.old_deltas.find(obj.second->id);
+      if( delta != prev_state.old_deltas.end() )
+      {
+         // upd(was=X) + del(was=Y) -> del(was=X), X may be relative to Y
+         prev_state.removed[obj.second->id] = old_value( *obj.second, delta->second );
+         prev_state.old_deltas.erase( delta );
+         continue;
+      }
       // del + del -> N/A
       assert( prev_state.removed.find( obj.second->id ) == prev_state.removed.end() );
       // nop + del(was=Y) -> del(was=Y)
@@ -255,6 +387,12 @@ void undo_database::pop_commit()
       {
          _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
       }
+      for( auto& item : state.old_deltas )
+      {
+         const object& current = _db.get_object( item.first );
+         auto value = old_value( current, item.second );
+         _db.modify( current, [&]( object& obj ){ obj.move_from( *value ); } );
+      }
 
       for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
       {
@@ -285,4 +423,18 @@ const undo_state& undo_database::head()const
    return _stack.back();
 }
 
+const undo_state& undo_database::at_depth( size_t depth )const
+{
+   FC_ASSERT( depth < _stack.size() );
+   return _stack[ _stack.size() - 1 - depth ];
+}
+
+size_t undo_database::head_size()const
+{
+   if( _stack.empty() )
+      return 0;
+   const undo_state& state = _stack.back();
+   return state.old_values.size() + state.old_deltas.size() + state.new_ids.size() + state.removed.size();
+}
+
 } } // graphene::db
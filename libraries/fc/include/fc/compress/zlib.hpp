@@ -6,5 +6,7 @@ namespace fc
 {
 
 std::string zlib_compress(const std::string& in);
+std::string zlib_decompress(const char* in, size_t in_size);
+std::string zlib_decompress(const std::string& in);
 
 } // namespace fc
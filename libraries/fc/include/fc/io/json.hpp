@@ -25,7 +25,14 @@ namespace fc
             relaxed_parser        = 2,
             legacy_parser_with_string_doubles = 3,
 #endif
-            broken_nul_parser     = 4
+            broken_nul_parser     = 4,
+            /** legacy_parser, reading the string in place and scanning it with SIMD where the target has it.
+             *  Only from_string() reads in place, the other sources use legacy_parser. */
+            buffer_parser         = 5,
+#ifdef WITH_EXOTIC_JSON_PARSERS
+            strict_buffer_parser  = 6,
+            relaxed_buffer_parser = 7
+#endif
          };
          enum output_formatting
          {
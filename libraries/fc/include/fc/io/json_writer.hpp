@@ -0,0 +1,227 @@
+#pragma once
+#include <fc/io/json.hpp>
+#include <fc/io/json_writer_fwd.hpp>
+#include <fc/container/flat_fwd.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/safe.hpp>
+#include <fc/static_variant.hpp>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#define DEFAULT_MAX_RECURSION_DEPTH 200
+
+namespace fc
+{
+   /**
+    *  Writes values as json without converting them to variants first.
+    *
+    *  The output is the one json::to_string() makes of the variant of a value. Integers, strings, the containers
+    *  to_variant() turns into arrays, and the types declared with FC_JSON_STREAM_MEMBERS are written as they are
+    *  visited. Any other value, and any type with a to_variant() of its own, is converted to a variant, which is
+    *  written as json::to_string() would, so it comes out the same.
+    */
+   class json_writer
+   {
+      public:
+         explicit json_writer( json::output_formatting format = json::stringify_large_ints_and_doubles,
+                               uint32_t max_depth = DEFAULT_MAX_RECURSION_DEPTH );
+
+         template<typename T>
+         static std::string to_string( const T& v, json::output_formatting format = json::stringify_large_ints_and_doubles,
+                                       uint32_t max_depth = DEFAULT_MAX_RECURSION_DEPTH )
+         {
+            json_writer writer( format, max_depth );
+            writer.write( v );
+            return writer.release();
+         }
+
+         template<typename T>
+         void write( const T& v )
+         {
+            write_value( v, json_stream_members<T>() );
+         }
+
+         void write( const variant& v );
+         void write( const variant_object& o );
+         void write( bool b );
+         void write( int8_t i )   { write_int64( i ); }
+         void write( int16_t i )  { write_int64( i ); }
+         void write( int32_t i )  { write_int64( i ); }
+         void write( int64_t i )  { write_int64( i ); }
+         void write( uint8_t i )  { write_uint64( i ); }
+         void write( uint16_t i ) { write_uint64( i ); }
+         void write( uint32_t i ) { write_uint64( i ); }
+         void write( uint64_t i ) { write_uint64( i ); }
+         void write( const std::string& s );
+
+         /// to_variant() makes a hex string of it
+         void write( const std::vector<char>& v ) { write( variant( v, _depth ) ); }
+
+         template<typename T>
+         void write( const std::vector<T>& v ) { write_array( v ); }
+         template<typename T>
+         void write( const std::deque<T>& v ) { write_array( v ); }
+         template<typename T>
+         void write( const std::set<T>& v ) { write_array( v ); }
+         template<typename T, typename... A>
+         void write( const flat_set<T, A...>& v ) { write_array( v ); }
+         template<typename K, typename T>
+         void write( const std::map<K, T>& v ) { write_array( v ); }
+         template<typename K, typename... T>
+         void write( const flat_map<K, T...>& v ) { write_array( v ); }
+
+         template<typename A, typename B>
+         void write( const std::pair<A, B>& p )
+         {
+            begin_array();
+            write( p.first );
+            write( p.second );
+            end_array();
+         }
+
+         template<typename T>
+         void write( const optional<T>& v )
+         {
+            if( v.valid() )
+               write( *v );
+            else
+               write_null();
+         }
+
+         template<typename T>
+         void write( const std::shared_ptr<T>& v )
+         {
+            if( v )
+               write( *v );
+            else
+               write_null();
+         }
+
+         template<typename T>
+         void write( const safe<T>& s ) { write( static_cast<T>( s.value ) ); }
+
+         template<typename... T>
+         void write( const static_variant<T...>& s )
+         {
+            begin_array();
+            write_int64( s.which() );
+            s.visit( static_variant_writer( *this ) );
+            end_array();
+         }
+
+         void write_null();
+         void write_int64( int64_t i );
+         void write_uint64( uint64_t i );
+
+         /** Writes @p json, a value already written as json, as the next value */
+         void write_raw( const std::string& json );
+
+         /** Objects and arrays written by hand: key() names the next value of an object */
+         void begin_object();
+         void key( const char* name );
+         void end_object();
+         void begin_array();
+         void end_array();
+
+         const std::string& str()const { return _out; }
+         bool empty()const { return _out.empty(); }
+         std::string release();
+
+      private:
+         template<typename T>
+         class member_writer
+         {
+            public:
+               member_writer( json_writer& writer, const T& v ) : _writer(writer), _val(v) {}
+
+               template<typename Member, class Class, Member (Class::*member)>
+               void operator()( const char* name )const
+               {
+                  this->add( name, (_val.*member) );
+               }
+
+            private:
+               // to_variant() leaves out the members which are empty optionals
+               template<typename M>
+               void add( const char* name, const optional<M>& v )const
+               {
+                  if( v.valid() )
+                  {
+                     _writer.key( name );
+                     _writer.write( *v );
+                  }
+               }
+               template<typename M>
+               void add( const char* name, const M& v )const
+               {
+                  _writer.key( name );
+                  _writer.write( v );
+               }
+
+               json_writer& _writer;
+               const T&     _val;
+         };
+
+         struct static_variant_writer
+         {
+            typedef void result_type;
+            explicit static_variant_writer( json_writer& writer ) : _writer(writer) {}
+
+            template<typename T>
+            void operator()( const T& v )const { _writer.write( v ); }
+
+            json_writer& _writer;
+         };
+
+         template<typename T>
+         void write_value( const T& v, std::true_type )
+         {
+            write_members( v );
+         }
+
+         /// not inline, so that it can be instantiated in the source file holding the reflection of T
+         template<typename T>
+         void write_members( const T& v );
+
+         template<typename T>
+         void write_value( const T& v, std::false_type )
+         {
+            write( variant( v, _depth ) );
+         }
+
+         template<typename Container>
+         void write_array( const Container& c )
+         {
+            begin_array();
+            for( const auto& item : c )
+               write( item );
+            end_array();
+         }
+
+         /// checks the depth of the next value, and separates it from the one before
+         void begin_value();
+         void write_string( const char* s, size_t size );
+
+         std::string             _out;
+         json::output_formatting _format;
+         uint32_t                _depth;
+         /// whether a value was written at the current level, the next one then follows a comma
+         bool                    _comma = false;
+   };
+
+   template<typename T>
+   void json_writer::write_members( const T& v )
+   {
+      begin_object();
+      fc::reflector<T>::visit( member_writer<T>( *this, v ) );
+      end_object();
+   }
+
+} // fc
+
+#undef DEFAULT_MAX_RECURSION_DEPTH
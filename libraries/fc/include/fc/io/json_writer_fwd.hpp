@@ -0,0 +1,21 @@
+#pragma once
+#include <type_traits>
+
+namespace fc {
+   class json_writer;
+
+   /**
+    * Tells json_writer that the variant of a T is the object of its reflected members, which is what to_variant()
+    * makes of a reflected type having no to_variant() of its own. The writer then writes the members of a T straight
+    * to its buffer. Any other type is converted to a variant first.
+    */
+   template<typename T>
+   struct json_stream_members : std::false_type {};
+}
+
+/**
+ * Declares that TYPE, reflected with FC_REFLECT or FC_REFLECT_DERIVED and without a to_variant() of its own, may be
+ * written by json_writer member by member. Use it at global scope, next to the FC_REFLECT of TYPE.
+ */
+#define FC_JSON_STREAM_MEMBERS( TYPE ) \
+namespace fc { template<> struct json_stream_members<TYPE> : std::true_type {}; }
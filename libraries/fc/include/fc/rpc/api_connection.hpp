@@ -2,6 +2,7 @@
 #include <fc/variant.hpp>
 #include <fc/optional.hpp>
 #include <fc/api.hpp>
+#include <fc/io/json_writer.hpp>
 #include <boost/any.hpp>
 #include <memory>
 #include <vector>
@@ -131,11 +132,39 @@ namespace fc {
             return _methods[method_id](args);
          }
 
+         /** Makes the call, and writes its result to @p result as json */
+         void call( const string& name, const variants& args, json_writer& result )
+         {
+            auto itr = _by_name.find(name);
+            if( itr == _by_name.end() )
+               FC_THROW_EXCEPTION( method_not_found_exception, "No method with name '${name}'",
+                                   ("name",name)("api",_by_name) );
+            call( itr->second, args, result );
+         }
+
+         void call( uint32_t method_id, const variants& args, json_writer& result )
+         {
+            if( method_id >= _methods.size() )
+               FC_THROW_EXCEPTION( method_not_found_exception, "No method with id '${id}'",
+                                   ("id",method_id)("api",_by_name) );
+            if( _json_methods[method_id] )
+               _json_methods[method_id]( args, result );
+            else
+               result.write( _methods[method_id](args) );
+         }
+
          std::weak_ptr< fc::api_connection > get_connection()
          {
             return _api_connection;
          }
 
+         /** @return the api if it is an @p Api, nullptr otherwise */
+         template<typename Api>
+         const Api* as()const
+         {
+            return boost::any_cast<Api>( &_api );
+         }
+
          std::vector<std::string> get_method_names()const
          {
             std::vector<std::string> result;
@@ -147,6 +176,8 @@ namespace fc {
       private:
          friend struct api_visitor;
 
+         typedef std::function<void(const variants&, json_writer&)> json_method;
+
          template<typename R, typename Arg0, typename ... Args>
          std::function<R(Args...)> bind_first_arg( const std::function<R(Arg0,Args...)>& f, Arg0 a0 )const
          {
@@ -218,9 +249,27 @@ namespace fc {
             template<typename ... Args>
             std::function<variant(const fc::variants&)> to_generic( const std::function<void(Args...)>& f )const;
 
+            /// Methods returning apis or nothing have no json method, their call writes the variant of the result
+            template<typename Interface, typename Adaptor, typename ... Args>
+            json_method to_json( const std::function<api<Interface,Adaptor>(Args...)>& f )const { return json_method(); }
+
+            template<typename Interface, typename Adaptor, typename ... Args>
+            json_method to_json( const std::function<fc::optional<api<Interface,Adaptor>>(Args...)>& f )const
+            { return json_method(); }
+
+            template<typename ... Args>
+            json_method to_json( const std::function<fc::api_ptr(Args...)>& f )const { return json_method(); }
+
+            template<typename ... Args>
+            json_method to_json( const std::function<void(Args...)>& f )const { return json_method(); }
+
+            template<typename R, typename ... Args>
+            json_method to_json( const std::function<R(Args...)>& f )const;
+
             template<typename Result, typename... Args>
             void operator()( const char* name, std::function<Result(Args...)>& memb )const {
                _api._methods.emplace_back( to_generic( memb ) );
+               _api._json_methods.emplace_back( to_json( memb ) );
                _api._by_name[name] = _api._methods.size() - 1;
             }
 
@@ -233,6 +282,8 @@ namespace fc {
          boost::any                                              _api;
          std::map< std::string, uint32_t >                       _by_name;
          std::vector< std::function<variant(const variants&)> >  _methods;
+         /// the methods which write their result without converting it to a variant, empty for the others
+         std::vector< json_method >                              _json_methods;
    }; // class generic_api
 
 
@@ -256,11 +307,50 @@ namespace fc {
          virtual variant send_call( api_id_type api_id, string method_name, variants args = variants() ) = 0;
          virtual variant send_callback( uint64_t callback_id, variants args = variants() ) = 0;
          virtual void    send_notice( uint64_t callback_id, variants args = variants() ) = 0;
+         /**
+          * Sends a notice whose arguments are written as a json array already. A connection which sends json writes
+          * them as they are, the others parse them back into variants.
+          */
+         virtual void    send_notice_json( uint64_t callback_id, const std::string& args_json )
+         {
+            send_notice( callback_id, fc::json::from_string( args_json, fc::json::legacy_parser, _max_conversion_depth )
+                                         .as<variants>( _max_conversion_depth ) );
+         }
+
+         /**
+          * Runs the calls to local apis. It is given the api and the method called, and a functor making the call,
+          * which it may run on another thread. Without a dispatcher the calls run in place.
+          */
+         typedef std::function<variant( const generic_api& api, const string& method_name,
+                                        const std::function<variant()>& call )> call_dispatcher;
+         void set_call_dispatcher( call_dispatcher dispatcher ) { _call_dispatcher = std::move( dispatcher ); }
 
          variant receive_call( api_id_type api_id, const string& method_name, const variants& args = variants() )const
          {
             FC_ASSERT( _local_apis.size() > api_id );
-            return _local_apis[api_id]->call( method_name, args );
+            // the api is looked up here, registering another api may move _local_apis while the call runs elsewhere
+            generic_api* api = _local_apis[api_id].get();
+            if( !_call_dispatcher )
+               return api->call( method_name, args );
+            return _call_dispatcher( *api, method_name, [api, &method_name, &args]() {
+               return api->call( method_name, args );
+            } );
+         }
+         /** Like the call above, but writes the result to @p result as json */
+         void receive_call( api_id_type api_id, const string& method_name, const variants& args,
+                            json_writer& result )const
+         {
+            FC_ASSERT( _local_apis.size() > api_id );
+            generic_api* api = _local_apis[api_id].get();
+            if( !_call_dispatcher )
+            {
+               api->call( method_name, args, result );
+               return;
+            }
+            _call_dispatcher( *api, method_name, [api, &method_name, &args, &result]() {
+               api->call( method_name, args, result );
+               return variant();
+            } );
          }
          variant receive_callback( uint64_t callback_id,  const variants& args = variants() )const
          {
@@ -300,6 +390,7 @@ namespace fc {
          std::vector< std::unique_ptr<generic_api> >                      _local_apis;
          std::map< uint64_t, api_id_type >                                _handle_to_id;
          std::vector< std::function<variant(const variants&, uint32_t)> > _local_callbacks;
+         call_dispatcher                                                  _call_dispatcher;
 
 
          struct api_visitor
@@ -478,6 +569,18 @@ namespace fc {
       };
    }
 
+   template<typename R, typename ... Args>
+   generic_api::json_method generic_api::api_visitor::to_json( const std::function<R(Args...)>& f )const
+   {
+      auto con = _api_con.lock();
+      FC_ASSERT( con, "not connected" );
+      uint32_t max_depth = con->_max_conversion_depth;
+      generic_api* gapi = &_api;
+      return [f,gapi,max_depth]( const variants& args, json_writer& result ) {
+         result.write( gapi->call_generic( f, args.begin(), args.end(), max_depth ) );
+      };
+   }
+
    template<typename ... Args>
    std::function<variant(const fc::variants&)> generic_api::api_visitor::to_generic( const std::function<void(Args...)>& f )const
    {
@@ -556,6 +659,15 @@ namespace fc {
              locked->send_notice( _callback_id, fc::variants{ args... } );
           }
 
+          /// Calls back with the arguments written as a json array already, see api_connection::send_notice_json()
+          void send_json( const std::string& args_json )const
+          {
+             std::shared_ptr< fc::api_connection > locked = _api_connection.lock();
+             if( !locked )
+                throw fc::eof_exception();
+             locked->send_notice_json( _callback_id, args_json );
+          }
+
          private:
           uint64_t _callback_id;
           std::weak_ptr< fc::api_connection > _api_connection;
@@ -1,5 +1,6 @@
 #pragma once
 #include <fc/variant.hpp>
+#include <fc/io/json_writer_fwd.hpp>
 #include <functional>
 #include <fc/thread/future.hpp>
 
@@ -42,6 +43,7 @@ namespace fc { namespace rpc {
 
          void add_method( const std::string& name, method m );
          void remove_method( const std::string& name );
+         bool has_method( const std::string& name )const;
 
          variant local_call( const string& method_name, const variants& args );
          void    handle_reply( const response& response );
@@ -64,3 +66,7 @@ namespace fc { namespace rpc {
 FC_REFLECT( fc::rpc::request, (id)(method)(params)(jsonrpc) );
 FC_REFLECT( fc::rpc::error_object, (code)(message)(data) )
 FC_REFLECT( fc::rpc::response, (id)(jsonrpc)(result)(error) )
+
+FC_JSON_STREAM_MEMBERS( fc::rpc::request )
+FC_JSON_STREAM_MEMBERS( fc::rpc::error_object )
+FC_JSON_STREAM_MEMBERS( fc::rpc::response )
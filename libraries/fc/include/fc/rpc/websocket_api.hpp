@@ -22,12 +22,24 @@ namespace fc { namespace rpc {
          virtual void send_notice(
             uint64_t callback_id,
             variants args = variants() ) override;
+         virtual void send_notice_json(
+            uint64_t callback_id,
+            const std::string& args_json ) override;
 
       protected:
-         response on_message( const std::string& message );
-         response on_request( const variant& message );
+         /**
+          * With @p streamed_reply, the reply to a call of a local api is written to it as json, and the response
+          * returned is empty. Any other reply, errors included, is returned as a response.
+          */
+         response on_message( const std::string& message, json_writer* streamed_reply = nullptr );
+         response on_request( const variant& message, json_writer* streamed_reply = nullptr );
          void     on_response( const variant& message );
 
+         api_id_type api_id_of( const variant& api );
+         /// whether @p call is one of a local api, whose result call_api() can write as json
+         bool     is_api_call( const request& call )const;
+         void     call_api( const request& call, json_writer& result );
+
          std::shared_ptr<fc::http::websocket_connection>  _connection;
          fc::rpc::state                                   _rpc_state;
    };
@@ -12,4 +12,21 @@ namespace fc
     free(compressed_message);
     return result;
   }
+
+  std::string zlib_decompress(const char* in, size_t in_size)
+  {
+    size_t decompressed_length = 0;
+    char* decompressed = (char*)tinfl_decompress_mem_to_heap(in, in_size, &decompressed_length, TINFL_FLAG_PARSE_ZLIB_HEADER);
+    // miniz returns no buffer both on failure and for an empty result
+    if (decompressed == nullptr)
+      return std::string();
+    std::string result(decompressed, decompressed_length);
+    free(decompressed);
+    return result;
+  }
+
+  std::string zlib_decompress(const std::string& in)
+  {
+    return zlib_decompress(in.data(), in.size());
+  }
 }
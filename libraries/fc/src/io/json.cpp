@@ -6,12 +6,17 @@
 #include <fc/io/sstream.hpp>
 #include <fc/log/logger.hpp>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
 #include <boost/filesystem/fstream.hpp>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace fc
 {
     // forward declarations of provided functions
@@ -25,6 +30,7 @@ namespace fc
     template<typename T> variants arrayFromStreamBase( T& in, std::function<variant(T&)>& get_value );
     template<typename T, json::parse_type parser_type> variants arrayFromStream( T& in, uint32_t max_depth );
     template<typename T, json::parse_type parser_type> variant number_from_stream( T& in );
+    template<json::parse_type parser_type> variant number_from_string( const std::string& str, bool dot, bool neg );
     template<typename T> variant token_from_stream( T& in );
     void escape_string( const string& str, ostream& os );
     template<typename T> void to_stream( T& os, const variants& a, json::output_formatting format, uint32_t max_depth );
@@ -43,6 +49,218 @@ namespace fc
 
 namespace fc
 {
+   /**
+    *  The input of json::from_string() for the buffer parsers, read in place.
+    *
+    *  The parsers above take any stream with peek() and get(). This one has them inline, and the specializations
+    *  below scan white space, strings, numbers and words over the buffer instead of a char at a time, 16 bytes at
+    *  once where SSE2 is available.
+    */
+   class json_buffer_stream
+   {
+      public:
+         json_buffer_stream( const char* begin, const char* end ) : _pos(begin), _end(end) {}
+
+         /// throws eof_exception at the end of the buffer, like the end of any other stream
+         char peek()const
+         {
+            if( _pos == _end )
+               FC_THROW_EXCEPTION( eof_exception, "json_buffer_stream" );
+            return *_pos;
+         }
+         char get()
+         {
+            char c = peek();
+            ++_pos;
+            return c;
+         }
+
+         const char* pos()const { return _pos; }
+         const char* end()const { return _end; }
+         void        seek( const char* pos ) { _pos = pos; }
+
+      private:
+         const char* _pos;
+         const char* _end;
+   };
+
+   namespace
+   {
+      inline bool is_white_space( char c )
+      {
+         return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+      }
+
+      /** @return the first char of [p, end) which is not white space, or end */
+      const char* find_non_white_space( const char* p, const char* end )
+      {
+         // a value usually follows no or a single white space
+         if( p == end || !is_white_space( *p ) )
+            return p;
+         ++p;
+#ifdef __SSE2__
+         const __m128i space = _mm_set1_epi8( ' ' );
+         const __m128i tab   = _mm_set1_epi8( '\t' );
+         const __m128i lf    = _mm_set1_epi8( '\n' );
+         const __m128i cr    = _mm_set1_epi8( '\r' );
+         while( end - p >= 16 )
+         {
+            const __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+            const __m128i white = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( chunk, space ), _mm_cmpeq_epi8( chunk, tab ) ),
+                                                _mm_or_si128( _mm_cmpeq_epi8( chunk, lf ), _mm_cmpeq_epi8( chunk, cr ) ) );
+            const unsigned other = ~_mm_movemask_epi8( white ) & 0xffff;
+            if( other )
+               return p + __builtin_ctz( other );
+            p += 16;
+         }
+#endif
+         while( p != end && is_white_space( *p ) )
+            ++p;
+         return p;
+      }
+
+      /** @return the first '"', '\\' or ^D of [p, end), which end a plain run of a string, or end */
+      const char* find_string_special( const char* p, const char* end )
+      {
+#ifdef __SSE2__
+         const __m128i quote     = _mm_set1_epi8( '"' );
+         const __m128i backslash = _mm_set1_epi8( '\\' );
+         const __m128i eot       = _mm_set1_epi8( 0x04 );
+         while( end - p >= 16 )
+         {
+            const __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+            const __m128i special = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( chunk, quote ),
+                                                                 _mm_cmpeq_epi8( chunk, backslash ) ),
+                                                  _mm_cmpeq_epi8( chunk, eot ) );
+            const unsigned found = _mm_movemask_epi8( special );
+            if( found )
+               return p + __builtin_ctz( found );
+            p += 16;
+         }
+#endif
+         while( p != end && *p != '"' && *p != '\\' && *p != 0x04 )
+            ++p;
+         return p;
+      }
+   }
+
+   template<>
+   bool skip_white_space( json_buffer_stream& in )
+   {
+      const char* begin = in.pos();
+      in.seek( find_non_white_space( begin, in.end() ) );
+      in.peek(); // a stream ends within white space with eof_exception
+      return in.pos() != begin;
+   }
+
+   template<>
+   std::string stringFromStream( json_buffer_stream& in )
+   {
+      std::string token;
+      try
+      {
+         char c = in.peek();
+
+         if( c != '"' )
+            FC_THROW_EXCEPTION( parse_error_exception,
+                                            "Expected '\"' but read '${char}'",
+                                            ("char", string(&c, (&c) + 1) ) );
+         in.get();
+         while( true )
+         {
+            const char* special = find_string_special( in.pos(), in.end() );
+            token.append( in.pos(), special );
+            in.seek( special );
+
+            switch( in.peek() )
+            {
+               case '\\':
+                  token.push_back( parseEscape( in ) );
+                  break;
+               case '"':
+                  in.get();
+                  return token;
+               default:
+                  FC_THROW_EXCEPTION( parse_error_exception, "EOF before closing '\"' in string '${token}'",
+                                                   ("token", token ) );
+            }
+         }
+       } FC_RETHROW_EXCEPTIONS( warn, "while parsing token '${token}'",
+                                          ("token", token ) );
+   }
+
+   template<>
+   variant number_from_stream<json_buffer_stream, json::legacy_parser>( json_buffer_stream& in )
+   {
+      const char* begin = in.pos();
+      const char* p = begin;
+      const char* end = in.end();
+      bool  dot = false;
+      bool  neg = false;
+      if( p != end && *p == '-' )
+      {
+         neg = true;
+         ++p;
+      }
+      for( ; p != end; ++p )
+      {
+         const char c = *p;
+         if( c == '.' )
+         {
+            if( dot )
+               FC_THROW_EXCEPTION(parse_error_exception, "Can't parse a number with two decimal places");
+            dot = true;
+         }
+         else if( c < '0' || c > '9' )
+         {
+            if( isalnum( static_cast<unsigned char>( c ) ) )
+            {
+               in.seek( p );
+               return std::string( begin, p ) + stringFromToken( in );
+            }
+            break;
+         }
+      }
+      in.seek( p );
+      return number_from_string<json::legacy_parser>( std::string( begin, p ), dot, neg );
+   }
+
+   template<>
+   variant token_from_stream( json_buffer_stream& in )
+   {
+      const char* begin = in.pos();
+      const char* p = begin;
+      const char* end = in.end();
+      while( p != end )
+      {
+         switch( *p )
+         {
+            case 'n': case 'u': case 'l': case 't': case 'r': case 'e': case 'f': case 'a': case 's':
+               ++p;
+               continue;
+         }
+         break;
+      }
+      in.seek( p );
+
+      const size_t size = p - begin;
+      if( size == 4 && memcmp( begin, "null", 4 ) == 0 )
+        return variant();
+      if( size == 4 && memcmp( begin, "true", 4 ) == 0 )
+        return true;
+      if( size == 5 && memcmp( begin, "false", 5 ) == 0 )
+        return false;
+      std::string str( begin, p );
+      if( p == end )
+      {
+        if( str.empty() )
+          FC_THROW_EXCEPTION( parse_error_exception, "Unexpected EOF" );
+        return str;
+      }
+      // a partial or malformed word, read as an un-quoted string as token_from_stream() does
+      return str + stringFromToken( in );
+   }
+
    template<typename T>
    char parseEscape( T& in )
    {
@@ -324,7 +542,12 @@ namespace fc
       catch (const std::ios_base::failure&)
       { // read error ends the loop
       }
-      std::string str = ss.str();
+      return number_from_string<parser_type>( ss.str(), dot, neg );
+   }
+
+   template<json::parse_type parser_type>
+   variant number_from_string( const std::string& str, bool dot, bool neg )
+   {
       if (str == "-." || str == "." || str == "-") // check the obviously wrong things we could have encountered
         FC_THROW_EXCEPTION(parse_error_exception, "Can't parse token \"${token}\" as a JSON numeric constant", ("token", str));
       if( dot )
@@ -457,6 +680,20 @@ namespace fc
 
    variant json::from_string( const std::string& utf8_str, parse_type ptype, uint32_t max_depth )
    { try {
+      json_buffer_stream buf( utf8_str.data(), utf8_str.data() + utf8_str.size() );
+      switch( ptype )
+      {
+          case buffer_parser:
+              return variant_from_stream<json_buffer_stream, legacy_parser>( buf, max_depth );
+#ifdef WITH_EXOTIC_JSON_PARSERS
+          case strict_buffer_parser:
+              return json_relaxed::variant_from_stream<json_buffer_stream, true>( buf, max_depth );
+          case relaxed_buffer_parser:
+              return json_relaxed::variant_from_stream<json_buffer_stream, false>( buf, max_depth );
+#endif
+          default:
+              break;
+      }
       fc::istream_ptr in( new fc::stringstream( utf8_str ) );
       fc::buffered_istream bin( in );
       return from_stream( bin, ptype, max_depth );
@@ -786,6 +1023,15 @@ namespace fc
 #endif
           case broken_nul_parser:
               return variant_from_stream<fc::buffered_istream, broken_nul_parser>( in, max_depth );
+          // a stream is not read in place
+          case buffer_parser:
+              return variant_from_stream<fc::buffered_istream, legacy_parser>( in, max_depth );
+#ifdef WITH_EXOTIC_JSON_PARSERS
+          case strict_buffer_parser:
+              return json_relaxed::variant_from_stream<buffered_istream, true>( in, max_depth );
+          case relaxed_buffer_parser:
+              return json_relaxed::variant_from_stream<buffered_istream, false>( in, max_depth );
+#endif
           default:
               FC_ASSERT( false, "Unknown JSON parser type {ptype}", ("ptype", ptype) );
       }
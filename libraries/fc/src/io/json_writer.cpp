@@ -0,0 +1,217 @@
+#include <fc/io/json_writer.hpp>
+#include <fc/exception/exception.hpp>
+
+#include <cstring>
+
+namespace fc
+{
+   json_writer::json_writer( json::output_formatting format, uint32_t max_depth )
+      : _format(format), _depth(max_depth)
+   {}
+
+   void json_writer::begin_value()
+   {
+      FC_ASSERT( _depth > 0, "Too many nested objects!" );
+      if( _comma )
+         _out.push_back( ',' );
+   }
+
+   /** The escapes of escape_string() in json.cpp */
+   void json_writer::write_string( const char* s, size_t size )
+   {
+      static const char hex[] = "0123456789abcdef";
+
+      _out.push_back( '"' );
+      const char* plain = s;
+      const char* end = s + size;
+      for( const char* itr = s; itr != end; ++itr )
+      {
+         const char c = *itr;
+         if( static_cast<unsigned char>( c ) >= 0x20 && c != '"' && c != '\\' )
+            continue;
+
+         _out.append( plain, itr );
+         plain = itr + 1;
+         switch( c )
+         {
+            case '\b': _out.append( "\\b" );  break;
+            case '\f': _out.append( "\\f" );  break;
+            case '\n': _out.append( "\\n" );  break;
+            case '\r': _out.append( "\\r" );  break;
+            case '\t': _out.append( "\\t" );  break;
+            case '\\': _out.append( "\\\\" ); break;
+            case '"':  _out.append( "\\\"" ); break;
+            default:
+               _out.append( "\\u00" );
+               _out.push_back( hex[ c >> 4 ] );
+               _out.push_back( hex[ c & 0xf ] );
+         }
+      }
+      _out.append( plain, end );
+      _out.push_back( '"' );
+   }
+
+   void json_writer::write( const variant& v )
+   {
+      switch( v.get_type() )
+      {
+         case variant::null_type:
+            write_null();
+            return;
+         case variant::int64_type:
+            write_int64( v.as_int64() );
+            return;
+         case variant::uint64_type:
+            write_uint64( v.as_uint64() );
+            return;
+         case variant::double_type:
+            begin_value();
+            if( _format == json::stringify_large_ints_and_doubles )
+            {
+               _out.push_back( '"' );
+               _out.append( v.as_string() );
+               _out.push_back( '"' );
+            }
+            else
+               _out.append( v.as_string() );
+            _comma = true;
+            return;
+         case variant::bool_type:
+            write( v.as_bool() );
+            return;
+         case variant::string_type:
+            write( v.get_string() );
+            return;
+         case variant::blob_type:
+            write( v.as_string() );
+            return;
+         case variant::array_type:
+            write_array( v.get_array() );
+            return;
+         case variant::object_type:
+            write( v.get_object() );
+            return;
+         default:
+            FC_THROW_EXCEPTION( fc::invalid_arg_exception, "Unsupported variant type: ${type}", ( "type", v.get_type() ) );
+      }
+   }
+
+   void json_writer::write( const variant_object& o )
+   {
+      begin_object();
+      for( const auto& entry : o )
+      {
+         if( _comma )
+            _out.push_back( ',' );
+         write_string( entry.key().data(), entry.key().size() );
+         _out.push_back( ':' );
+         _comma = false;
+         write( entry.value() );
+      }
+      end_object();
+   }
+
+   void json_writer::write( bool b )
+   {
+      begin_value();
+      _out.append( b ? "true" : "false" );
+      _comma = true;
+   }
+
+   void json_writer::write( const std::string& s )
+   {
+      begin_value();
+      write_string( s.data(), s.size() );
+      _comma = true;
+   }
+
+   void json_writer::write_null()
+   {
+      begin_value();
+      _out.append( "null" );
+      _comma = true;
+   }
+
+   void json_writer::write_int64( int64_t i )
+   {
+      begin_value();
+      if( _format == json::stringify_large_ints_and_doubles && ( i > INT32_MAX || i < INT32_MIN ) )
+      {
+         _out.push_back( '"' );
+         _out.append( std::to_string( i ) );
+         _out.push_back( '"' );
+      }
+      else
+         _out.append( std::to_string( i ) );
+      _comma = true;
+   }
+
+   void json_writer::write_uint64( uint64_t i )
+   {
+      begin_value();
+      if( _format == json::stringify_large_ints_and_doubles && i > 0xffffffff )
+      {
+         _out.push_back( '"' );
+         _out.append( std::to_string( i ) );
+         _out.push_back( '"' );
+      }
+      else
+         _out.append( std::to_string( i ) );
+      _comma = true;
+   }
+
+   void json_writer::write_raw( const std::string& json )
+   {
+      begin_value();
+      _out.append( json );
+      _comma = true;
+   }
+
+   void json_writer::begin_object()
+   {
+      begin_value();
+      _out.push_back( '{' );
+      --_depth;
+      _comma = false;
+   }
+
+   void json_writer::key( const char* name )
+   {
+      if( _comma )
+         _out.push_back( ',' );
+      write_string( name, strlen( name ) );
+      _out.push_back( ':' );
+      _comma = false;
+   }
+
+   void json_writer::end_object()
+   {
+      _out.push_back( '}' );
+      ++_depth;
+      _comma = true;
+   }
+
+   void json_writer::begin_array()
+   {
+      begin_value();
+      _out.push_back( '[' );
+      --_depth;
+      _comma = false;
+   }
+
+   void json_writer::end_array()
+   {
+      _out.push_back( ']' );
+      ++_depth;
+      _comma = true;
+   }
+
+   std::string json_writer::release()
+   {
+      std::string result = std::move( _out );
+      _out.clear();
+      _comma = false;
+      return result;
+   }
+
+} // fc
@@ -18,6 +18,11 @@ void state::remove_method( const std::string& name )
    _methods.erase(name);
 }
 
+bool state::has_method( const std::string& name )const
+{
+   return _methods.find(name) != _methods.end();
+}
+
 variant state::local_call( const string& method_name, const variants& args )
 {
    auto method_itr = _methods.find(method_name);
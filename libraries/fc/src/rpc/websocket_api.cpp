@@ -1,6 +1,7 @@
 #include <fc/reflect/variant.hpp>
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/json_writer.hpp>
 
 namespace fc { namespace rpc {
 
@@ -16,17 +17,8 @@ websocket_api_connection::websocket_api_connection( const std::shared_ptr<fc::ht
    _rpc_state.add_method( "call", [this]( const variants& args ) -> variant
    {
       FC_ASSERT( args.size() == 3 && args[2].is_array() );
-      api_id_type api_id;
-      if( args[0].is_string() )
-      {
-         variant subresult = this->receive_call( 1, args[0].as_string() );
-         api_id = subresult.as_uint64();
-      }
-      else
-         api_id = args[0].as_uint64();
-
       return this->receive_call(
-         api_id,
+         api_id_of( args[0] ),
          args[1].as_string(),
          args[2].get_array() );
    } );
@@ -51,14 +43,25 @@ websocket_api_connection::websocket_api_connection( const std::shared_ptr<fc::ht
    } );
 
    _connection->on_message_handler( [this]( const std::string& msg ){
-       response reply = on_message(msg);
-       if( _connection && ( reply.id || reply.result || reply.error || reply.jsonrpc ) )
-          _connection->send_message( fc::json::to_string( reply, fc::json::stringify_large_ints_and_doubles,
-                                                          _max_conversion_depth ) );
+       json_writer streamed_reply( fc::json::stringify_large_ints_and_doubles, _max_conversion_depth );
+       response reply = on_message( msg, &streamed_reply );
+       if( !_connection )
+          return;
+       if( !streamed_reply.empty() )
+          _connection->send_message( streamed_reply.release() );
+       else if( reply.id || reply.result || reply.error || reply.jsonrpc )
+          _connection->send_message( json_writer::to_string( reply, fc::json::stringify_large_ints_and_doubles,
+                                                             _max_conversion_depth ) );
    } );
    _connection->on_http_handler( [this]( const std::string& msg ){
-       response reply = on_message(msg);
+       json_writer streamed_reply( fc::json::stringify_large_ints_and_doubles, _max_conversion_depth );
+       response reply = on_message( msg, &streamed_reply );
        fc::http::reply result;
+       if( !streamed_reply.empty() )
+       {
+          result.body_as_string = streamed_reply.release();
+          return result;
+       }
        if( reply.error )
        {
           if( reply.error->code == -32603 )
@@ -67,8 +70,8 @@ websocket_api_connection::websocket_api_connection( const std::shared_ptr<fc::ht
              result.status = fc::http::reply::BadRequest;
        }
        if( reply.id || reply.result || reply.error || reply.jsonrpc )
-          result.body_as_string = fc::json::to_string( reply, fc::json::stringify_large_ints_and_doubles,
-                                                       _max_conversion_depth );
+          result.body_as_string = json_writer::to_string( reply, fc::json::stringify_large_ints_and_doubles,
+                                                          _max_conversion_depth );
        else
           result.status = fc::http::reply::NoContent;
 
@@ -89,9 +92,8 @@ variant websocket_api_connection::send_call(
       return variant(); // TODO return an error?
 
    auto request = _rpc_state.start_remote_call( "call", { api_id, std::move(method_name), std::move(args) } );
-   _connection->send_message( fc::json::to_string( fc::variant( request, _max_conversion_depth ),
-                                                   fc::json::stringify_large_ints_and_doubles,
-                                                   _max_conversion_depth ) );
+   _connection->send_message( json_writer::to_string( request, fc::json::stringify_large_ints_and_doubles,
+                                                      _max_conversion_depth ) );
    return _rpc_state.wait_for_response( *request.id );
 }
 
@@ -103,9 +105,8 @@ variant websocket_api_connection::send_callback(
       return variant(); // TODO return an error?
 
    auto request = _rpc_state.start_remote_call( "callback", { callback_id, std::move(args) } );
-   _connection->send_message( fc::json::to_string( fc::variant( request, _max_conversion_depth ),
-                                                   fc::json::stringify_large_ints_and_doubles,
-                                                   _max_conversion_depth ) );
+   _connection->send_message( json_writer::to_string( request, fc::json::stringify_large_ints_and_doubles,
+                                                      _max_conversion_depth ) );
    return _rpc_state.wait_for_response( *request.id );
 }
 
@@ -117,17 +118,37 @@ void websocket_api_connection::send_notice(
       return;
 
    fc::rpc::request req{ optional<uint64_t>(), "notice", { callback_id, std::move(args) } };
-   _connection->send_message( fc::json::to_string( fc::variant( req, _max_conversion_depth ),
-                                                   fc::json::stringify_large_ints_and_doubles,
-                                                   _max_conversion_depth ) );
+   _connection->send_message( json_writer::to_string( req, fc::json::stringify_large_ints_and_doubles,
+                                                      _max_conversion_depth ) );
 }
 
-response websocket_api_connection::on_message( const std::string& message )
+void websocket_api_connection::send_notice_json(
+   uint64_t callback_id,
+   const std::string& args_json )
+{
+   if( !_connection ) // defensive check
+      return;
+
+   // the same as send_notice() writes for the request, with the arguments as they are
+   json_writer notice( fc::json::stringify_large_ints_and_doubles, _max_conversion_depth );
+   notice.begin_object();
+   notice.key( "method" );
+   notice.write( std::string( "notice" ) );
+   notice.key( "params" );
+   notice.begin_array();
+   notice.write( callback_id );
+   notice.write_raw( args_json );
+   notice.end_array();
+   notice.end_object();
+   _connection->send_message( notice.release() );
+}
+
+response websocket_api_connection::on_message( const std::string& message, json_writer* streamed_reply )
 {
    variant var;
    try
    {
-      var = fc::json::from_string( message, fc::json::legacy_parser, _max_conversion_depth );
+      var = fc::json::from_string( message, fc::json::buffer_parser, _max_conversion_depth );
    }
    catch( const fc::exception& e )
    {
@@ -160,7 +181,7 @@ response websocket_api_connection::on_message( const std::string& message )
       if( var_obj.contains( "params" ) && !var_obj["params"].is_array() )
          return response( variant(), { -32600, "Invalid parameters" }, "2.0" );
 
-      return on_request( std::move( var ) );
+      return on_request( std::move( var ), streamed_reply );
    }
 
    if( var_obj.contains( "result" ) || var_obj.contains("error") )
@@ -181,7 +202,33 @@ void websocket_api_connection::on_response( const variant& var )
    _rpc_state.handle_reply( var.as<fc::rpc::response>(_max_conversion_depth) );
 }
 
-response websocket_api_connection::on_request( const variant& var )
+api_id_type websocket_api_connection::api_id_of( const variant& api )
+{
+   if( api.is_string() )
+      return this->receive_call( 1, api.as_string() ).as_uint64();
+   return api.as_uint64();
+}
+
+bool websocket_api_connection::is_api_call( const request& call )const
+{
+   // the methods which are not "call", "notice" or "callback" are those of the api 0
+   return call.method == "call" || !_rpc_state.has_method( call.method );
+}
+
+void websocket_api_connection::call_api( const request& call, json_writer& result )
+{
+   if( call.method != "call" )
+   {
+      this->receive_call( 0, call.method, call.params, result );
+      return;
+   }
+
+   const variants& args = call.params;
+   FC_ASSERT( args.size() == 3 && args[2].is_array() );
+   this->receive_call( api_id_of( args[0] ), args[1].as_string(), args[2].get_array(), result );
+}
+
+response websocket_api_connection::on_request( const variant& var, json_writer* streamed_reply )
 {
    request call = var.as<fc::rpc::request>( _max_conversion_depth );
    if( var.get_object().contains( "id" ) )
@@ -196,7 +243,14 @@ response websocket_api_connection::on_request( const variant& var )
       auto start = time_point::now();
 #endif
 
-      auto result = _rpc_state.local_call( call.method, call.params );
+      // the result of an api call is written as json without making a variant of it first
+      const bool streamed = streamed_reply && has_id && is_api_call( call );
+      json_writer streamed_result( fc::json::stringify_large_ints_and_doubles, _max_conversion_depth - 1 );
+      variant result;
+      if( streamed )
+         call_api( call, streamed_result );
+      else
+         result = _rpc_state.local_call( call.method, call.params );
 
 #ifdef LOG_LONG_API
       auto end = time_point::now();
@@ -209,6 +263,22 @@ response websocket_api_connection::on_request( const variant& var )
                ("m",call.method)("p",call.params)("t", end - start) );
 #endif
 
+      if( streamed )
+      {
+         // the fields of the response, with the result written already
+         streamed_reply->begin_object();
+         streamed_reply->key( "id" );
+         streamed_reply->write( *call.id );
+         if( call.jsonrpc )
+         {
+            streamed_reply->key( "jsonrpc" );
+            streamed_reply->write( *call.jsonrpc );
+         }
+         streamed_reply->key( "result" );
+         streamed_reply->write_raw( streamed_result.str() );
+         streamed_reply->end_object();
+         return response();
+      }
       if( has_id )
          return response( call.id, result, call.jsonrpc );
    }
@@ -36,6 +36,13 @@
 
 #define GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES        (1024 * 1024)
 
+/**
+ * The storage of up to this number of released message buffers is kept for the next messages read,
+ * unless it is larger than the second limit.
+ */
+#define GRAPHENE_NET_MESSAGE_BUFFER_POOL_SIZE                64
+#define GRAPHENE_NET_MESSAGE_BUFFER_POOL_MAX_BYTES           (256 * 1024)
+
 /**
  * When we receive a message from the network, we advertise it to
  * our peers and save a copy in a cache were we will find it if
@@ -47,6 +54,12 @@
  */
 #define GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS        5
 
+/**
+ * The oldest messages are evicted from the cache before they expire
+ * when it holds more than this number of bytes.
+ */
+#define GRAPHENE_NET_MESSAGE_CACHE_MAX_BYTES                 (64 * 1024 * 1024)
+
 /**
  * We prevent a peer from offering us a list of blocks which, if we fetched them
  * all, would result in a blockchain that extended into the future.
@@ -4,10 +4,12 @@
 #include <boost/endian/buffers.hpp>
 
 #include <graphene/protocol/types.hpp>
+#include <graphene/net/message_buffer.hpp>
 
 #include <fc/io/varint.hpp>
 #include <fc/network/ip.hpp>
 #include <fc/io/raw_fwd.hpp>
+#include <fc/io/datastream.hpp>
 #include <fc/crypto/ripemd160.hpp>
 #include <fc/reflect/variant.hpp>
 
@@ -30,10 +32,12 @@ namespace graphene { namespace net {
   /**
    *  Abstracts the process of packing/unpacking a message for a 
    *  particular channel.
+   *
+   *  Copies of a message share its data, see message_buffer.
    */
   struct message : public message_header
   {
-     std::vector<char> data;
+     message_buffer data;
 
      message(){}
 
@@ -50,8 +54,12 @@ namespace graphene { namespace net {
      message( const T& m ) 
      {
         msg_type = T::type;
-        data     = fc::raw::pack(m);
-        size     = (uint32_t)data.size();
+        const size_t packed_size = fc::raw::pack_size(m);
+        size     = (uint32_t)packed_size;
+        data     = message_buffer( packed_size );
+        fc::datastream<char*> ds( data.mutable_data(), packed_size );
+        fc::raw::pack( ds, m );
+        data.set_header( *this );
      }
 
      message_hash_type id()const
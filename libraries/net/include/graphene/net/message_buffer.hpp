@@ -0,0 +1,94 @@
+// see LICENSE.txt
+
+#pragma once
+#include <fc/io/raw_fwd.hpp>
+#include <fc/variant.hpp>
+#include <fc/reflect/typename.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace graphene { namespace net {
+
+  struct message_header;
+
+  /**
+   *  The packed payload of a message, shared by all copies of the message.
+   *
+   *  The storage holds the message as it travels on a connection: the header, the payload, then zeros up to a
+   *  multiple of 16 bytes. A connection reads a message into it and sends it from it, so a block received once is
+   *  kept once, however many peers it is queued for. Storage whose last buffer is gone returns to a pool, the read
+   *  loops of the connections draw from it.
+   */
+  class message_buffer
+  {
+     public:
+        message_buffer() {}
+        /// A buffer of @p size payload bytes, which are to be written through mutable_data()
+        explicit message_buffer( size_t size );
+        message_buffer( const message_buffer& ) = default;
+        message_buffer( message_buffer&& other )
+        : _storage( std::move( other._storage ) ), _size( other._size ) { other._size = 0; }
+        message_buffer& operator=( const message_buffer& ) = default;
+        message_buffer& operator=( message_buffer&& other )
+        {
+           _storage = std::move( other._storage );
+           _size = other._size;
+           if( &other != this )
+              other._size = 0;
+           return *this;
+        }
+
+        const char* data()const { return _storage ? _storage->data() + header_size : nullptr; }
+        size_t      size()const { return _size; }
+        bool        empty()const { return _size == 0; }
+        /// The payload to write to, it is copied first if another buffer shares it
+        char*       mutable_data();
+
+        /// The header, the payload and the padding, as sent on a connection
+        const char* wire_data()const { return _storage ? _storage->data() : nullptr; }
+        size_t      wire_size()const { return _storage ? wire_size( _size ) : 0; }
+        char*       mutable_wire_data();
+        static size_t wire_size( size_t size ) { return 16 * ( ( header_size + size + 15 ) / 16 ); }
+
+        /// @return whether the storage starts with @p header, then wire_data() can be sent as it is
+        bool has_header( const message_header& header )const;
+        void set_header( const message_header& header );
+
+     private:
+        static const size_t header_size = 8;
+
+        std::shared_ptr<std::vector<char>> _storage;
+        size_t                             _size = 0;
+  };
+
+} } // graphene::net
+
+namespace fc {
+   void to_variant( const graphene::net::message_buffer& buffer, variant& v, uint32_t max_depth = 1 );
+   void from_variant( const variant& v, graphene::net::message_buffer& buffer, uint32_t max_depth = 1 );
+
+   namespace raw {
+      /// packed like a std::vector<char>
+      template<typename Stream>
+      inline void pack( Stream& s, const graphene::net::message_buffer& buffer, uint32_t _max_depth )
+      {
+         FC_ASSERT( _max_depth > 0 );
+         fc::raw::pack( s, unsigned_int( buffer.size() ), _max_depth - 1 );
+         if( buffer.size() )
+            s.write( buffer.data(), buffer.size() );
+      }
+      template<typename Stream>
+      inline void unpack( Stream& s, graphene::net::message_buffer& buffer, uint32_t _max_depth )
+      {
+         FC_ASSERT( _max_depth > 0 );
+         unsigned_int size; fc::raw::unpack( s, size, _max_depth - 1 );
+         FC_ASSERT( size.value < MAX_ARRAY_ALLOC_SIZE );
+         buffer = graphene::net::message_buffer( size.value );
+         if( size.value )
+            s.read( buffer.mutable_data(), size.value );
+      }
+   }
+}
+
+FC_REFLECT_TYPENAME( graphene::net::message_buffer )
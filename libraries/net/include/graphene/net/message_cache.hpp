@@ -0,0 +1,100 @@
+// see LICENSE.txt
+
+#pragma once
+#include <graphene/net/config.hpp>
+#include <graphene/net/message.hpp>
+#include <graphene/net/node.hpp>
+
+#include <fc/variant_object.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/tag.hpp>
+
+namespace graphene { namespace net {
+
+    /**
+     * Keeps the messages we have received or broadcast, which peers may request from us after we advertise them.
+     * Messages expire after a number of blocks, and the oldest ones go first when the cache holds more bytes than
+     * its limit. The newest message is kept even if it alone is over the limit. Lookups are hashed.
+     */
+    class blockchain_tied_message_cache
+    {
+    private:
+      static const uint32_t cache_duration_in_blocks = GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS;
+
+      struct message_hash_index{};
+      struct message_contents_hash_index{};
+      struct message_info
+      {
+        message_hash_type message_hash;
+        message           message_body;
+        uint32_t          block_clock_when_received;
+
+        // for network performance stats
+        message_propagation_data propagation_data;
+        fc::uint160_t     message_contents_hash; // hash of whatever the message contains (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
+
+        message_info( const message_hash_type& message_hash,
+                      const message&           message_body,
+                      uint32_t                 block_clock_when_received,
+                      const message_propagation_data& propagation_data,
+                      message_hash_type        message_contents_hash ) :
+          message_hash( message_hash ),
+          message_body( message_body ),
+          block_clock_when_received( block_clock_when_received ),
+          propagation_data( propagation_data ),
+          message_contents_hash( message_contents_hash ) { }
+
+        size_t size_in_bytes()const { return sizeof(message_info) + message_body.data.size(); }
+      };
+      // the sequence is the order the messages were cached in, which is also the order of their block clocks
+      using message_cache_container = boost::multi_index_container<message_info,
+         boost::multi_index::indexed_by<
+            boost::multi_index::sequenced<>,
+            boost::multi_index::hashed_unique< boost::multi_index::tag<message_hash_index>,
+               boost::multi_index::member<message_info, message_hash_type, &message_info::message_hash>,
+               std::hash<message_hash_type> >,
+            boost::multi_index::hashed_non_unique< boost::multi_index::tag<message_contents_hash_index>,
+               boost::multi_index::member<message_info, message_hash_type, &message_info::message_contents_hash>,
+               std::hash<message_hash_type> > > >;
+
+      message_cache_container _message_cache;
+
+      uint32_t block_clock;
+      size_t   _size_in_bytes = 0;
+      size_t   _max_size_in_bytes = GRAPHENE_NET_MESSAGE_CACHE_MAX_BYTES;
+
+      // statistics
+      uint64_t _hits = 0;
+      uint64_t _misses = 0;
+      uint64_t _expired = 0;
+      uint64_t _evicted = 0;
+
+      void pop_oldest();
+      void evict_over_max_size();
+
+    public:
+      blockchain_tied_message_cache() :
+        block_clock( 0 )
+      {}
+      void block_accepted();
+      void cache_message( const message& message_to_cache,
+                          const message_hash_type& hash_of_message_to_cache,
+                          const message_propagation_data& propagation_data,
+                          const message_hash_type& message_content_hash );
+      message get_message( const message_hash_type& hash_of_message_to_lookup );
+      message_propagation_data get_message_propagation_data(
+       const message_hash_type& hash_of_message_contents_to_lookup ) const;
+      size_t size() const { return _message_cache.size(); }
+      size_t size_in_bytes() const { return _size_in_bytes; }
+
+      size_t get_max_size_in_bytes() const { return _max_size_in_bytes; }
+      /// Evicts the oldest messages until the cache fits in @p max_size_in_bytes or holds a single message
+      void set_max_size_in_bytes( size_t max_size_in_bytes );
+      fc::variant_object get_statistics() const;
+    };
+
+} } // graphene::net
@@ -107,8 +107,8 @@ namespace graphene { namespace net
         virtual ~queued_message() = default;
       };
 
-      /* when you queue up a 'real_queued_message', a full copy of the message is
-       * stored on the heap until it is sent
+      /* when you queue up a 'real_queued_message', a copy of the message is
+       * kept until it is sent, its data is shared with the other copies
        */
       struct real_queued_message : queued_message
       {
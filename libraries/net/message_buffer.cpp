@@ -0,0 +1,116 @@
+// see LICENSE.txt
+
+#include <graphene/net/message_buffer.hpp>
+#include <graphene/net/message.hpp>
+#include <graphene/net/config.hpp>
+
+#include <cstring>
+#include <mutex>
+
+namespace graphene { namespace net {
+
+  namespace {
+
+    class storage_pool
+    {
+      public:
+        std::shared_ptr<std::vector<char>> take( size_t size )
+        {
+          std::unique_ptr<std::vector<char>> storage;
+          {
+            std::lock_guard<std::mutex> lock( _mutex );
+            if( !_free.empty() )
+            {
+              storage = std::move( _free.back() );
+              _free.pop_back();
+            }
+          }
+          if( !storage )
+            storage.reset( new std::vector<char>() );
+          storage->resize( size );
+          return std::shared_ptr<std::vector<char>>( storage.release(), [this]( std::vector<char>* released ) {
+            give_back( released );
+          } );
+        }
+
+      private:
+        void give_back( std::vector<char>* released )
+        {
+          std::unique_ptr<std::vector<char>> storage( released );
+          if( storage->capacity() > GRAPHENE_NET_MESSAGE_BUFFER_POOL_MAX_BYTES )
+            return;
+          std::lock_guard<std::mutex> lock( _mutex );
+          if( _free.size() < GRAPHENE_NET_MESSAGE_BUFFER_POOL_SIZE )
+            _free.push_back( std::move( storage ) );
+        }
+
+        std::mutex                                      _mutex;
+        std::vector<std::unique_ptr<std::vector<char>>> _free;
+    };
+
+    // never destroyed, the buffers of static messages may be released after the static objects are gone
+    storage_pool& pool()
+    {
+      static storage_pool* the_pool = new storage_pool();
+      return *the_pool;
+    }
+
+  }
+
+  static_assert( sizeof(message_header) == 8, "the header is expected to take 8 bytes on the wire" );
+
+  message_buffer::message_buffer( size_t size )
+  : _storage( pool().take( wire_size( size ) ) ), _size( size )
+  {
+    // the padding of a reused storage holds what was there before
+    const size_t payload_end = header_size + size;
+    memset( _storage->data() + payload_end, 0, _storage->size() - payload_end );
+  }
+
+  char* message_buffer::mutable_data()
+  {
+    return mutable_wire_data() + header_size;
+  }
+
+  char* message_buffer::mutable_wire_data()
+  {
+    if( !_storage )
+      *this = message_buffer( 0 );
+    else if( _storage.use_count() > 1 )
+    {
+      std::shared_ptr<std::vector<char>> copy = pool().take( _storage->size() );
+      memcpy( copy->data(), _storage->data(), _storage->size() );
+      _storage = std::move( copy );
+    }
+    return _storage->data();
+  }
+
+  bool message_buffer::has_header( const message_header& header )const
+  {
+    return _storage && memcmp( _storage->data(), (const char*)&header, header_size ) == 0;
+  }
+
+  void message_buffer::set_header( const message_header& header )
+  {
+    memcpy( mutable_wire_data(), (const char*)&header, header_size );
+  }
+
+} } // graphene::net
+
+namespace fc {
+
+  void to_variant( const graphene::net::message_buffer& buffer, variant& v, uint32_t max_depth )
+  {
+    to_variant( std::vector<char>( buffer.data(), buffer.data() + buffer.size() ), v, max_depth );
+  }
+
+  void from_variant( const variant& v, graphene::net::message_buffer& buffer, uint32_t max_depth )
+  {
+    std::vector<char> bytes;
+    from_variant( v, bytes, max_depth );
+    buffer = graphene::net::message_buffer( bytes.size() );
+    if( !bytes.empty() )
+      memcpy( buffer.mutable_data(), bytes.data(), bytes.size() );
+  }
+
+}
@@ -0,0 +1,99 @@
+// see LICENSE.txt
+
+#include <graphene/net/message_cache.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/raw.hpp>
+
+namespace graphene { namespace net {
+
+    void blockchain_tied_message_cache::pop_oldest()
+    {
+      _size_in_bytes -= _message_cache.front().size_in_bytes();
+      _message_cache.pop_front();
+    }
+
+    void blockchain_tied_message_cache::evict_over_max_size()
+    {
+      while( _size_in_bytes > _max_size_in_bytes && _message_cache.size() > 1 )
+      {
+        pop_oldest();
+        ++_evicted;
+      }
+    }
+
+    void blockchain_tied_message_cache::block_accepted()
+    {
+      ++block_clock;
+      if( block_clock > cache_duration_in_blocks )
+      {
+        while( !_message_cache.empty()
+               && _message_cache.front().block_clock_when_received < block_clock - cache_duration_in_blocks )
+        {
+          pop_oldest();
+          ++_expired;
+        }
+      }
+    }
+
+    void blockchain_tied_message_cache::cache_message( const message& message_to_cache,
+                                                       const message_hash_type& hash_of_message_to_cache,
+                                                       const message_propagation_data& propagation_data,
+                                                       const message_hash_type& message_content_hash )
+    {
+      auto result = _message_cache.push_back( message_info(hash_of_message_to_cache,
+                                                            message_to_cache,
+                                                            block_clock,
+                                                            propagation_data,
+                                                            message_content_hash ) );
+      if( !result.second )
+        return;
+      _size_in_bytes += result.first->size_in_bytes();
+      evict_over_max_size();
+    }
+
+    message blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup )
+    {
+      message_cache_container::index<message_hash_index>::type::const_iterator iter =
+         _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
+      if( iter != _message_cache.get<message_hash_index>().end() )
+      {
+        ++_hits;
+        return iter->message_body;
+      }
+      ++_misses;
+      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
+    }
+
+    message_propagation_data blockchain_tied_message_cache::get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const
+    {
+      if( hash_of_message_contents_to_lookup != message_hash_type() )
+      {
+        message_cache_container::index<message_contents_hash_index>::type::const_iterator iter =
+           _message_cache.get<message_contents_hash_index>().find(hash_of_message_contents_to_lookup );
+        if( iter != _message_cache.get<message_contents_hash_index>().end() )
+          return iter->propagation_data;
+      }
+      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
+    }
+
+    void blockchain_tied_message_cache::set_max_size_in_bytes( size_t max_size_in_bytes )
+    {
+      _max_size_in_bytes = max_size_in_bytes;
+      evict_over_max_size();
+    }
+
+    fc::variant_object blockchain_tied_message_cache::get_statistics() const
+    {
+      fc::mutable_variant_object result;
+      result["messages"] = _message_cache.size();
+      result["bytes"] = _size_in_bytes;
+      result["max_bytes"] = _max_size_in_bytes;
+      result["hits"] = _hits;
+      result["misses"] = _misses;
+      result["expired"] = _expired;
+      result["evicted"] = _evicted;
+      return result;
+    }
+
+} } // graphene::net
@@ -121,7 +121,6 @@ namespace graphene { namespace net {
     {
       VERIFY_CORRECT_THREAD();
       const int BUFFER_SIZE = 16;
-      const int LEFTOVER = BUFFER_SIZE - sizeof(message_header);
       static_assert(BUFFER_SIZE >= sizeof(message_header), "insufficient buffer");
 
       _connected_time = fc::time_point::now();
@@ -141,15 +140,20 @@ namespace graphene { namespace net {
 
           FC_ASSERT( m.size.value() <= MAX_MESSAGE_SIZE, "", ("m.size",m.size.value())("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
 
-          size_t remaining_bytes_with_padding = 16 * ((m.size.value() - LEFTOVER + 15) / 16);
-          m.data.resize(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
-          std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin());
+          // the rest of the message is read in place, behind the header, into a buffer which the copies of the
+          // message share, and it is sent to other peers from there
+          m.data = message_buffer(m.size.value());
+          char* wire_data = m.data.mutable_wire_data();
+          memcpy(wire_data, buffer, BUFFER_SIZE);
+          size_t remaining_bytes_with_padding = m.data.wire_size() - BUFFER_SIZE;
           if (remaining_bytes_with_padding)
           {
-            _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
+            _sock.read(wire_data + BUFFER_SIZE, remaining_bytes_with_padding);
             _bytes_received += remaining_bytes_with_padding;
           }
-          m.data.resize(m.size.value()); // truncate off the padding bytes
+          // zero the padding, as the send call does
+          size_t message_end = sizeof(message_header) + m.size.value();
+          memset(wire_data + message_end, 0, m.data.wire_size() - message_end);
 
           _last_message_received_time = fc::time_point::now();
 
@@ -240,14 +244,23 @@ namespace graphene { namespace net {
          }
          //pad the message we send to a multiple of 16 bytes
          size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-         std::vector<char> padded_message( size_with_padding );
-
-         memcpy( padded_message.data(), (const char*)&message_to_send, sizeof(message_header) );
-         memcpy( padded_message.data() + sizeof(message_header), message_to_send.data.data(),
-                 message_to_send.size.value() );
-         char* padding_space = padded_message.data() + sizeof(message_header) + message_to_send.size.value();
-         memset(padding_space, 0, size_with_padding - size_of_message_and_header);
-         _sock.write( padded_message.data(), size_with_padding );
+         if( message_to_send.data.has_header( message_to_send ) )
+         {
+            // the buffer is laid out as the message is sent, it is shared with the other peers it is queued for
+            assert( message_to_send.data.wire_size() == size_with_padding );
+            _sock.write( message_to_send.data.wire_data(), size_with_padding );
+         }
+         else
+         {
+            std::vector<char> padded_message( size_with_padding );
+
+            memcpy( padded_message.data(), (const char*)&message_to_send, sizeof(message_header) );
+            memcpy( padded_message.data() + sizeof(message_header), message_to_send.data.data(),
+                    message_to_send.size.value() );
+            char* padding_space = padded_message.data() + sizeof(message_header) + message_to_send.size.value();
+            memset(padding_space, 0, size_with_padding - size_of_message_and_header);
+            _sock.write( padded_message.data(), size_with_padding );
+         }
          _sock.flush();
          _bytes_sent += size_with_padding;
          _last_message_sent_time = fc::time_point::now();
@@ -51,6 +51,7 @@
 #include <fc/network/ip.hpp>
 
 #include <graphene/net/node.hpp>
+#include <graphene/net/message_cache.hpp>
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/peer_connection.hpp>
 #include <graphene/net/stcp_socket.hpp>
@@ -90,105 +91,6 @@ namespace graphene { namespace net {
   namespace detail
   {
     namespace bmi = boost::multi_index;
-    class blockchain_tied_message_cache
-    {
-    private:
-      static const uint32_t cache_duration_in_blocks = GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS;
-
-      struct message_hash_index{};
-      struct message_contents_hash_index{};
-      struct block_clock_index{};
-      struct message_info
-      {
-        message_hash_type message_hash;
-        message           message_body;
-        uint32_t          block_clock_when_received;
-
-        // for network performance stats
-        message_propagation_data propagation_data;
-        fc::uint160_t     message_contents_hash; // hash of whatever the message contains (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
-
-        message_info( const message_hash_type& message_hash,
-                      const message&           message_body,
-                      uint32_t                 block_clock_when_received,
-                      const message_propagation_data& propagation_data,
-                      message_hash_type        message_contents_hash ) :
-          message_hash( message_hash ),
-          message_body( message_body ),
-          block_clock_when_received( block_clock_when_received ),
-          propagation_data( propagation_data ),
-          message_contents_hash( message_contents_hash ) { }
-      };
-       using message_cache_container = boost::multi_index_container<message_info,
-          bmi::indexed_by<
-             bmi::ordered_unique< bmi::tag<message_hash_index>,
-                bmi::member<message_info, message_hash_type, &message_info::message_hash> >,
-             bmi::ordered_non_unique< bmi::tag<message_contents_hash_index>,
-                bmi::member<message_info, message_hash_type, &message_info::message_contents_hash> >,
-             bmi::ordered_non_unique< bmi::tag<block_clock_index>,
-                bmi::member<message_info, uint32_t, &message_info::block_clock_when_received> > > >;
-
-      message_cache_container _message_cache;
-
-      uint32_t block_clock;
-
-    public:
-      blockchain_tied_message_cache() :
-        block_clock( 0 )
-      {}
-      void block_accepted();
-       void cache_message( const message& message_to_cache,
-                           const message_hash_type& hash_of_message_to_cache,
-                           const message_propagation_data& propagation_data,
-                           const message_hash_type& message_content_hash );
-      message get_message( const message_hash_type& hash_of_message_to_lookup );
-      message_propagation_data get_message_propagation_data(
-       const message_hash_type& hash_of_message_contents_to_lookup ) const;
-      size_t size() const { return _message_cache.size(); }
-    };
-
-    void blockchain_tied_message_cache::block_accepted()
-    {
-      ++block_clock;
-      if( block_clock > cache_duration_in_blocks )
-      {
-         _message_cache.get<block_clock_index>().erase(_message_cache.get<block_clock_index>().begin(),
-                                                       _message_cache.get<block_clock_index>().lower_bound(block_clock - cache_duration_in_blocks));
-      }
-    }
-
-     void blockchain_tied_message_cache::cache_message( const message& message_to_cache,
-                                                        const message_hash_type& hash_of_message_to_cache,
-                                                        const message_propagation_data& propagation_data,
-                                                        const message_hash_type& message_content_hash )
-    {
-      _message_cache.insert( message_info(hash_of_message_to_cache,
-                                         message_to_cache,
-                                         block_clock,
-                                         propagation_data,
-                                         message_content_hash ) );
-    }
-
-    message blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup )
-    {
-      message_cache_container::index<message_hash_index>::type::const_iterator iter =
-         _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
-      if( iter != _message_cache.get<message_hash_index>().end() )
-        return iter->message_body;
-      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
-    }
-
-    message_propagation_data blockchain_tied_message_cache::get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const
-    {
-      if( hash_of_message_contents_to_lookup != message_hash_type() )
-      {
-        message_cache_container::index<message_contents_hash_index>::type::const_iterator iter =
-           _message_cache.get<message_contents_hash_index>().find(hash_of_message_contents_to_lookup );
-        if( iter != _message_cache.get<message_contents_hash_index>().end() )
-          return iter->propagation_data;
-      }
-      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
-    }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -2855,6 +2757,7 @@ namespace graphene { namespace net { namespace detail {
     }
 
     void node_impl::process_block_during_normal_operation( peer_connection* originating_peer,
+                                                           const message& message_to_process,
                                                            const graphene::net::block_message& block_message_to_process,
                                                            const message_hash_type& message_hash )
     {
@@ -2930,7 +2833,8 @@ namespace graphene { namespace net { namespace detail {
           peer->clear_old_inventory();
         }
         message_propagation_data propagation_data{message_receive_time, message_validated_time, originating_peer->node_id};
-        broadcast( block_message_to_process, propagation_data );
+        // the message as received, its data is not packed again and is shared by the cache and the send queues
+        broadcast( message_to_process, propagation_data, block_message_to_process.block_id );
         _message_cache.block_accepted();
 
         if (is_hard_fork_block(block_number))
@@ -3026,7 +2930,7 @@ namespace graphene { namespace net { namespace detail {
       if (item_iter != originating_peer->items_requested_from_peer.end())
       {
         originating_peer->items_requested_from_peer.erase(item_iter);
-        process_block_during_normal_operation(originating_peer, block_message_to_process, message_hash);
+        process_block_during_normal_operation(originating_peer, message_to_process, block_message_to_process, message_hash);
         if (originating_peer->idle())
           trigger_fetch_items_loop();
         return;
@@ -4387,15 +4291,18 @@ namespace graphene { namespace net { namespace detail {
       return (uint32_t)_active_connections.size();
     }
 
-    void node_impl::broadcast( const message& item_to_broadcast, const message_propagation_data& propagation_data )
+    void node_impl::broadcast( const message& item_to_broadcast, const message_propagation_data& propagation_data,
+                               const fc::optional<block_id_type>& block_id /* = fc::optional<block_id_type>() */ )
     {
       VERIFY_CORRECT_THREAD();
       message_hash_type hash_of_message_contents;
       if( item_to_broadcast.msg_type.value() == graphene::net::block_message_type )
       {
-        graphene::net::block_message block_message_to_broadcast = item_to_broadcast.as<graphene::net::block_message>();
-        hash_of_message_contents = block_message_to_broadcast.block_id; // for debugging
-        _most_recent_blocks_accepted.push_back( block_message_to_broadcast.block_id );
+        // a block received from a peer has been unpacked already, only the ones from the client are unpacked here
+        const block_id_type id = block_id.valid() ? *block_id
+                                                  : item_to_broadcast.as<graphene::net::block_message>().block_id;
+        hash_of_message_contents = id; // for debugging
+        _most_recent_blocks_accepted.push_back( id );
       }
       else if( item_to_broadcast.msg_type.value() == graphene::net::trx_message_type )
       {
@@ -4458,6 +4365,8 @@ namespace graphene { namespace net { namespace detail {
         _maximum_number_of_sync_blocks_to_prefetch = params["maximum_number_of_sync_blocks_to_prefetch"].as<uint32_t>(1);
       if (params.contains("maximum_blocks_per_peer_during_syncing"))
         _maximum_blocks_per_peer_during_syncing = params["maximum_blocks_per_peer_during_syncing"].as<uint32_t>(1);
+      if (params.contains("message_cache_max_bytes"))
+        _message_cache.set_max_size_in_bytes(params["message_cache_max_bytes"].as<uint64_t>(1));
 
       _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
@@ -4477,6 +4386,7 @@ namespace graphene { namespace net { namespace detail {
       result["maximum_number_of_blocks_to_handle_at_one_time"] = _maximum_number_of_blocks_to_handle_at_one_time;
       result["maximum_number_of_sync_blocks_to_prefetch"] = _maximum_number_of_sync_blocks_to_prefetch;
       result["maximum_blocks_per_peer_during_syncing"] = _maximum_blocks_per_peer_during_syncing;
+      result["message_cache_max_bytes"] = _message_cache.get_max_size_in_bytes();
       return result;
     }
 
@@ -4545,6 +4455,7 @@ namespace graphene { namespace net { namespace detail {
       info["node_public_key"] = fc::variant( _node_public_key, 1 );
       info["node_id"] = fc::variant( _node_id, 1 );
       info["firewalled"] = fc::variant( _is_firewalled, 1 );
+      info["message_cache"] = _message_cache.get_statistics();
       return info;
     }
     fc::variant_object node_impl::network_get_usage_stats() const
@@ -566,7 +566,8 @@ class node_impl : public peer_connection_delegate
       void trigger_process_backlog_of_sync_blocks();
 
       void process_block_during_syncing( peer_connection* originating_peer, const graphene::net::block_message& block_message_to_process, const message_hash_type& );
-      void process_block_during_normal_operation(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash);
+      void process_block_during_normal_operation(peer_connection* originating_peer, const message& message_to_process,
+                                                 const graphene::net::block_message& block_message, const message_hash_type& message_hash);
       void process_block_message(peer_connection* originating_peer, const message& message_to_process, const message_hash_type& message_hash);
       void process_ordinary_message(peer_connection* originating_peer, const message& message_to_process, const message_hash_type& message_hash);
 
@@ -615,7 +616,8 @@ class node_impl : public peer_connection_delegate
       std::vector<peer_status> get_connected_peers() const;
       uint32_t                 get_connection_count() const;
 
-      void broadcast(const message& item_to_broadcast, const message_propagation_data& propagation_data);
+      void broadcast(const message& item_to_broadcast, const message_propagation_data& propagation_data,
+                     const fc::optional<block_id_type>& block_id = fc::optional<block_id_type>());
       void broadcast(const message& item_to_broadcast);
       void sync_from(const item_id& current_head_block, const std::vector<uint32_t>& hard_fork_block_numbers);
       bool is_connected() const;
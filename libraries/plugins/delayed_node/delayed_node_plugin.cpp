@@ -9,6 +9,8 @@
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/api.hpp>
 
+#include <deque>
+
 namespace graphene { namespace delayed_node {
 namespace bpo = boost::program_options;
 
@@ -21,7 +23,32 @@ struct delayed_node_plugin_impl {
    boost::signals2::scoped_connection client_connection_closed;
    graphene::chain::block_id_type last_received_remote_head;
    graphene::chain::block_id_type last_processed_remote_head;
+   /// blocks asked per get_blocks call, 0 to fetch them one by one with get_block_reserved
+   uint32_t blocks_per_request = 100;
+   uint32_t requests_in_flight = 4;
 };
+
+/// @return true if @p e carries the reply of a trusted node which does not know the method called
+bool is_method_not_found(const fc::exception& e)
+{
+   for (const fc::log_message& message: e.get_log())
+   {
+      // the rpc client keeps the whole response in the data of the exception
+      const fc::variant_object& data = message.get_data();
+      auto response = data.find("data");
+      if (response == data.end() || !response->value().is_object())
+         continue;
+      const fc::variant_object& reply = response->value().get_object();
+      auto error = reply.find("error");
+      if (error == reply.end() || !error->value().is_object())
+         continue;
+      auto code = error->value().get_object().find("code");
+      if (code != error->value().get_object().end() && code->value().is_numeric()
+          && code->value().as_int64() == -32601)
+         return true;
+   }
+   return false;
+}
 }
 
 delayed_node_plugin::delayed_node_plugin()
@@ -33,7 +60,12 @@ void delayed_node_plugin::plugin_set_program_options(bpo::options_description& c
 {
    cli.add_options()
       ("trusted-node", boost::program_options::value<std::string>(),
-      "RPC endpoint of a trusted validating node (required for delayed_node)");
+      "RPC endpoint of a trusted validating node (required for delayed_node)")
+      ("delayed-node-blocks-per-request", boost::program_options::value<uint32_t>()->default_value(100),
+      "Number of blocks asked from the trusted node per call, at most 100, 0 to fetch the blocks one by one. "
+      "The blocks are fetched one by one as well once the trusted node turns out to have no get_blocks")
+      ("delayed-node-requests-in-flight", boost::program_options::value<uint32_t>()->default_value(4),
+      "Number of block requests to the trusted node kept in flight while the blocks already received are applied");
    cfg.add(cli);
 }
 
@@ -72,6 +104,10 @@ void delayed_node_plugin::plugin_initialize(const boost::program_options::variab
    FC_ASSERT(options.count("trusted-node") > 0);
    my = std::unique_ptr<detail::delayed_node_plugin_impl>{ new detail::delayed_node_plugin_impl() };
    my->remote_endpoint = "ws://" + options.at("trusted-node").as<std::string>();
+   if( options.count("delayed-node-blocks-per-request") > 0 )
+      my->blocks_per_request = std::min<uint32_t>( options.at("delayed-node-blocks-per-request").as<uint32_t>(), 100 );
+   if( options.count("delayed-node-requests-in-flight") > 0 )
+      my->requests_in_flight = std::max<uint32_t>( options.at("delayed-node-requests-in-flight").as<uint32_t>(), 1 );
 }
 
 void delayed_node_plugin::sync_with_trusted_node()
@@ -95,6 +131,26 @@ void delayed_node_plugin::sync_with_trusted_node()
 
       pass_count++;
 
+      if (my->blocks_per_request > 0)
+      {
+         auto database_api = my->database_api;
+         try
+         {
+            synced_blocks += sync_block_ranges(db, [database_api](uint32_t first, uint32_t count) {
+               return database_api->get_blocks(first, count);
+            }, remote_dpo.last_irreversible_block_num, my->blocks_per_request, my->requests_in_flight);
+            continue;
+         }
+         catch (const fc::exception& e)
+         {
+            if (!detail::is_method_not_found(e))
+               throw;
+            // an older trusted node, the blocks pushed before the failed request stay
+            wlog("Trusted node has no get_blocks, fetching the blocks one by one from now on");
+            my->blocks_per_request = 0;
+         }
+      }
+
       while (remote_dpo.last_irreversible_block_num > db.head_block_num())
       {
          fc::optional<graphene::chain::signed_block> block = my->database_api->get_block_reserved(db.head_block_num()+1);
@@ -107,6 +163,85 @@ void delayed_node_plugin::sync_with_trusted_node()
    }
 }
 
+uint32_t sync_block_ranges(graphene::chain::database& db, const block_range_fetcher& fetch, uint32_t last_block_num,
+                           uint32_t blocks_per_request, uint32_t requests_in_flight)
+{
+   struct block_request
+   {
+      uint32_t first;
+      uint32_t count;
+      fc::future<std::vector<std::vector<char>>> blocks;
+   };
+   std::deque<block_request> requests;
+   uint32_t next_block_num = db.head_block_num() + 1;
+
+   // the trusted node serves the next ranges while the blocks received are pushed
+   auto request_ranges = [&]()
+   {
+      while (requests.size() < requests_in_flight && next_block_num <= last_block_num)
+      {
+         const uint32_t first = next_block_num;
+         const uint32_t count = std::min(blocks_per_request, last_block_num - first + 1);
+         requests.push_back({first, count, fc::async([fetch, first, count]() {
+            return fetch(first, count);
+         }, "delayed node get_blocks")});
+         next_block_num += count;
+      }
+   };
+   // the requests are not left running, they call the fetcher of the caller
+   auto drop_requests = [&]()
+   {
+      for (block_request& request: requests)
+      {
+         try
+         {
+            request.blocks.cancel_and_wait();
+         }
+         catch (const fc::exception&) {}
+      }
+      requests.clear();
+   };
+
+   uint32_t synced_blocks = 0;
+   request_ranges();
+   try
+   {
+      while (!requests.empty())
+      {
+         block_request request = std::move(requests.front());
+         requests.pop_front();
+         const std::vector<std::vector<char>> packed_blocks = request.blocks.wait();
+         request_ranges();
+
+         FC_ASSERT(!packed_blocks.empty(), "Trusted node claims it has blocks it doesn't actually have.");
+         ilog("Pushing blocks #${f} to #${l}", ("f", request.first)("l", request.first + packed_blocks.size() - 1));
+         for (const std::vector<char>& packed: packed_blocks)
+         {
+            graphene::chain::signed_block block = fc::raw::unpack<graphene::chain::signed_block>(packed);
+            block.update();
+            FC_ASSERT(block.block_num() == db.head_block_num() + 1, "Trusted node sent block #${n} instead of #${e}",
+                      ("n", block.block_num())("e", db.head_block_num() + 1));
+            db.push_block(block);
+            synced_blocks++;
+         }
+
+         // the following ranges were asked beyond what the trusted node has, ask again from the new head
+         if (packed_blocks.size() < request.count)
+         {
+            drop_requests();
+            next_block_num = db.head_block_num() + 1;
+            request_ranges();
+         }
+      }
+   }
+   catch (...)
+   {
+      drop_requests();
+      throw;
+   }
+   return synced_blocks;
+}
+
 void delayed_node_plugin::mainloop()
 {
    while( true )
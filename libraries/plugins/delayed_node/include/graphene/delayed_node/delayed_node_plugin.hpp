@@ -4,6 +4,9 @@
 
 #include <graphene/app/plugin.hpp>
 
+#include <functional>
+#include <vector>
+
 namespace graphene { namespace delayed_node {
 namespace detail { struct delayed_node_plugin_impl; }
 
@@ -27,5 +30,16 @@ protected:
    void sync_with_trusted_node();
 };
 
+/// Returns the packed blocks from @p first on, at most @p count and fewer if the source does not have them all
+typedef std::function<std::vector<std::vector<char>>(uint32_t first, uint32_t count)> block_range_fetcher;
+
+/**
+ * Pushes the blocks after the head of @p db up to @p last_block_num, fetched by @p fetch in ranges of
+ * @p blocks_per_request blocks. Up to @p requests_in_flight ranges are asked ahead while the blocks received are
+ * pushed. Returns how many blocks were pushed.
+ */
+uint32_t sync_block_ranges(graphene::chain::database& db, const block_range_fetcher& fetch, uint32_t last_block_num,
+                           uint32_t blocks_per_request, uint32_t requests_in_flight);
+
 } } //graphene::history
 
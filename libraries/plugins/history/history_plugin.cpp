@@ -128,6 +128,7 @@ void history_plugin_impl::update_histories(const signed_block& b)
                obj.sequence     = stats_obj.total_ops+1;
                obj.next         = stats_obj.most_recent_op;
                obj.block_time   = b.timestamp;
+               obj.op_type      = op.op.which();
             });
             db.modify(stats_obj, [&]( account_statistics_object& obj)
             {
@@ -155,6 +156,7 @@ void history_plugin_impl::update_histories(const signed_block& b)
                      obj.sequence     = stats_obj.total_ops+1;
                      obj.next         = stats_obj.most_recent_op;
                      obj.block_time   = b.timestamp;
+                     obj.op_type      = op.op.which();
                   });
                db.modify( stats_obj, [&]( account_statistics_object& obj)
                {
@@ -52,6 +52,8 @@ void witness_plugin::plugin_set_program_options(
          ("private-key", bpo::value<vector<string>>()->composing()->multitoken()->
           DEFAULT_VALUE_VECTOR(std::make_pair(chain::public_key_type(default_priv_key.get_public_key()), graphene::utilities::key_to_wif(default_priv_key))),
           "Tuple of [PublicKey, WIF private key] (may specify multiple times)")
+         ("production-time-limit", bpo::value<uint32_t>()->default_value(500),
+          "Milliseconds a block may take to produce, pending transactions not applied by then are left for a later block")
          ;
    config_file_options.add(command_line_options);
 }
@@ -66,6 +68,8 @@ void witness_plugin::plugin_initialize(const boost::program_options::variables_m
    ilog("witness plugin:  plugin_initialize() begin");
    _options = &options;
    LOAD_VALUE_SET(options, "witness-id", _witnesses, chain::witness_id_type)
+   if( options.count("production-time-limit") )
+      _production_time_limit = fc::milliseconds( options["production-time-limit"].as<uint32_t>() );
 
    if( options.count("private-key") )
    {
@@ -199,7 +203,7 @@ block_production_condition::block_production_condition_enum witness_plugin::bloc
    switch( result )
    {
       case block_production_condition::produced:
-         ilog("Generated block #${n} with ${x} transaction(s) and timestamp ${t} at time ${c}", (capture));
+         ilog("Generated block #${n} with ${x} transaction(s) and timestamp ${t} at time ${c} in ${us} us", (capture));
          break;
       case block_production_condition::not_synced:
          ilog("Not producing block because production is disabled until we receive a recent block (see: --enable-stale-production)");
@@ -307,9 +311,11 @@ block_production_condition::block_production_condition_enum witness_plugin::mayb
       scheduled_time,
       scheduled_witness,
       private_key_itr->second,
-      _production_skip_flags);
+      _production_skip_flags,
+      fc::time_point::now() + _production_time_limit);
 
-   capture("n", block.block_num())("t", block.timestamp)("c", now)("x", block.transactions.size());
+   capture("n", block.block_num())("t", block.timestamp)("c", now)("x", block.transactions.size())
+          ("us", db.get_last_block_production().wall_time_us);
    fc::async( [this,block](){ p2p_node()->broadcast(net::block_message(block)); } );
 
    return block_production_condition::produced;
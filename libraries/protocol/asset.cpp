@@ -188,4 +188,6 @@ const int64_t scaled_precision_lut[19] =
 
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::asset )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::price )
-GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::price_feed )
\ No newline at end of file
+GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::price_feed )
+
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::protocol::asset )
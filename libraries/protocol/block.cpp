@@ -72,4 +72,8 @@ namespace graphene { namespace protocol {
 
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::block_header)
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::signed_block_header)
-GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::signed_block)
\ No newline at end of file
+GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::signed_block)
+
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::protocol::block_header )
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::protocol::signed_block_header )
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::protocol::signed_block )
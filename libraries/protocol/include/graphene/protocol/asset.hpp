@@ -200,4 +200,6 @@ FC_REFLECT( graphene::protocol::price_feed, GRAPHENE_PRICE_FEED_FIELDS )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::asset )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::price )
-GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::price_feed )
\ No newline at end of file
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::price_feed )
+
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::protocol::asset )
@@ -49,4 +49,8 @@ FC_REFLECT_DERIVED( graphene::protocol::signed_block, (graphene::protocol::signe
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::block_header)
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::signed_block_header)
-GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::signed_block)
\ No newline at end of file
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::signed_block)
+
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::protocol::block_header )
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::protocol::signed_block_header )
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::protocol::signed_block )
@@ -198,4 +198,8 @@ FC_REFLECT_DERIVED( graphene::protocol::processed_transaction, (graphene::protoc
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::transaction)
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::signed_transaction)
 //GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::precomputable_transaction)
-GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::processed_transaction)
\ No newline at end of file
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::processed_transaction)
+
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::protocol::transaction )
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::protocol::signed_transaction )
+GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING( graphene::protocol::processed_transaction )
@@ -19,6 +19,7 @@
 #include <fc/container/flat_fwd.hpp>
 #include <fc/io/varint.hpp>
 #include <fc/io/enum_type.hpp>
+#include <fc/io/json_writer.hpp>
 #include <fc/crypto/sha224.hpp>
 #include <fc/crypto/elliptic.hpp>
 #include <fc/reflect/reflect.hpp>
@@ -48,6 +49,17 @@ namespace raw { \
 #define GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION(type) GRAPHENE_EXTERNAL_SERIALIZATION(extern, type)
 #define GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION(type) GRAPHENE_EXTERNAL_SERIALIZATION(/*not extern*/, type)
 
+// Lets json_writer write the members of a type without converting it to a variant. Declared in the header and
+// implemented in the source file of the type, next to its external serialization. Only for the types which have no
+// to_variant() of their own.
+#define GRAPHENE_EXTERNAL_JSON_STREAMING(ext, type) \
+namespace fc { \
+   ext template void json_writer::write_members< type >( const type& v ); \
+} // fc
+#define GRAPHENE_DECLARE_EXTERNAL_JSON_STREAMING(type) \
+   FC_JSON_STREAM_MEMBERS(type) GRAPHENE_EXTERNAL_JSON_STREAMING(extern, type)
+#define GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING(type) GRAPHENE_EXTERNAL_JSON_STREAMING(/*not extern*/, type)
+
 #define GRAPHENE_NAME_TO_OBJECT_TYPE(x, prefix, name) BOOST_PP_CAT(prefix, BOOST_PP_CAT(name, _object_type))
 #define GRAPHENE_NAME_TO_ID_TYPE(x, y, name) BOOST_PP_CAT(name, _id_type)
 #define GRAPHENE_DECLARE_ID(x, space_prefix_seq, name) \
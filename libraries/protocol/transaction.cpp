@@ -372,4 +372,8 @@ void signed_transaction::verify_authority(
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::transaction)
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::signed_transaction)
 //GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::precomputable_transaction)
-GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::processed_transaction)
\ No newline at end of file
+GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::protocol::processed_transaction)
+
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::protocol::transaction )
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::protocol::signed_transaction )
+GRAPHENE_IMPLEMENT_EXTERNAL_JSON_STREAMING( graphene::protocol::processed_transaction )
@@ -208,6 +208,10 @@ class wallet_api
       std::pair<uint32_t, std::vector<account_id_type>>
       get_users_with_asset(const asset_id_type& asst, uint32_t start, uint32_t limit) const;
 
+      vector<account_balance_object> get_asset_holders(asset_id_type asset_id, account_id_type start, uint32_t limit) const;
+      vector<account_balance_object> get_asset_holders_by_balance(asset_id_type asset_id, share_type start_balance,
+                                                                  account_id_type start, uint32_t limit) const;
+
       /** Returns information about the given asset.
        * @param asset_name_or_id the symbol or id of the asset in question
        * @returns the information about the asset stored in the block chain
@@ -1561,6 +1565,8 @@ FC_API( graphene::wallet::wallet_api,
         (get_user_count_by_ranks)
         (get_user_count_with_balances)
         (get_users_with_asset)
+        (get_asset_holders)
+        (get_asset_holders_by_balance)
         (get_account_id)
         (get_block)
         (get_account_count)
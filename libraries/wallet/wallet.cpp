@@ -446,6 +446,17 @@ wallet_api::get_users_with_asset(const asset_id_type& asst, uint32_t start, uint
    return my->_remote_db->get_users_with_asset(asst, start, limit);
 }
 
+vector<account_balance_object>
+wallet_api::get_asset_holders(asset_id_type asset_id, account_id_type start, uint32_t limit) const {
+   return my->_remote_db->get_asset_holders(asset_id, start, limit);
+}
+
+vector<account_balance_object>
+wallet_api::get_asset_holders_by_balance(asset_id_type asset_id, share_type start_balance,
+                                         account_id_type start, uint32_t limit) const {
+   return my->_remote_db->get_asset_holders_by_balance(asset_id, start_balance, start, limit);
+}
+
 asset_object wallet_api::get_asset(string asset_name_or_id) const
 {
    auto a = my->find_asset(asset_name_or_id);
@@ -0,0 +1,41 @@
+// see LICENSE.txt
+
+#include <iostream>
+#include <string>
+
+#include <fc/exception/exception.hpp>
+
+#include <graphene/chain/block_database.hpp>
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      if( argc < 2 || argc > 3 || std::string( argv[1] ) == "-h" || std::string( argv[1] ) == "--help" )
+      {
+         std::cerr << "block_log_converter <block-dir> [blocks-per-chunk]\n"
+             "\n"
+             "Moves the blocks of a stopped node into the compressed block archive.\n"
+             "<block-dir> is <data-dir>/blockchain/database/block_num_to_block\n"
+             "\n";
+         return 1;
+      }
+
+      uint32_t blocks_per_chunk = 1000;
+      if( argc == 3 )
+         blocks_per_chunk = std::stoul( argv[2] );
+
+      graphene::chain::block_database::convert( fc::path( argv[1] ), blocks_per_chunk );
+
+      graphene::chain::block_database bdb;
+      bdb.open( fc::path( argv[1] ) );
+      std::cout << "archived " << bdb.archive_size() << " block numbers\n";
+      bdb.close();
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+   return 0;
+}
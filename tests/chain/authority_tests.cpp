@@ -1330,4 +1330,91 @@ BOOST_FIXTURE_TEST_CASE( nonminimal_sig_test, database_fixture )
    }
 }
 
+BOOST_AUTO_TEST_CASE( cached_signature_keys )
+{
+   try {
+      fc::ecc::private_key alice_key = generate_private_key("alice");
+      fc::ecc::private_key bob_key = generate_private_key("bob");
+      const chain_id_type& chain_id = db.get_chain_id();
+
+      signed_transaction tx;
+      transfer_operation op;
+      op.amount = asset(1000);
+      tx.operations.push_back(op);
+      set_expiration( db, tx );
+      tx.sign( alice_key, chain_id );
+
+      db.precompute_parallel( tx );
+      BOOST_CHECK( db.signature_keys().contains( tx, chain_id ) );
+      BOOST_CHECK( db.signature_keys().get( tx, chain_id ) == flat_set<public_key_type>{ alice_key.get_public_key() } );
+
+      // a new signature or a change to the transaction is not served from the cache
+      tx.sign( bob_key, chain_id );
+      BOOST_CHECK( !db.signature_keys().contains( tx, chain_id ) );
+      BOOST_CHECK( db.signature_keys().get( tx, chain_id )
+                   == flat_set<public_key_type>({ alice_key.get_public_key(), bob_key.get_public_key() }) );
+      tx.operations.push_back(op);
+      BOOST_CHECK( db.signature_keys().get( tx, chain_id ).count( alice_key.get_public_key() ) == 0 );
+      tx.signatures.push_back( tx.signatures.back() );
+      db.precompute_parallel( tx );
+      BOOST_CHECK( !db.signature_keys().contains( tx, chain_id ) );
+      GRAPHENE_REQUIRE_THROW( db.signature_keys().get( tx, chain_id ), tx_duplicate_sig );
+   }
+   catch(fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( cached_signature_keys_of_block )
+{
+   try {
+      ACTORS( (alice)(bob) );
+      transfer( committee_account, alice_id, asset( 100000 ) );
+      generate_block();
+      const chain_id_type& chain_id = db.get_chain_id();
+
+      for( int i = 1; i <= 3; ++i )
+      {
+         signed_transaction tx;
+         transfer_operation op;
+         op.from = alice_id;
+         op.to = bob_id;
+         op.amount = asset( 100 * i );
+         tx.operations.push_back( op );
+         set_expiration( db, tx );
+         tx.sign( alice_private_key, chain_id );
+         PUSH_TX( db, tx );
+      }
+      const signed_block block = generate_block();
+      BOOST_REQUIRE_EQUAL( block.transactions.size(), 3u );
+      db.pop_block();
+      db.clear_pending();
+
+      // nothing is recovered when the signatures are skipped
+      db.precompute_parallel( block, database::skip_transaction_signatures );
+      for( const auto& tx : block.transactions )
+         BOOST_CHECK( !db.signature_keys().contains( tx, chain_id ) );
+
+      db.precompute_parallel( block );
+      for( const auto& tx : block.transactions )
+         BOOST_CHECK( db.signature_keys().contains( tx, chain_id ) );
+      BOOST_CHECK( db.signature_keys().get( block.transactions.back(), chain_id )
+                   == flat_set<public_key_type>{ alice_private_key.get_public_key() } );
+
+      // the block is checked with the recovered keys, which are dropped after it
+      db.push_block( block, database::skip_nothing );
+      BOOST_CHECK( db.head_block_id() == block.id() );
+      BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), 600 );
+      for( const auto& tx : block.transactions )
+         BOOST_CHECK( !db.signature_keys().contains( tx, chain_id ) );
+   }
+   catch(fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
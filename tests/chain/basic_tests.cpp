@@ -6,6 +6,7 @@
 
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/block_builder.hpp>
 #include <graphene/chain/exceptions.hpp>
 
 #include <graphene/db/simple_index.hpp>
@@ -402,4 +403,30 @@ BOOST_AUTO_TEST_CASE( merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+BOOST_AUTO_TEST_CASE( block_builder_merkle_root )
+{
+   BOOST_TEST_MESSAGE( "=== block_builder_merkle_root ===" );
+
+   signed_block block;
+   block_builder builder( 1000000, 0 );
+   BOOST_CHECK( builder.merkle_root() == checksum_type() );
+
+   for( uint32_t i = 0; i < 37; i++ )
+   {
+      processed_transaction trx;
+      trx.ref_block_prefix = i;
+      block.transactions.push_back( trx );
+      size_t size = fc::raw::pack_size( trx );
+      builder.push( std::move(trx), size );
+      BOOST_CHECK( builder.merkle_root() == block.calculate_merkle_root() );
+      BOOST_CHECK_EQUAL( builder.size(), i * size + size );
+   }
+   BOOST_CHECK( !builder.fits( 1000000 ) );
+
+   signed_block built;
+   builder.finish( built );
+   BOOST_CHECK_EQUAL( built.transactions.size(), 37u );
+   BOOST_CHECK( built.transaction_merkle_root == block.calculate_merkle_root() );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
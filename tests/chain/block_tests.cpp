@@ -10,12 +10,19 @@
 #include <graphene/chain/committee_member_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/chain/vesting_balance_object.hpp>
+#include <graphene/chain/witness_object.hpp>
+#include <graphene/chain/replay_pipeline.hpp>
 
 #include <graphene/utilities/tempdir.hpp>
 
+#include <graphene/delayed_node/delayed_node_plugin.hpp>
+
 #include <fc/crypto/digest.hpp>
 #include <fc/io/fstream.hpp>
 
+#include <boost/filesystem/operations.hpp>
+
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
@@ -101,6 +108,269 @@ BOOST_AUTO_TEST_CASE( block_database_test )
          FC_ASSERT( blk->witness == witness_id_type(blk->block_num()) );
       }
 
+      FC_ASSERT( bdb.contains( b.id() ) );
+      FC_ASSERT( bdb.fetch_block_id( b.block_num() ) == b.id() );
+      FC_ASSERT( !bdb.fetch_by_number( b.block_num() + 1 ).valid() );
+      GRAPHENE_REQUIRE_THROW( bdb.fetch_block_id( b.block_num() + 1 ), fc::key_not_found_exception );
+
+      // removing the head block makes the previous one the last block, also after reopening
+      bdb.remove( b.id() );
+      FC_ASSERT( !bdb.contains( b.id() ) );
+      FC_ASSERT( !bdb.fetch_optional( b.id() ).valid() );
+      FC_ASSERT( *bdb.last_id() == b.previous );
+      bdb.close();
+      bdb.open( data_dir.path() );
+      FC_ASSERT( *bdb.last_id() == b.previous );
+
+      // blocks appended after reopening can be read back
+      bdb.store( b.id(), b );
+      FC_ASSERT( bdb.last()->id() == b.id() );
+
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_archive_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+      vector<signed_block> blocks;
+      signed_block b;
+      for( uint32_t i = 0; i < 10; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+         blocks.push_back( b );
+      }
+      bdb.close();
+
+      // block numbers 0 to 7 fit into two complete chunks, 8 to 10 stay uncompressed
+      block_database::convert( data_dir.path(), 4 );
+      bdb.open( data_dir.path() );
+      BOOST_CHECK_EQUAL( bdb.archive_size(), 8u );
+
+      auto check_blocks = [&]()
+      {
+         for( const signed_block& blk : blocks )
+         {
+            BOOST_CHECK( bdb.contains( blk.id() ) );
+            BOOST_CHECK( bdb.fetch_block_id( blk.block_num() ) == blk.id() );
+            auto fetch = bdb.fetch_by_number( blk.block_num() );
+            BOOST_REQUIRE( fetch.valid() );
+            BOOST_CHECK( fetch->id() == blk.id() );
+            fetch = bdb.fetch_optional( blk.id() );
+            BOOST_REQUIRE( fetch.valid() );
+            BOOST_CHECK( fetch->witness == blk.witness );
+         }
+         BOOST_CHECK( !bdb.fetch_by_number( 0 ).valid() );
+         BOOST_CHECK( *bdb.last_id() == blocks.back().id() );
+
+         // packed ranges run from the archive into the uncompressed blocks and stop after the last block
+         auto packed = bdb.fetch_packed_range( 1, blocks.size() + 5 );
+         BOOST_REQUIRE_EQUAL( packed.size(), blocks.size() );
+         for( size_t i = 0; i < blocks.size(); ++i )
+            BOOST_CHECK( packed[i] == fc::raw::pack( blocks[i] ) );
+         BOOST_CHECK_EQUAL( bdb.fetch_packed_range( 3, 2 ).size(), 2u );
+      };
+      check_blocks();
+
+      GRAPHENE_REQUIRE_THROW( bdb.remove( blocks[2].id() ), fc::exception );
+
+      // new blocks go to the uncompressed part, converting again moves them into the archive
+      b.previous = b.id();
+      b.witness = witness_id_type(11);
+      bdb.store( b.id(), b );
+      blocks.push_back( b );
+      check_blocks();
+      bdb.close();
+
+      block_database::convert( data_dir.path(), 4 );
+      bdb.open( data_dir.path() );
+      BOOST_CHECK_EQUAL( bdb.archive_size(), 12u );
+      check_blocks();
+      bdb.close();
+
+      // the archive can be rebuilt with another chunk size
+      block_database::convert( data_dir.path(), 5 );
+      bdb.open( data_dir.path() );
+      BOOST_CHECK_EQUAL( bdb.archive_size(), 10u );
+      check_blocks();
+      BOOST_CHECK( bdb.last()->id() == blocks.back().id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_archive_interrupted_convert )
+{
+   try {
+      fc::temp_directory converted_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory interrupted_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory incomplete_dir( graphene::utilities::temp_directory_path() );
+
+      vector<signed_block> blocks;
+      signed_block b;
+      for( const fc::path& dir : { converted_dir.path(), interrupted_dir.path(), incomplete_dir.path() } )
+      {
+         block_database bdb;
+         bdb.open( dir );
+         b = signed_block();
+         blocks.clear();
+         for( uint32_t i = 0; i < 10; ++i )
+         {
+            if( i > 0 ) b.previous = b.id();
+            b.witness = witness_id_type(i+1);
+            bdb.store( b.id(), b );
+            blocks.push_back( b );
+         }
+         bdb.close();
+      }
+      block_database::convert( converted_dir.path(), 4 );
+
+      auto check_blocks = [&]( const fc::path& dir, uint32_t archive_size )
+      {
+         block_database bdb;
+         bdb.open( dir );
+         BOOST_CHECK_EQUAL( bdb.archive_size(), archive_size );
+         for( const signed_block& blk : blocks )
+         {
+            auto fetch = bdb.fetch_by_number( blk.block_num() );
+            BOOST_REQUIRE( fetch.valid() );
+            BOOST_CHECK( fetch->id() == blk.id() );
+         }
+         BOOST_CHECK( !fc::exists( dir / "convert" ) );
+      };
+
+      // a crash after the conversion was complete, while its files were being moved: the next open moves the rest
+      fc::create_directories( interrupted_dir.path() / "convert" );
+      for( const char* name : { "archive", "archive_index" } )
+         fc::copy( converted_dir.path() / name, interrupted_dir.path() / "convert" / name );
+      for( const char* name : { "index", "blocks" } )
+      {
+         fc::remove( interrupted_dir.path() / name );
+         fc::copy( converted_dir.path() / name, interrupted_dir.path() / name );
+      }
+      fc::ofstream( interrupted_dir.path() / "convert" / "complete" );
+      check_blocks( interrupted_dir.path(), 8 );
+
+      // a crash before the conversion was complete: the database is as before, the partial files are dropped
+      fc::create_directories( incomplete_dir.path() / "convert" );
+      for( const char* name : { "index", "blocks", "archive" } )
+         fc::copy( converted_dir.path() / name, incomplete_dir.path() / "convert" / name );
+      check_blocks( incomplete_dir.path(), 0 );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( delayed_node_block_ranges )
+{
+   try {
+      fc::temp_directory source_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory target_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      database source;
+      source.open( source_dir.path(), make_genesis );
+      for( uint32_t i = 0; i < 150; ++i )
+         source.generate_block(source.get_slot_time(1), source.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+      BOOST_CHECK( source.fetch_packed_blocks( 0, 5 ).empty() );
+      BOOST_CHECK( source.fetch_packed_blocks( 151, 5 ).empty() );
+      BOOST_CHECK_EQUAL( source.fetch_packed_blocks( 148, 10 ).size(), 3u );
+      database target;
+      target.open( target_dir.path(), make_genesis );
+
+      std::vector<uint32_t> firsts;
+      uint32_t in_flight = 0;
+      uint32_t max_in_flight = 0;
+      auto fetch = [&]( uint32_t first, uint32_t count ) {
+         firsts.push_back( first );
+         max_in_flight = std::max( max_in_flight, ++in_flight );
+         // the answer takes a while, the other requests are asked meanwhile
+         fc::usleep( fc::milliseconds( 5 ) );
+         --in_flight;
+         return source.fetch_packed_blocks( first, count );
+      };
+
+      // ranges of 7 blocks, 3 of them in flight
+      BOOST_CHECK_EQUAL( graphene::delayed_node::sync_block_ranges( target, fetch, 100, 7, 3 ), 100u );
+      BOOST_CHECK( target.head_block_id() == source.get_block_id_for_num( 100 ) );
+      BOOST_CHECK_EQUAL( max_in_flight, 3u );
+      std::sort( firsts.begin(), firsts.end() );
+      BOOST_REQUIRE_EQUAL( firsts.size(), 15u );
+      for( size_t i = 0; i < firsts.size(); ++i )
+         BOOST_CHECK_EQUAL( firsts[i], 1 + 7 * i );
+
+      // after a short range the following ones are asked again from the new head, where the source has none
+      GRAPHENE_REQUIRE_THROW( graphene::delayed_node::sync_block_ranges( target, fetch, 160, 7, 3 ), fc::exception );
+      BOOST_CHECK( target.head_block_id() == source.head_block_id() );
+      // no request is left running
+      const size_t requests = firsts.size();
+      fc::usleep( fc::milliseconds( 20 ) );
+      BOOST_CHECK_EQUAL( firsts.size(), requests );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( replay_pipeline_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+      vector<signed_block> blocks;
+      signed_block b;
+      for( uint32_t i = 0; i < 20; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         // one block with a bad merkle root
+         b.transaction_merkle_root = ( i == 6 ? checksum_type::hash( string("bad") ) : checksum_type() );
+         bdb.store( b.id(), b );
+         blocks.push_back( b );
+      }
+
+      {
+         replay_pipeline pipeline( bdb, 1, 20, 3, 4 );
+         for( const signed_block& blk : blocks )
+         {
+            auto next = pipeline.next();
+            BOOST_REQUIRE( next.block.valid() );
+            BOOST_CHECK( next.block->id() == blk.id() );
+            BOOST_CHECK_EQUAL( next.size, fc::raw::pack_size( blk ) );
+            BOOST_CHECK_EQUAL( next.merkle_root_valid, blk.block_num() != 7 );
+         }
+         BOOST_CHECK( !pipeline.next().block.valid() );
+      }
+
+      // the pipeline stops at the first missing block
+      bdb.remove( blocks[19].id() );
+      bdb.remove( blocks[18].id() );
+      b = blocks[19];
+      bdb.store( b.id(), b );
+      {
+         replay_pipeline pipeline( bdb, 15, 20, 2, 2 );
+         for( uint32_t num = 15; num < 19; ++num )
+            BOOST_CHECK( pipeline.next().block->block_num() == num );
+         BOOST_CHECK( !pipeline.next().block.valid() );
+         BOOST_CHECK( !pipeline.next().block.valid() );
+      }
+
+      // the consumer may stop early
+      {
+         replay_pipeline pipeline( bdb, 1, 18, 2, 2 );
+         BOOST_CHECK( pipeline.next().block->block_num() == 1 );
+      }
    } catch (fc::exception& e) {
       edump((e.to_detail_string()));
       throw;
@@ -148,6 +418,22 @@ BOOST_AUTO_TEST_CASE( generate_empty_blocks )
          database db;
          db.open(data_dir.path(), []{return genesis_state_type();});
          BOOST_CHECK_EQUAL( db.head_block_num(), cutoff_block.block_num() );
+
+         // the holders of an asset are rebuilt from the balances opened from disk
+         const auto& bidx = dynamic_cast<const primary_index<account_balance_index>&>( db.get_index_type<account_balance_index>() );
+         const auto& holders = bidx.get_secondary_index<account_holder_index>();
+         const auto& balances = db.get_index_type<account_balance_index>().indices().get<by_asset_balance>();
+         vector<account_id_type> expected;
+         for( auto itr = balances.lower_bound( boost::make_tuple( asset_id_type() ) );
+              itr != balances.end() && itr->asset_type == asset_id_type() && itr->balance > 0; ++itr )
+            expected.push_back( itr->owner );
+         std::sort( expected.begin(), expected.end() );
+         BOOST_CHECK( !expected.empty() );
+         BOOST_CHECK_EQUAL( holders.holder_count( asset_id_type() ), expected.size() );
+         BOOST_CHECK_EQUAL( holders.holder_count( asset_id_type(), fc::time_point_sec(), fc::time_point_sec::maximum() ),
+                            expected.size() );
+         BOOST_CHECK( holders.holders( asset_id_type(), account_id_type(), expected.size() + 1 ) == expected );
+
          b = cutoff_block;
          for( uint32_t i = 0; i < 200; ++i )
          {
@@ -165,6 +451,90 @@ BOOST_AUTO_TEST_CASE( generate_empty_blocks )
    }
 }
 
+BOOST_AUTO_TEST_CASE( object_database_snapshot )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      uint32_t snapshot_block_num = 0;
+      uint32_t head_block_num = 0;
+      block_id_type head_block_id;
+      {
+         database db;
+         db.open(data_dir.path(), make_genesis );
+         db.set_snapshot_interval( 20 );
+         while( db.get_dynamic_global_properties().last_irreversible_block_num < 50 )
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         db.wait_for_snapshot();
+         // the snapshot was taken at an irreversible block below the head
+         for( fc::directory_iterator itr( data_dir.path() / "snapshots" ), end; itr != end; ++itr )
+            snapshot_block_num = std::max<uint32_t>( snapshot_block_num, std::stoul( (*itr).filename().generic_string() ) );
+         BOOST_REQUIRE_GE( snapshot_block_num, 20u );
+         BOOST_CHECK_LT( snapshot_block_num, db.head_block_num() );
+         head_block_num = db.head_block_num();
+         head_block_id = db.head_block_id();
+         // not closing the database leaves it as after an unclean shutdown
+      }
+      {
+         database db;
+         db.reindex( data_dir.path(), make_genesis(), true );
+         BOOST_CHECK_EQUAL( db.head_block_num(), head_block_num );
+         BOOST_CHECK( db.head_block_id() == head_block_id );
+         // the object database has been linked to the snapshot instead of being built from genesis
+         BOOST_CHECK_EQUAL( boost::filesystem::hard_link_count( ( data_dir.path() / "snapshots"
+                                    / fc::to_string( snapshot_block_num ) / "1" / "2" ).string() ), 2u );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( object_database_snapshot_fallback )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      uint32_t snapshot_block_num = 0;
+      uint32_t head_block_num = 0;
+      block_id_type head_block_id;
+      {
+         database db;
+         db.open(data_dir.path(), make_genesis );
+         db.set_snapshot_interval( 20 );
+         while( db.get_dynamic_global_properties().last_irreversible_block_num < 30 )
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         db.wait_for_snapshot();
+         for( fc::directory_iterator itr( data_dir.path() / "snapshots" ), end; itr != end; ++itr )
+            snapshot_block_num = std::max<uint32_t>( snapshot_block_num, std::stoul( (*itr).filename().generic_string() ) );
+         BOOST_REQUIRE_GE( snapshot_block_num, 20u );
+         head_block_num = db.head_block_num();
+         head_block_id = db.head_block_id();
+      }
+
+      // an index file of another object version can not be opened
+      const fc::path account_file = data_dir.path() / "snapshots" / fc::to_string( snapshot_block_num ) / "1" / "2";
+      fc::remove( account_file );
+      {
+         fc::ofstream out( account_file );
+         fc::raw::pack( out, object_id_type( 1, 2, 0 ) );
+         fc::raw::pack( out, fc::sha256::hash( string( "0.9" ) ) );
+      }
+      {
+         database db;
+         db.reindex( data_dir.path(), make_genesis(), true );
+         // all blocks were replayed instead
+         BOOST_CHECK_EQUAL( db.head_block_num(), head_block_num );
+         BOOST_CHECK( db.head_block_id() == head_block_id );
+         BOOST_CHECK( db.find( account_id_type() ) != nullptr );
+         BOOST_CHECK_EQUAL( boost::filesystem::hard_link_count( account_file.string() ), 1u );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( undo_block )
 {
    try {
@@ -283,6 +653,142 @@ BOOST_AUTO_TEST_CASE( fork_blocks )
    }
 }
 
+BOOST_AUTO_TEST_CASE( checkpointed_blocks )
+{
+   try {
+      fc::temp_directory data_dir1( graphene::utilities::temp_directory_path() );
+      fc::temp_directory data_dir2( graphene::utilities::temp_directory_path() );
+
+      database db1;
+      db1.open(data_dir1.path(), make_genesis);
+      database db2;
+      db2.open(data_dir2.path(), make_genesis);
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      vector<signed_block> blocks;
+      for( uint32_t i = 0; i < 12; ++i )
+         blocks.push_back( db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing) );
+
+      // without a checkpoint the blocks are pushed the usual way
+      BOOST_CHECK( !db2.push_checkpointed_block( blocks[0] ) );
+
+      db2.add_checkpoints( { { 10, blocks[9].id() } } );
+      // a block which does not build on the head block is not taken either
+      BOOST_CHECK( !db2.push_checkpointed_block( blocks[1] ) );
+      for( uint32_t i = 0; i < 10; ++i )
+         BOOST_CHECK( db2.push_checkpointed_block( blocks[i] ) );
+      BOOST_CHECK_EQUAL( db2.head_block_num(), 10u );
+      BOOST_CHECK( db2.head_block_id() == blocks[9].id() );
+      BOOST_CHECK( db2.fetch_block_by_number( 5 )->id() == blocks[4].id() );
+
+      // past the last checkpoint the fork database goes on from the head block
+      BOOST_CHECK( !db2.push_checkpointed_block( blocks[10] ) );
+      PUSH_BLOCK( db2, blocks[10] );
+      PUSH_BLOCK( db2, blocks[11] );
+      BOOST_CHECK( db2.head_block_id() == db1.head_block_id() );
+
+      // the blocks below the checkpoint have no undo history
+      db2.pop_block();
+      db2.pop_block();
+      BOOST_CHECK_THROW( db2.pop_block(), fc::exception );
+      BOOST_CHECK( db2.head_block_id() == blocks[9].id() );
+
+      // a block which fails undoes the run, the blocks before it can still be popped
+      fc::temp_directory data_dir3( graphene::utilities::temp_directory_path() );
+      database db3;
+      db3.open(data_dir3.path(), make_genesis);
+      PUSH_BLOCK( db3, blocks[0] );
+      PUSH_BLOCK( db3, blocks[1] );
+      db3.add_checkpoints( { { 10, blocks[9].id() } } );
+      for( uint32_t i = 2; i < 5; ++i )
+         BOOST_CHECK( db3.push_checkpointed_block( blocks[i] ) );
+      signed_block forged = blocks[5];
+      forged.transactions.emplace_back();
+      BOOST_CHECK( forged.id() == blocks[5].id() );
+      BOOST_CHECK_THROW( db3.push_checkpointed_block( forged ), fc::exception );
+      BOOST_CHECK( db3.head_block_id() == blocks[1].id() );
+      BOOST_CHECK( !db3.fetch_block_by_number( 3 ).valid() );
+      db3.pop_block();
+      BOOST_CHECK( db3.head_block_id() == blocks[0].id() );
+      PUSH_BLOCK( db3, blocks[1] );
+      for( uint32_t i = 2; i < 10; ++i )
+         BOOST_CHECK( db3.push_checkpointed_block( blocks[i] ) );
+      BOOST_CHECK( db3.head_block_id() == blocks[9].id() );
+
+      // blocks which do not lead to the checkpoint id are undone back to the checkpoint before them
+      fc::temp_directory data_dir4( graphene::utilities::temp_directory_path() );
+      database db4;
+      db4.open(data_dir4.path(), make_genesis);
+      db4.add_checkpoints( { { 3, blocks[2].id() }, { 10, blocks[8].id() } } );
+      for( uint32_t i = 0; i < 9; ++i )
+         BOOST_CHECK( db4.push_checkpointed_block( blocks[i] ) );
+      BOOST_CHECK_THROW( db4.push_checkpointed_block( blocks[9] ), fc::exception );
+      BOOST_CHECK( db4.head_block_id() == blocks[2].id() );
+      BOOST_CHECK( !db4.fetch_block_by_number( 4 ).valid() );
+
+      db4.add_checkpoints( { { 10, blocks[9].id() } } );
+      for( uint32_t i = 3; i < 6; ++i )
+         BOOST_CHECK( db4.push_checkpointed_block( blocks[i] ) );
+
+      // a block which does not build on the head block, a transaction or a pop are rejected in the middle of a run,
+      // which goes on
+      BOOST_CHECK( db4.in_checkpointed_batch() );
+      BOOST_CHECK_THROW( PUSH_BLOCK( db4, blocks[7] ), unlinkable_block_exception );
+      signed_transaction trx;
+      set_expiration( db4, trx );
+      BOOST_CHECK_THROW( db4.push_transaction( trx, ~0 ), fc::exception );
+      BOOST_CHECK_THROW( db4.validate_transaction( trx ), fc::exception );
+      BOOST_CHECK_THROW( db4.pop_block(), fc::exception );
+      BOOST_CHECK( db4.head_block_id() == blocks[5].id() );
+      BOOST_CHECK( db4.fetch_block_by_number( 6 )->id() == blocks[5].id() );
+
+      // a block which builds on the head block joins the run
+      PUSH_BLOCK( db4, blocks[6] );
+      BOOST_CHECK( db4.in_checkpointed_batch() );
+      for( uint32_t i = 7; i < 10; ++i )
+         BOOST_CHECK( db4.push_checkpointed_block( blocks[i] ) );
+      BOOST_CHECK( !db4.in_checkpointed_batch() );
+      PUSH_BLOCK( db4, blocks[10] );
+      PUSH_BLOCK( db4, blocks[11] );
+      BOOST_CHECK( db4.head_block_id() == db1.head_block_id() );
+
+      // a run is undone for a block which competes with it, a block which the run holds already leaves it alone
+      fc::temp_directory data_dir5( graphene::utilities::temp_directory_path() );
+      database db5;
+      db5.open(data_dir5.path(), make_genesis);
+      PUSH_BLOCK( db5, blocks[0] );
+      PUSH_BLOCK( db5, blocks[1] );
+      const signed_block competing = db5.generate_block( db5.get_slot_time(2), db5.get_scheduled_witness(2),
+                                                         init_account_priv_key, database::skip_nothing );
+      BOOST_CHECK( competing.previous == blocks[1].id() );
+      db5.pop_block();
+      db5.add_checkpoints( { { 10, blocks[9].id() } } );
+      for( uint32_t i = 2; i < 6; ++i )
+         BOOST_CHECK( db5.push_checkpointed_block( blocks[i] ) );
+      PUSH_BLOCK( db5, blocks[3] );
+      BOOST_CHECK( db5.in_checkpointed_batch() );
+      BOOST_CHECK( db5.head_block_id() == blocks[5].id() );
+      PUSH_BLOCK( db5, competing );
+      BOOST_CHECK( !db5.in_checkpointed_batch() );
+      BOOST_CHECK( db5.head_block_id() == competing.id() );
+      BOOST_CHECK( !db5.fetch_block_by_number( 4 ).valid() );
+      db5.pop_block();
+      BOOST_CHECK( db5.head_block_id() == blocks[1].id() );
+
+      // blocks too far below the next checkpoint are pushed the usual way
+      fc::temp_directory data_dir6( graphene::utilities::temp_directory_path() );
+      database db6;
+      db6.open(data_dir6.path(), make_genesis);
+      db6.add_checkpoints( { { GRAPHENE_CHECKPOINTED_BATCH_SIZE + 1, blocks[9].id() } } );
+      BOOST_CHECK( !db6.push_checkpointed_block( blocks[0] ) );
+      PUSH_BLOCK( db6, blocks[0] );
+      BOOST_CHECK( db6.push_checkpointed_block( blocks[1] ) );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 
 /**
  *  These test has been disabled, out of order blocks should result in the node getting disconnected.
@@ -549,6 +1055,127 @@ BOOST_AUTO_TEST_CASE( duplicate_transactions )
    }
 }
 
+BOOST_AUTO_TEST_CASE( deferred_pending_transactions )
+{
+   try {
+      fc::temp_directory dir1( graphene::utilities::temp_directory_path() ),
+                         dir2( graphene::utilities::temp_directory_path() );
+      database db1,
+               db2;
+      db1.open(dir1.path(), make_genesis);
+      db2.open(dir2.path(), make_genesis);
+      db2.defer_pending_transactions( true );
+
+      auto skip_sigs = database::skip_transaction_signatures | database::skip_authority_check;
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      const auto& accounts_by_name = db2.get_index_type<account_index>().indices().get<by_name>();
+
+      signed_transaction trx;
+      set_expiration( db2, trx );
+      account_create_operation cop;
+      cop.name = "nathan";
+      cop.owner = authority(1, public_key_type(init_account_priv_key.get_public_key()), 1);
+      cop.active = cop.owner;
+      trx.operations.push_back(cop);
+      trx.sign( init_account_priv_key, db2.get_chain_id() );
+      PUSH_TX( db2, trx, skip_sigs );
+      BOOST_CHECK( accounts_by_name.find( "nathan" ) != accounts_by_name.end() );
+
+      const auto& pending = db2.get_pending_transactions();
+      BOOST_REQUIRE_EQUAL( pending.size(), 1u );
+      BOOST_CHECK( pending.contains( trx.id() ) );
+      BOOST_CHECK_EQUAL( pending.begin()->packed_size, fc::raw::pack_size( pending.begin()->trx ) );
+
+      // the block leaves the pending transaction to be applied later
+      auto b = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, skip_sigs );
+      PUSH_BLOCK( db2, b, skip_sigs );
+      BOOST_CHECK( accounts_by_name.find( "nathan" ) == accounts_by_name.end() );
+      BOOST_CHECK_EQUAL( db2.get_pending_transactions().size(), 1u );
+
+      // a task the push posted applies it once this thread yields
+      fc::usleep( fc::milliseconds( 10 ) );
+      BOOST_CHECK( accounts_by_name.find( "nathan" ) != accounts_by_name.end() );
+      BOOST_CHECK_EQUAL( db2.get_pending_transactions().size(), 1u );
+      GRAPHENE_CHECK_THROW( PUSH_TX( db2, trx, skip_sigs ), fc::exception );
+      GRAPHENE_CHECK_THROW( PUSH_TX( db2, trx, skip_sigs ), fc::exception );
+
+      // a pushed transaction applies the pending ones first
+      PUSH_BLOCK( db2, db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, skip_sigs ), skip_sigs );
+      BOOST_CHECK( accounts_by_name.find( "nathan" ) == accounts_by_name.end() );
+      GRAPHENE_CHECK_THROW( PUSH_TX( db2, trx, skip_sigs ), fc::exception );
+      BOOST_CHECK( accounts_by_name.find( "nathan" ) != accounts_by_name.end() );
+
+      // a block the node generates itself posts the task as well, which drops the transaction the block includes
+      const signed_block produced = db2.generate_block( db2.get_slot_time(1), db2.get_scheduled_witness( 1 ),
+                                                        init_account_priv_key, skip_sigs );
+      BOOST_CHECK_EQUAL( produced.transactions.size(), 1u );
+      BOOST_CHECK_EQUAL( db2.get_pending_transactions().size(), 1u );
+      fc::usleep( fc::milliseconds( 10 ) );
+      BOOST_CHECK( db2.get_pending_transactions().empty() );
+      BOOST_CHECK( accounts_by_name.find( "nathan" ) != accounts_by_name.end() );
+
+      // the task checks the pending transactions with the skip flags of the block push, which keep an unsigned one
+      signed_transaction unsigned_trx;
+      set_expiration( db2, unsigned_trx );
+      cop.name = "alice";
+      unsigned_trx.operations.push_back(cop);
+      PUSH_TX( db2, unsigned_trx, skip_sigs );
+      PUSH_BLOCK( db1, produced, skip_sigs );
+      PUSH_BLOCK( db2, db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, skip_sigs ), skip_sigs );
+      BOOST_CHECK( accounts_by_name.find( "alice" ) == accounts_by_name.end() );
+      fc::usleep( fc::milliseconds( 10 ) );
+      BOOST_CHECK( accounts_by_name.find( "alice" ) != accounts_by_name.end() );
+      BOOST_CHECK( db2.get_pending_transactions().contains( unsigned_trx.id() ) );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_production_deadline )
+{
+   try {
+      fc::temp_directory dir1( graphene::utilities::temp_directory_path() );
+      database db1;
+      db1.open(dir1.path(), make_genesis);
+
+      auto skip_sigs = database::skip_transaction_signatures | database::skip_authority_check;
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+
+      signed_transaction trx;
+      set_expiration( db1, trx );
+      account_create_operation cop;
+      cop.name = "nathan";
+      cop.owner = authority(1, public_key_type(init_account_priv_key.get_public_key()), 1);
+      cop.active = cop.owner;
+      trx.operations.push_back(cop);
+      trx.sign( init_account_priv_key, db1.get_chain_id() );
+      PUSH_TX( db1, trx, skip_sigs );
+
+      // a passed deadline leaves the transaction pending
+      auto b = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key,
+                                   skip_sigs, fc::time_point::now() );
+      BOOST_CHECK( b.transactions.empty() );
+      BOOST_CHECK( b.transaction_merkle_root == checksum_type() );
+      BOOST_CHECK( db1.get_last_block_production().deadline_reached );
+      BOOST_CHECK_EQUAL( db1.get_last_block_production().not_tried, 1u );
+      BOOST_CHECK_EQUAL( db1.get_pending_transactions().size(), 1u );
+
+      b = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, skip_sigs );
+      BOOST_REQUIRE_EQUAL( b.transactions.size(), 1u );
+      BOOST_CHECK( b.transaction_merkle_root == b.calculate_merkle_root() );
+      const block_production_stats& stats = db1.get_last_block_production();
+      BOOST_CHECK( !stats.deadline_reached );
+      BOOST_CHECK_EQUAL( stats.block_num, b.block_num() );
+      BOOST_CHECK_EQUAL( stats.transactions, 1u );
+      BOOST_CHECK_GE( stats.block_size, fc::raw::pack_size( b.transactions.front() ) );
+      BOOST_CHECK_EQUAL( db1.get_pending_transactions().size(), 0u );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( tapos )
 {
    try {
@@ -1290,4 +1917,94 @@ BOOST_FIXTURE_TEST_CASE( miss_many_blocks, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( parallel_vote_tally, database_fixture )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "=== parallel_vote_tally, database_fixture ===" );
+
+      ACTOR(zed);
+      transfer(committee_account, zed_id, asset(100000000));
+      upgrade_to_lifetime_member(zed_id);
+      // amy is tallied before zed, so her fees change zed's cashback before zed is tallied
+      account_id_type amy_id = create_account("amy", zed_id(db), zed_id(db), 100).id;
+      transfer(committee_account, amy_id, asset(100000000));
+      generate_block();
+
+      enable_fees();
+      for( int i = 0; i < 5; ++i )
+         transfer(amy_id, zed_id, asset(1000));
+      generate_block();
+
+      auto cashback = [&]() -> share_type {
+         const account_object& zed = zed_id(db);
+         return zed.cashback_vb.valid() ? (*zed.cashback_vb)(db).balance.amount : share_type(0);
+      };
+      auto tally_snapshot = [&]() {
+         vector<uint64_t> result;
+         for( const committee_member_object& cm : db.get_index_type<committee_member_index>().indices() )
+            result.push_back(cm.total_votes);
+         for( const witness_object& w : db.get_index_type<witness_index>().indices() )
+            result.push_back(w.total_votes);
+         const auto& gpo = db.get_global_properties();
+         for( committee_member_id_type id : gpo.active_committee_members )
+            result.push_back(id.instance.value);
+         for( witness_id_type id : gpo.active_witnesses )
+            result.push_back(id.instance.value);
+         return result;
+      };
+
+      const share_type cashback_before = cashback();
+      db.set_maintenance_tally_threads(0);
+      generate_blocks(db.get_dynamic_global_properties().next_maintenance_time);
+      BOOST_CHECK_GT(cashback().value, cashback_before.value);
+      const auto serial = tally_snapshot();
+      const signed_block maintenance_block = *db.fetch_block_by_number(db.head_block_num());
+
+      db.pop_block();
+      BOOST_CHECK_EQUAL(cashback().value, cashback_before.value);
+      db.set_maintenance_tally_threads(4);
+      PUSH_BLOCK(db, maintenance_block, database::skip_witness_signature);
+      BOOST_CHECK(tally_snapshot() == serial);
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( maintenance_profiler_test, database_fixture )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "=== maintenance_profiler_test, database_fixture ===" );
+
+      db.set_maintenance_profile_size(2);
+      const auto& profiles = db.get_maintenance_profiler().profiles();
+      for( int i = 0; i < 3; ++i )
+      {
+         generate_blocks(db.get_dynamic_global_properties().next_maintenance_time);
+         BOOST_REQUIRE(!profiles.empty());
+         BOOST_CHECK_EQUAL(profiles.back().block_num, db.head_block_num());
+      }
+      BOOST_CHECK_EQUAL(profiles.size(), 2u);
+
+      const maintenance_profile& last = profiles.back();
+      auto phase = std::find_if(last.phases.begin(), last.phases.end(),
+                                [](const maintenance_phase_profile& p) { return p.name == "update_votes"; });
+      BOOST_REQUIRE(phase != last.phases.end());
+      BOOST_CHECK_GT(phase->objects_touched, 0u);
+      BOOST_CHECK_GE(last.objects_touched, phase->objects_touched);
+
+      const fc::variant dump = fc::json::from_string(fc::json::to_string(profiles));
+      BOOST_CHECK_EQUAL(dump.get_array().size(), 2u);
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
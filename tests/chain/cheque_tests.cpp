@@ -266,4 +266,68 @@ BOOST_AUTO_TEST_CASE(cheque_fee_test)
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(process_due_cheques_test)
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "=== process_due_cheques_test ===" );
+
+      ACTOR(abcde1); // for needed IDs
+      ACTOR(abcde2);
+      ACTOR(alice);
+      ACTOR(dan);
+      // assign privileges for creating_asset_operation
+      SET_ACTOR_CAN_CREATE_ASSET(alice_id);
+
+      create_edc();
+
+      issue_uia(alice_id, asset(10000, EDC_ASSET));
+
+      fc::time_point_sec h_time = HARDFORK_622_TIME;
+      generate_blocks(h_time);
+
+      // used and undone cheques expired 5 days ago are removed
+      db.set_history_size(5);
+
+      const fc::time_point_sec start_time = db.head_block_time();
+      std::string soon_code = "sooncode11111111";
+      std::string later_code = "latercode1111111";
+      std::string used_code = "usedcode11111111";
+      make_cheque(soon_code, start_time + fc::days(2), EDC_ASSET, 1000, 1, alice_id);
+      make_cheque(later_code, start_time + fc::days(10), EDC_ASSET, 1000, 1, alice_id);
+      make_cheque(used_code, start_time + fc::days(2), EDC_ASSET, 1000, 1, alice_id);
+      use_cheque(used_code, dan_id);
+      BOOST_CHECK(get_balance(alice_id, EDC_ASSET) == 7000);
+      BOOST_CHECK(get_balance(dan_id, EDC_ASSET) == 1000);
+
+      const auto& idx_cheques = db.get_index_type<cheque_index>().indices().get<by_code>();
+      auto run_maintenances_until = [&](fc::time_point_sec t) {
+         while (db.head_block_time() < t) {
+            generate_blocks(db.get_dynamic_global_properties().next_maintenance_time);
+         }
+      };
+
+      // the overdue cheque is reversed, the other new cheque is not due yet
+      run_maintenances_until(start_time + fc::days(4));
+      BOOST_CHECK_EQUAL(idx_cheques.find(soon_code)->status, cheque_undo);
+      BOOST_CHECK_EQUAL(idx_cheques.find(later_code)->status, cheque_new);
+      BOOST_CHECK_EQUAL(idx_cheques.find(used_code)->status, cheque_used);
+      BOOST_CHECK(get_balance(alice_id, EDC_ASSET) == 8000);
+
+      // the used and undone cheques past the history are removed, the new one is kept
+      run_maintenances_until(start_time + fc::days(9));
+      BOOST_CHECK(idx_cheques.find(soon_code) == idx_cheques.end());
+      BOOST_CHECK(idx_cheques.find(used_code) == idx_cheques.end());
+      BOOST_REQUIRE(idx_cheques.find(later_code) != idx_cheques.end());
+      BOOST_CHECK_EQUAL(idx_cheques.find(later_code)->status, cheque_new);
+      BOOST_CHECK(get_balance(alice_id, EDC_ASSET) == 8000);
+
+      // and reversed once it is overdue
+      run_maintenances_until(start_time + fc::days(12));
+      BOOST_CHECK_EQUAL(idx_cheques.find(later_code)->status, cheque_undo);
+      BOOST_CHECK(get_balance(alice_id, EDC_ASSET) == 9000);
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -7,6 +7,11 @@
 #include <graphene/chain/account_object.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <shared_mutex>
+#include <thread>
 
 #include "../common/database_fixture.hpp"
 
@@ -40,3 +45,121 @@ BOOST_AUTO_TEST_CASE( undo_test )
       throw;
    }
 }
+
+BOOST_AUTO_TEST_CASE( undo_deltas_test )
+{
+   try {
+      database db;
+      auto ses1 = db._undo_db.start_undo_session();
+      const auto& balance = db.create<account_mature_balance_object>( [&]( account_mature_balance_object& obj ){
+         for( int i = 0; i < 1000; ++i )
+            obj.history.emplace_back( i, i );
+      });
+      ses1.commit();
+      const auto original = balance.history;
+
+      auto ses2 = db._undo_db.start_undo_session();
+      db.modify( balance, [&]( account_mature_balance_object& obj ){ obj.history.emplace_back( 1000, 1000 ); } );
+      BOOST_CHECK( db._undo_db.head().old_values.empty() );
+      BOOST_REQUIRE_EQUAL( db._undo_db.head().old_deltas.size(), 1u );
+      {
+         // once a newer state changes the object, the older one keeps only the bytes that differ
+         auto ses3 = db._undo_db.start_undo_session();
+         const packed_delta& delta = db._undo_db.at_depth( 1 ).old_deltas.at( balance.id );
+         BOOST_CHECK( !delta.relative );
+         db.modify( balance, [&]( account_mature_balance_object& obj ){ obj.history.emplace_back( 2000, 2000 ); } );
+         BOOST_CHECK( delta.relative );
+         BOOST_CHECK_LT( delta.bytes.size(), 32u );
+         db.modify( balance, [&]( account_mature_balance_object& obj ){
+            obj.balance = 5;
+            obj.history.erase( obj.history.begin() );
+         });
+         ses3.undo();
+      }
+      BOOST_CHECK_EQUAL( balance.history.size(), 1001u );
+      BOOST_CHECK_EQUAL( balance.balance.value, 0 );
+
+      // the older state is the head again and the object changes once more
+      db.modify( balance, [&]( account_mature_balance_object& obj ){ obj.history.emplace_back( 1001, 1001 ); } );
+      {
+         auto ses4 = db._undo_db.start_undo_session();
+         db.modify( balance, [&]( account_mature_balance_object& obj ){ obj.history.erase( obj.history.begin() ); } );
+         ses4.merge();
+      }
+      BOOST_CHECK_EQUAL( balance.history.size(), 1001u );
+
+      // the deltas of an object left unchanged by the state above become relative when one more state starts
+      {
+         auto ses5 = db._undo_db.start_undo_session();
+         BOOST_CHECK( !db._undo_db.at_depth( 1 ).old_deltas.at( balance.id ).relative );
+         auto ses6 = db._undo_db.start_undo_session();
+         BOOST_CHECK( db._undo_db.at_depth( 2 ).old_deltas.at( balance.id ).relative );
+      }
+      BOOST_CHECK_EQUAL( balance.history.size(), 1001u );
+
+      ses2.undo();
+      BOOST_REQUIRE_EQUAL( balance.history.size(), original.size() );
+      for( size_t i = 0; i < original.size(); ++i )
+         BOOST_CHECK_EQUAL( balance.history[i].balance.value, original[i].balance.value );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( read_write_gate_test )
+{
+   read_write_gate gate;
+
+   // readers share the gate, a writer can not take it meanwhile
+   gate.lock_shared();
+   gate.lock_shared();
+   BOOST_CHECK( !gate.try_lock() );
+   gate.unlock_shared();
+   gate.unlock_shared();
+
+   // the writer may take the gate again, readers on other threads wait until it is released
+   gate.lock();
+   BOOST_CHECK( gate.try_lock() );
+   std::atomic<bool> read( false );
+   std::thread reader( [&]() {
+      std::shared_lock<read_write_gate> shared( gate );
+      read = true;
+   });
+   gate.unlock();
+   std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+   BOOST_CHECK( !read );
+   gate.unlock();
+   reader.join();
+   BOOST_CHECK( read );
+
+   // a writer on another thread is not taken in while it is read
+   gate.lock_shared();
+   std::thread other( [&]() { BOOST_CHECK( !gate.try_lock() ); } );
+   other.join();
+   gate.unlock_shared();
+
+   // the tasks of a thread share its id, a task waits for another one holding the gate by yielding to it
+   std::vector<std::string> events;
+   fc::thread worker( "gate test" );
+   worker.async( [&]() {
+      gate.lock();
+      fc::future<void> task = fc::async( [&]() {
+         if( gate.try_lock() )
+         {
+            events.push_back( "taken again" );
+            gate.unlock();
+         }
+         else
+            events.push_back( "busy" );
+         std::lock_guard<read_write_gate> exclusive( gate );
+         events.push_back( "second" );
+      });
+      fc::usleep( fc::milliseconds( 20 ) );
+      events.push_back( "first" );
+      gate.unlock();
+      task.wait();
+   }).wait();
+   BOOST_CHECK( events == std::vector<std::string>({ "busy", "first", "second" }) );
+}
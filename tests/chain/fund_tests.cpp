@@ -1008,4 +1008,114 @@ BOOST_AUTO_TEST_CASE( funds_payments_limit_test )
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( fund_due_deposits_test )
+{
+   try
+   {
+      /**
+       * maintenance visits only the unfinished deposits of enabled funds, and removes only the deposits
+       * finished more than 30 days ago
+       */
+      BOOST_TEST_MESSAGE( "=== fund_due_deposits_test ===" );
+
+      ACTOR(abcde1) // for needed IDs
+      ACTOR(alice)
+      ACTOR(bob)
+
+      SET_ACTOR_CAN_CREATE_ASSET(alice_id)
+
+      create_edc();
+
+      issue_uia(bob_id, asset(3000000, EDC_ASSET));
+
+      generate_blocks(HARDFORK_640_TIME);
+
+      // deposits are returned at their end instead of being renewed
+      {
+         enable_autorenewal_deposits_operation op;
+         op.account_id = bob_id;
+         op.enabled = false;
+         set_expiration(db, trx);
+         trx.operations.push_back(std::move(op));
+         PUSH_TX(db, trx, ~0);
+         trx.clear();
+      }
+
+      auto make_test_fund = [&](const string& name, uint32_t period) -> const fund_object& {
+         fund_options::fund_rate fr;
+         fr.amount = 1000000;
+         fr.day_percent = 1000;
+         fund_options::payment_rate pr1;
+         pr1.period = 1;
+         pr1.percent = 1000;
+         fund_options::payment_rate pr30;
+         pr30.period = 30;
+         pr30.percent = 1000;
+
+         fund_options options;
+         options.description = "FUND DESCRIPTION";
+         options.period = period; // fund lifetime, days
+         options.min_deposit = 1000000;
+         options.rates_reduction_per_month = 0;
+         options.fund_rates.push_back(std::move(fr));
+         options.payment_rates.push_back(std::move(pr1));
+         options.payment_rates.push_back(std::move(pr30));
+         make_fund(name, options, alice_id);
+         return *db.get_index_type<fund_index>().indices().get<by_name>().find(name);
+      };
+      const fund_object& fund = make_test_fund("TESTFUND", 100);
+      const fund_object& short_fund = make_test_fund("SHORTFUND", 2);
+
+      auto make_deposit = [&](const fund_object& f, uint32_t period) -> fund_deposit_id_type {
+         fund_deposit_id_type id = db.get_index_type<fund_deposit_index>().get_next_id();
+         fund_deposit_operation op;
+         op.amount = 1000000;
+         op.from_account = bob_id;
+         op.period = period;
+         op.fund_id = f.id;
+         set_expiration(db, trx);
+         trx.operations.push_back(std::move(op));
+         PUSH_TX(db, trx, ~0);
+         trx.clear();
+         return id;
+      };
+      const fund_deposit_id_type short_dep = make_deposit(fund, 1);
+      const fund_deposit_id_type long_dep = make_deposit(fund, 30);
+      // a deposit outliving its fund
+      const fund_deposit_id_type orphan_dep = make_deposit(short_fund, 30);
+      const auto& idx_deposits = db.get_index_type<fund_deposit_index>().indices().get<by_id>();
+
+      auto next_maintenance = [&]() {
+         generate_blocks(db.get_dynamic_global_properties().next_maintenance_time);
+      };
+
+      for (int i = 0; i < 3; ++i) {
+         next_maintenance();
+      }
+
+      // the due deposit has been returned, the other is not due yet
+      BOOST_CHECK(short_dep(db).finished);
+      BOOST_CHECK(!short_dep(db).enabled);
+      BOOST_CHECK(!long_dep(db).finished);
+      BOOST_CHECK(long_dep(db).enabled);
+      BOOST_CHECK(!short_fund.enabled);
+
+      while (!long_dep(db).finished) {
+         BOOST_REQUIRE(db.head_block_time() < long_dep(db).datetime_end + fc::days(3));
+         next_maintenance();
+      }
+      next_maintenance();
+
+      // the deposit finished more than 30 days ago has been removed
+      BOOST_CHECK(idx_deposits.find(short_dep) == idx_deposits.end());
+      BOOST_CHECK(idx_deposits.find(long_dep) != idx_deposits.end());
+
+      // the fund of this deposit has finished and is not processed any more
+      BOOST_CHECK(db.head_block_time() > orphan_dep(db).datetime_end);
+      BOOST_CHECK(!orphan_dep(db).finished);
+      BOOST_CHECK(orphan_dep(db).enabled);
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -14,6 +14,8 @@
 #include <graphene/chain/withdraw_permission_object.hpp>
 #include <graphene/chain/witness_object.hpp>
 
+#include <graphene/app/api.hpp>
+
 #include <fc/crypto/digest.hpp>
 
 #include "../common/database_fixture.hpp"
@@ -1927,6 +1929,54 @@ BOOST_AUTO_TEST_CASE( vesting_balance_withdraw_test )
 //   }
 //}
 
+BOOST_AUTO_TEST_CASE( account_operation_history_by_type )
+{
+   try {
+      ACTORS((alice)(bob));
+      transfer(committee_account, alice_id, asset(1000000));
+      transfer(alice_id, bob_id, asset(1000));
+      transfer(bob_id, alice_id, asset(500));
+      transfer(alice_id, bob_id, asset(200));
+      generate_block();
+
+      graphene::app::history_api hist_api(app);
+      const uint16_t transfer_type = operation::tag<transfer_operation>::value;
+      const uint16_t account_create_type = operation::tag<account_create_operation>::value;
+
+      // the most recent first
+      auto history = hist_api.get_account_operation_history(alice_id, transfer_type, 100);
+      BOOST_REQUIRE_EQUAL(history.size(), 4u);
+      BOOST_CHECK_EQUAL(history[0].op.get<transfer_operation>().amount.amount.value, 200);
+      BOOST_CHECK_EQUAL(history[3].op.get<transfer_operation>().amount.amount.value, 1000000);
+
+      history = hist_api.get_account_operation_history3(alice_id, operation_history_id_type(), 100,
+                                                        operation_history_id_type(), {transfer_type, account_create_type});
+      BOOST_REQUIRE_EQUAL(history.size(), 5u);
+      BOOST_CHECK_EQUAL(history[0].op.get<transfer_operation>().amount.amount.value, 200);
+      BOOST_CHECK(history[4].op.which() == account_create_type);
+
+      // the oldest first
+      const auto oldest_first = hist_api.get_account_operation_history4(alice_id, operation_history_id_type(), 100, {transfer_type});
+      BOOST_REQUIRE_EQUAL(oldest_first.size(), 4u);
+      BOOST_CHECK_EQUAL(oldest_first[0].op.get<transfer_operation>().amount.amount.value, 1000000);
+      history = hist_api.get_account_operation_history4(alice_id, oldest_first[1].id, 100, {transfer_type});
+      BOOST_REQUIRE_EQUAL(history.size(), 3u);
+      BOOST_CHECK_EQUAL(history[0].op.get<transfer_operation>().amount.amount.value, 1000);
+
+      // operations in (stop, start]
+      history = hist_api.get_account_operation_history2(alice_id, oldest_first[0].id, 100, oldest_first[2].id, transfer_type);
+      BOOST_REQUIRE_EQUAL(history.size(), 2u);
+      BOOST_CHECK_EQUAL(history[0].op.get<transfer_operation>().amount.amount.value, 500);
+      BOOST_CHECK_EQUAL(history[1].op.get<transfer_operation>().amount.amount.value, 1000);
+
+      BOOST_CHECK_EQUAL(hist_api.listtransactions(bob_id, {}, 100).size(), 3u);
+      BOOST_CHECK_EQUAL(hist_api.listtransactions(bob_id, {}, 1).size(), 1u);
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
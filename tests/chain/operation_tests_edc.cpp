@@ -1,5 +1,7 @@
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/database_api.hpp>
+
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/hardfork.hpp>
@@ -12,6 +14,9 @@
 #include <graphene/chain/witness_object.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
+#include <fc/rpc/api_connection.hpp>
+#include <fc/thread/thread.hpp>
 
 #include "../common/database_fixture.hpp"
 #include "../common/test_utils.hpp"
@@ -581,4 +586,164 @@ BOOST_AUTO_TEST_CASE(witness_fee_payments_test)
    }
 }
 
+BOOST_AUTO_TEST_CASE(holder_count_test)
+{
+   BOOST_TEST_MESSAGE( "=== holder_count_test ===" );
+
+   try {
+
+      ACTOR(abcde1); // for needed IDs
+      ACTOR(alice);
+      create_edc();
+      generate_block();
+      ACTOR(bob);
+      generate_block();
+
+      const auto& bidx = dynamic_cast<const primary_index<account_balance_index>&>(db.get_index_type<account_balance_index>());
+      const auto& holders = bidx.get_secondary_index<account_holder_index>();
+      const fc::time_point_sec alice_registered = alice_id(db).register_datetime;
+      const fc::time_point_sec bob_registered = bob_id(db).register_datetime;
+      BOOST_REQUIRE( alice_registered < bob_registered );
+      const uint64_t initial_count = holders.holder_count(EDC_ASSET);
+
+      issue_uia(alice_id, asset(30000, EDC_ASSET));
+      issue_uia(bob_id, asset(10000, EDC_ASSET));
+      BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET), initial_count + 2 );
+      BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET, alice_registered, bob_registered), 2u );
+      BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET, alice_registered, bob_registered - 1), 1u );
+      BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET, bob_registered, bob_registered), 1u );
+      BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET, bob_registered + 1, fc::time_point_sec::maximum()), 0u );
+
+      // bob holds no EDC once he has sent it all
+      transfer(bob_id, alice_id, asset(10000, EDC_ASSET));
+      BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET), initial_count + 1 );
+      BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET, bob_registered, bob_registered), 0u );
+
+      // the counts follow the undo of the balances
+      {
+         auto session = db._undo_db.start_undo_session();
+         issue_uia(bob_id, asset(10000, EDC_ASSET));
+         BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET), initial_count + 2 );
+      }
+      BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET), initial_count + 1 );
+      BOOST_CHECK_EQUAL( holders.holder_count(EDC_ASSET, alice_registered, bob_registered), 1u );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(asset_holders_test)
+{
+   BOOST_TEST_MESSAGE( "=== asset_holders_test ===" );
+
+   try {
+
+      ACTOR(abcde1); // for needed IDs
+      ACTORS((alice)(bob)(carol)(dan));
+      create_edc();
+
+      issue_uia(alice_id, asset(100, EDC_ASSET));
+      issue_uia(bob_id, asset(300, EDC_ASSET));
+      issue_uia(carol_id, asset(200, EDC_ASSET));
+      issue_uia(dan_id, asset(200, EDC_ASSET));
+      transfer(dan_id, alice_id, asset(200, EDC_ASSET));
+      // dan has an empty balance now
+      BOOST_REQUIRE_EQUAL( get_balance(dan_id, EDC_ASSET), 0 );
+
+      graphene::app::database_api db_api(db);
+
+      auto page = db_api.get_asset_holders(EDC_ASSET, account_id_type(), 2);
+      BOOST_REQUIRE_EQUAL( page.size(), 2u );
+      BOOST_CHECK( page[0].owner == alice_id && page[0].balance == 300 );
+      BOOST_CHECK( page[1].owner == bob_id && page[1].balance == 300 );
+      page = db_api.get_asset_holders(EDC_ASSET, account_id_type(page[1].owner.instance.value + 1), 2);
+      BOOST_REQUIRE_EQUAL( page.size(), 1u );
+      BOOST_CHECK( page[0].owner == carol_id && page[0].balance == 200 );
+
+      page = db_api.get_asset_holders_by_balance(EDC_ASSET, GRAPHENE_MAX_SHARE_SUPPLY, account_id_type(), 2);
+      BOOST_REQUIRE_EQUAL( page.size(), 2u );
+      BOOST_CHECK( page[0].owner == alice_id && page[1].owner == bob_id );
+      page = db_api.get_asset_holders_by_balance(EDC_ASSET, page[1].balance,
+                                                 account_id_type(page[1].owner.instance.value + 1), 2);
+      BOOST_REQUIRE_EQUAL( page.size(), 1u );
+      BOOST_CHECK( page[0].owner == carol_id );
+
+      GRAPHENE_CHECK_THROW( db_api.get_asset_holders(EDC_ASSET, account_id_type(), 101), fc::exception );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+namespace {
+   /// records the notices which subscriptions of a remote client would send
+   class notice_recorder : public fc::api_connection
+   {
+      public:
+         notice_recorder() : fc::api_connection( GRAPHENE_NET_MAX_NESTED_OBJECTS ) {}
+
+         virtual fc::variant send_call( fc::api_id_type, string, fc::variants )override { FC_THROW( "not a client" ); }
+         virtual fc::variant send_callback( uint64_t, fc::variants )override { FC_THROW( "not a client" ); }
+         virtual void send_notice( uint64_t, fc::variants args )override { notices.push_back( fc::json::to_string( args ) ); }
+         virtual void send_notice_json( uint64_t, const std::string& args_json )override { notices.push_back( args_json ); }
+
+         vector<string> notices;
+   };
+}
+
+BOOST_AUTO_TEST_CASE(object_change_subscriptions_test)
+{
+   BOOST_TEST_MESSAGE( "=== object_change_subscriptions_test ===" );
+
+   try {
+
+      ACTOR(abcde1); // for needed IDs
+      ACTORS((alice)(bob));
+      generate_block();
+
+      graphene::app::database_api db_api1(db);
+      graphene::app::database_api db_api2(db);
+      vector<fc::variant> updates1, updates2;
+      // the updates the callbacks get a reference to are part of the batch of a notification
+      vector<const fc::variant*> batches1, batches2;
+      db_api1.set_subscribe_callback( [&]( const fc::variant& v ) { updates1.push_back(v); batches1.push_back(&v); }, false );
+      db_api2.set_subscribe_callback( [&]( const fc::variant& v ) { updates2.push_back(v); batches2.push_back(&v); }, false );
+      // a remote subscriber gets the json of the batch as it was written once
+      auto recorder = std::make_shared<notice_recorder>();
+      graphene::app::database_api db_api3(db);
+      db_api3.set_subscribe_callback( fc::detail::callback_functor<void(const fc::variant&)>( recorder, 1 ), false );
+
+      transfer(committee_account, alice_id, asset(1000));
+      generate_block();
+      // let the queued callbacks run
+      fc::usleep( fc::milliseconds(100) );
+
+      BOOST_REQUIRE( !updates1.empty() );
+      BOOST_CHECK_EQUAL( fc::json::to_string(updates1), fc::json::to_string(updates2) );
+      // both sessions hold the batches of the notifications at the same time, so these are built once for both
+      BOOST_CHECK( batches1 == batches2 );
+      BOOST_REQUIRE_EQUAL( recorder->notices.size(), updates1.size() );
+      for( size_t i = 0; i < updates1.size(); ++i )
+         BOOST_CHECK_EQUAL( recorder->notices[i], fc::json::to_string( fc::variants{ updates1[i] } ) );
+
+      bool alice_balance_reported = false;
+      for( const auto& update : updates1 )
+         for( const auto& item : update.get_array() )
+            if( item.is_object() && item.get_object().contains("owner") && item["owner"].as<account_id_type>(1) == alice_id
+                && item["id"].as<object_id_type>(1).is<account_balance_id_type>() )
+               alice_balance_reported = true;
+      BOOST_CHECK( alice_balance_reported );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/application.hpp>
+#include <graphene/app/database_api.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/hardfork.hpp>
@@ -714,8 +715,8 @@ BOOST_AUTO_TEST_CASE( referrals_test )
        * 90000(old balance) + 40(fund_payment) + 5100(referral payment)
        *
        * 5100:
-       * 500 * 3 (level 1 users: test10, test11, test12; leaf_info2::level1_payment field)
-       * 400 * 9 (level 0 users: test31, test32, test33, test34, test35, test36, test37, test38, test39; leaf_info2::level2_payment field)
+       * 500 * 3 (level 1 users: test10, test11, test12; level 1 payment)
+       * 400 * 9 (level 0 users: test31, test32, test33, test34, test35, test36, test37, test38, test39; level 2 payment)
        */
       BOOST_CHECK(get_balance(test3_id, EDC_ASSET) == 95140);
 
@@ -955,4 +956,262 @@ BOOST_AUTO_TEST_CASE( referrals_hf639_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( referral_forest_test )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "=== referral_forest_test ===" );
+
+      ACTORS((alice)(bob)(test1)(test2)(test3)(test4)(test5)(test6)(test7)(test8))
+
+      CHANGE_REFERRER_MULTIPLE(("test1")("test2"), "alice")
+      CHANGE_REFERRER_MULTIPLE(("test3")("test4"), "test1")
+      CHANGE_REFERRER_MULTIPLE(("test5"), "test3")
+      CHANGE_REFERRER_MULTIPLE(("test6"), "test8") // referrer with a bigger id
+      CHANGE_REFERRER_MULTIPLE(("test8"), "test2")
+      CHANGE_REFERRER_MULTIPLE(("alice"), "bob")
+
+      int64_t amount = 1000;
+      for (const account_object* acc: {&alice, &bob, &test1, &test2, &test3, &test4, &test5, &test6, &test7, &test8})
+      {
+         db.modify(*acc, [&](account_object& a) {
+            a.edc_in_deposits = amount;
+            a.edc_active_deposits_count = amount / 1000;
+         });
+         amount += 1000;
+      }
+
+      const auto& aidx = dynamic_cast<const primary_index<account_index>&>(db.get_index_type<account_index>());
+      const auto& forest = aidx.get_secondary_index<referral_forest_index>();
+
+      // compares the forest with the tree form_referral_map() builds from scratch
+      auto check_forest = [&]()
+      {
+         const auto& idx = db.get_index_type<account_index>().indices().get<by_id>();
+
+         std::map<account_id_type, optional<account_id_type>> parents;
+         std::map<optional<account_id_type>, std::vector<account_id_type>> children;
+         std::function<void(const account_object&)> create_leaf = [&](const account_object& acc)
+         {
+            optional<account_id_type> referrer;
+            if (parents.count(acc.referrer)) {
+               referrer = acc.referrer;
+            }
+            else
+            {
+               auto itr = idx.find(acc.referrer);
+               if ((itr != idx.end()) && (acc.referrer != itr->referrer))
+               {
+                  create_leaf(*itr);
+                  referrer = acc.referrer;
+               }
+            }
+            parents[acc.get_id()] = referrer;
+            children[referrer].push_back(acc.get_id());
+         };
+         for (auto itr = ++idx.begin(); itr != idx.end(); ++itr)
+         {
+            if (!itr->is_market_account && !parents.count(itr->get_id())) {
+               create_leaf(*itr);
+            }
+         }
+
+         std::vector<account_id_type> expected_order;
+         std::function<void(const optional<account_id_type>&)> walk = [&](const optional<account_id_type>& id)
+         {
+            for (const account_id_type& child: children[id])
+            {
+               expected_order.push_back(child);
+               walk(child);
+            }
+         };
+         walk(optional<account_id_type>());
+
+         // sums accumulated the way process_referrals() did before HARDFORK_638
+         std::map<account_id_type, int64_t> expected_sums;
+         std::map<account_id_type, uint32_t> expected_counts;
+         for (const auto& item: parents)
+         {
+            account_id_type current = item.first;
+            for (int level = 0; level < 3; ++level)
+            {
+               const optional<account_id_type>& parent = parents[current];
+               if (!parent.valid() || (*parent == GRAPHENE_COMMITTEE_ACCOUNT)) { break; }
+               expected_sums[*parent] += current(db).edc_in_deposits.value;
+               expected_counts[*parent] += current(db).edc_active_deposits_count;
+               current = *parent;
+            }
+         }
+
+         std::vector<account_id_type> order;
+         forest.for_each_preorder([&](const referral_forest_index::node& n, const referral_forest_index::node* parent)
+         {
+            const account_id_type id = n.account->get_id();
+            order.push_back(id);
+            BOOST_CHECK(parents[id] == (parent ? parent->account->get_id() : optional<account_id_type>()));
+            BOOST_CHECK_EQUAL(n.active_deposits_sum.value, expected_sums[id]);
+            BOOST_CHECK_EQUAL(n.active_deposits_count_sum, expected_counts[id]);
+         });
+         BOOST_CHECK(order == expected_order);
+      };
+
+      check_forest();
+
+      BOOST_CHECK(*forest.find(test6_id)->parent == test8_id);
+      BOOST_CHECK(forest.find(test1_id)->active_deposits_sum == 5000 * 2 + 6000);
+
+      {
+         auto session = db._undo_db.start_undo_session();
+         CHANGE_REFERRER_MULTIPLE(("test3"), "test7")
+         db.modify(test5, [&](account_object& a) {
+            a.edc_in_deposits = 0;
+            a.edc_active_deposits_count = 0;
+         });
+         BOOST_CHECK(*forest.find(test3_id)->parent == test7_id);
+         check_forest();
+      }
+
+      // undone together with the session
+      BOOST_CHECK(*forest.find(test3_id)->parent == test1_id);
+      check_forest();
+   }
+   catch(fc::exception& e)
+   {
+      edump((e.to_detail_string()))
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( flat_referral_forest_test )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "=== flat_referral_forest_test ===" );
+
+      ACTORS((alice)(bob)(test1)(test2)(test3))
+
+      flat_referral_forest forest;
+      forest.reset(db.get_index_type<account_index>().get_next_id().instance());
+
+      // added out of pre-order: test1 and test3 under alice, bob at the top, test2 under test1, and alice twice
+      const uint32_t a = forest.add(0, alice);
+      const uint32_t b = forest.add(0, bob);
+      const uint32_t t1 = forest.add(a, test1);
+      forest.add(t1, test2);
+      forest.add(a, test3);
+      forest.add(b, alice);
+      forest.finish();
+
+      BOOST_REQUIRE_EQUAL(forest.size(), 7u);
+      const std::vector<account_id_type> preorder = {
+         account_id_type(), alice_id, test1_id, test2_id, test3_id, bob_id, alice_id };
+      BOOST_CHECK(forest.account == preorder);
+      const std::vector<uint32_t> parents = { flat_referral_forest::npos, 0, 1, 2, 1, 0, 5 };
+      BOOST_CHECK(forest.parent == parents);
+
+      // the first node of an account is found, the root is not an account node
+      BOOST_CHECK_EQUAL(forest.find(alice_id), 1u);
+      BOOST_CHECK_EQUAL(forest.find(test3_id), 4u);
+      BOOST_CHECK_EQUAL(forest.find(account_id_type()), flat_referral_forest::npos);
+      BOOST_CHECK(!forest.is_referrer(0));
+      BOOST_CHECK(forest.is_referrer(1));
+
+      // children of alice, then of bob
+      BOOST_CHECK_EQUAL(forest.children_offset[2] - forest.children_offset[1], 2u);
+      BOOST_CHECK_EQUAL(forest.children[forest.children_offset[1]], 2u);
+      BOOST_CHECK_EQUAL(forest.children[forest.children_offset[1] + 1], 4u);
+      BOOST_CHECK_EQUAL(forest.children[forest.children_offset[5]], 6u);
+
+      forest.clear();
+      BOOST_CHECK_EQUAL(forest.size(), 0u);
+      BOOST_CHECK_EQUAL(forest.find(alice_id), flat_referral_forest::npos);
+   }
+   catch(fc::exception& e)
+   {
+      edump((e.to_detail_string()))
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( get_referrals_test )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "=== get_referrals_test ===" );
+
+      ACTORS((alice)(bob)(test1)(test2)(test3)(test4)(test5)(test6))
+      create_edc(10000000000, asset(100, CORE_ASSET), asset(1, EDC_ASSET));
+
+      CHANGE_REFERRER_MULTIPLE(("test1")("test2"), "alice")
+      CHANGE_REFERRER_MULTIPLE(("test3")("test4"), "test1")
+      CHANGE_REFERRER_MULTIPLE(("test5"), "test3")
+      CHANGE_REFERRER_MULTIPLE(("test6"), "test2")
+      CHANGE_REFERRER_MULTIPLE(("bob"), "test4") // created before its referrer, left out of the tree
+
+      int64_t amount = 100000;
+      for (account_id_type id: {alice_id, bob_id, test1_id, test2_id, test3_id, test4_id, test5_id, test6_id})
+      {
+         issue_uia(id, asset(amount, EDC_ASSET));
+         amount += 100000;
+      }
+
+      graphene::app::database_api db_api(db);
+
+      // compares get_referrals2() with the tree it used to build for each call
+      auto check_referrals2 = [&]()
+      {
+         referral_tree rtree(db.get_index_type<account_index>(), db.get_index_type<account_balance_index>(), EDC_ASSET, alice_id);
+         rtree.form_old();
+         const leaf_info& root = *rtree.referral_map.at(alice_id);
+
+         const ref_info result = db_api.get_referrals2("alice");
+         BOOST_CHECK(result.id == alice_id);
+         BOOST_CHECK_EQUAL(result.balance, uint64_t(root.balance));
+         BOOST_CHECK_EQUAL(result.level_1_partners, root.level_1_partners);
+         BOOST_CHECK_EQUAL(result.level_1_sum, root.level_1_sum);
+         BOOST_CHECK_EQUAL(result.level_2_partners, root.level_2_partners);
+         BOOST_CHECK_EQUAL(result.all_partners, root.all_partners);
+         BOOST_CHECK_EQUAL(result.all_sum, root.all_sum);
+         BOOST_CHECK_EQUAL(result.rank, root.rank);
+
+         std::vector<account_id_type> level_1;
+         for (const child_balance& cb: root.child_balances)
+            if (cb.level == 1) { level_1.push_back(cb.account_id); }
+         BOOST_REQUIRE_EQUAL(result.level_1.size(), level_1.size());
+         for (size_t i = 0; i < level_1.size(); ++i)
+         {
+            const leaf_info& leaf = *rtree.referral_map.at(level_1[i]);
+            BOOST_CHECK(result.level_1[i].id == level_1[i]);
+            BOOST_CHECK_EQUAL(result.level_1[i].all_partners, leaf.all_partners);
+            BOOST_CHECK_EQUAL(result.level_1[i].all_sum, leaf.all_sum);
+            BOOST_CHECK_EQUAL(result.level_1[i].level_1_sum, leaf.level_1_sum);
+         }
+         return result;
+      };
+
+      ref_info result = check_referrals2();
+      BOOST_CHECK_EQUAL(result.all_sum, 300000u + 400000u + 500000u + 600000u + 700000u + 800000u);
+
+      Unit unit = db_api.get_referrals("alice");
+      BOOST_REQUIRE_EQUAL(unit.referrals.size(), 2u);
+      BOOST_CHECK(unit.referrals[0].id == test1_id);
+      BOOST_CHECK(unit.referrals[1].id == test2_id);
+
+      // the cached trees are dropped when accounts or balances change
+      CHANGE_REFERRER_MULTIPLE(("test5"), "alice")
+      result = check_referrals2();
+      BOOST_CHECK_EQUAL(result.level_1.size(), 3u);
+      BOOST_CHECK_EQUAL(db_api.get_referrals("alice").referrals.size(), 3u);
+
+      generate_block();
+      issue_uia(test6_id, asset(1000, EDC_ASSET));
+      check_referrals2();
+   }
+   catch(fc::exception& e)
+   {
+      edump((e.to_detail_string()))
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
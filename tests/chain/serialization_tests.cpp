@@ -2,10 +2,15 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/full_account.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/market_object.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message_cache.hpp>
 
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/elliptic.hpp>
+#include <fc/io/json_writer.hpp>
 #include <fc/reflect/variant.hpp>
 
 #include "../common/database_fixture.hpp"
@@ -72,6 +77,112 @@ BOOST_AUTO_TEST_CASE( json_tests )
    }
 }
 
+BOOST_AUTO_TEST_CASE( json_writer_test )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "=== json_writer_test ===" );
+
+      // the writer makes what json::to_string() makes of the variant of a value
+      auto check = [&]( const auto& v ) {
+         for( auto format : { fc::json::stringify_large_ints_and_doubles, fc::json::legacy_generator } )
+         {
+            const std::string expected = fc::json::to_string( fc::variant( v, GRAPHENE_MAX_NESTED_OBJECTS ), format,
+                                                              GRAPHENE_MAX_NESTED_OBJECTS );
+            BOOST_CHECK_EQUAL( fc::json_writer::to_string( v, format, GRAPHENE_MAX_NESTED_OBJECTS ), expected );
+         }
+      };
+
+      std::map< std::string, fc::optional<int64_t> > values;
+      values["quote\"back\\slash\ttab\x01\x1f\x7f"] = INT64_MAX;
+      values["small"] = -5;
+      values["limit"] = int64_t(INT32_MAX) + 1;
+      values["none"];
+      check( values );
+      check( std::make_pair( uint64_t(0xffffffff), uint64_t(0x100000000) ) );
+      check( std::vector<char>{ 'a', 'b' } );
+      check( fc::variants{ fc::variant(), fc::variant( true ), fc::variant( 1.5 ), fc::mutable_variant_object( "a", 1 ) } );
+      check( fc::optional<asset>() );
+
+      ACTORS( (alice) );
+      transfer( committee_account, alice_id, asset( 100000 ) );
+      const signed_block block = generate_block();
+      BOOST_REQUIRE( !block.transactions.empty() );
+      check( block );
+      check( fc::optional<signed_block>( block ) );
+
+      graphene::app::full_account full;
+      full.account = alice_id( db );
+      full.statistics = alice_id( db ).statistics( db );
+      full.registrar_name = "alice\n";
+      const auto& balances = db.get_index_type<account_balance_index>().indices().get<by_account_asset>();
+      full.balances.push_back( *balances.find( boost::make_tuple( alice_id, asset_id_type() ) ) );
+      check( std::map< std::string, graphene::app::full_account >{ { "alice", full } } );
+      check( db.get( asset_id_type() ) );
+   } catch ( const fc::exception& e )
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( json_buffer_parser_test )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "=== json_buffer_parser_test ===" );
+
+      // the buffer parser reads what the legacy parser reads, and fails where it fails
+      auto check = [&]( const std::string& json, uint32_t max_depth ) {
+         fc::optional<std::string> expected;
+         try {
+            expected = fc::json::to_string( fc::json::from_string( json, fc::json::legacy_parser, max_depth ),
+                                            fc::json::legacy_generator, GRAPHENE_MAX_NESTED_OBJECTS );
+         } catch( const fc::exception& ) {}
+
+         if( expected.valid() )
+            BOOST_CHECK_EQUAL( fc::json::to_string( fc::json::from_string( json, fc::json::buffer_parser, max_depth ),
+                                                    fc::json::legacy_generator, GRAPHENE_MAX_NESTED_OBJECTS ),
+                               *expected );
+         else
+            BOOST_CHECK_THROW( fc::json::from_string( json, fc::json::buffer_parser, max_depth ), fc::exception );
+      };
+
+      const std::vector<std::string> inputs = {
+         "{\"id\":1,\"method\":\"call\",\"params\":[0,\"get_accounts\",[[\"1.2.0\",\"1.2.17\"]]]}",
+         " \t\r\n {  \"a\" :\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n [ 1 , 2 ,, 3 4 ] , , \"b\":{}}   ",
+         "\"a string longer than sixteen bytes, with \\\"escapes\\\", \\\\, \\t \\n \\r \\u0041 \\/ at \\x places\"",
+         "\"\x01\x1f\x7f\xc3\xa4 raw bytes\"",
+         "\"no closing quote, some way past the first sixteen bytes",
+         "\"an end of transmission \x04 within\"",
+         "\"escape at the end\\",
+         "[-1,0,18446744073709551615,-9223372036854775808,1.5,-.5,2.,1e5,12abc,-,-.,.,1..2]",
+         "[-1]", "[.]", "[1..2]", "[18446744073709551616]", "[0x10]", "-", "12", "1.25",
+         "[null,true,false,nul,tru,falsey,nullZ, \"x\"]", "nul", "null", "truex",
+         "{\"a\":1", "{\"a\" 1}", "{\"a\":1 x}", "{a:1}", "[1,2", "[", "{", "", "   ", "\x04", "\xff", "]", "@",
+         std::string( "[1,\0]", 5 ), std::string( "\0", 1 ),
+         std::string( 100, '[' ) + std::string( 100, ']' ),
+         std::string( 250, '[' ) + std::string( 250, ']' ),
+         std::string( 150, ' ' ) + "{\"" + std::string( 150, 'k' ) + "\":\"" + std::string( 150, 'v' ) + "\"}"
+      };
+      for( const auto& json : inputs )
+         for( uint32_t max_depth : { 1u, 2u, 3u, 200u } )
+            check( json, max_depth );
+
+      ACTORS( (alice) );
+      transfer( committee_account, alice_id, asset( 100000 ) );
+      const signed_block block = generate_block();
+      const std::string json = fc::json::to_pretty_string( fc::variant( block, GRAPHENE_MAX_NESTED_OBJECTS ) );
+      check( json, GRAPHENE_MAX_NESTED_OBJECTS );
+      for( size_t size = 0; size < json.size(); size += 7 )
+         check( json.substr( 0, size ), GRAPHENE_MAX_NESTED_OBJECTS );
+   } catch ( const fc::exception& e )
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( extension_serialization_test )
 {
    try
@@ -100,4 +211,117 @@ BOOST_AUTO_TEST_CASE( extension_serialization_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( message_buffer_test )
+{
+   try
+   {
+      generate_block();
+      graphene::net::block_message block_msg( *db.fetch_block_by_number( db.head_block_num() ) );
+      graphene::net::message msg( block_msg );
+
+      // the buffer holds the message as sent, padded to 16 bytes
+      BOOST_CHECK_EQUAL( msg.data.size(), msg.size.value() );
+      BOOST_CHECK_EQUAL( msg.data.wire_size() % 16, 0u );
+      BOOST_CHECK( msg.data.has_header( msg ) );
+      BOOST_CHECK( fc::raw::pack( block_msg ) == std::vector<char>( msg.data.data(), msg.data.data() + msg.data.size() ) );
+      BOOST_CHECK( msg.as<graphene::net::block_message>().block_id == block_msg.block_id );
+
+      // copies share the data until one of them is written to
+      graphene::net::message copy( msg );
+      BOOST_CHECK( copy.data.data() == msg.data.data() );
+      const auto id = msg.id();
+      copy.data.mutable_data()[0] ^= 1;
+      BOOST_CHECK( copy.data.data() != msg.data.data() );
+      BOOST_CHECK( msg.id() == id );
+      BOOST_CHECK( copy.id() != id );
+   }
+   catch ( const fc::exception& e )
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( message_cache_test )
+{
+   try
+   {
+      using graphene::net::blockchain_tied_message_cache;
+      const uint32_t duration = GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS;
+
+      std::vector<graphene::net::message> messages;
+      std::vector<block_id_type> block_ids;
+      for( uint32_t i = 0; i < 3; ++i )
+      {
+         generate_block();
+         graphene::net::block_message block_msg( *db.fetch_block_by_number( db.head_block_num() ) );
+         messages.emplace_back( block_msg );
+         block_ids.push_back( block_msg.block_id );
+      }
+      auto propagation = []( uint32_t seconds ) {
+         return graphene::net::message_propagation_data{ fc::time_point( fc::seconds( seconds ) ),
+                                                         fc::time_point( fc::seconds( seconds ) ),
+                                                         graphene::net::node_id_t() };
+      };
+
+      // messages are found by their id, their propagation data by the id of the block they carry
+      blockchain_tied_message_cache cache;
+      for( uint32_t i = 0; i < 3; ++i )
+         cache.cache_message( messages[i], messages[i].id(), propagation( i + 1 ), block_ids[i] );
+      BOOST_CHECK_EQUAL( cache.size(), 3u );
+      BOOST_CHECK( cache.get_message( messages[1].id() ).id() == messages[1].id() );
+      BOOST_CHECK( cache.get_message_propagation_data( block_ids[1] ).received_time == fc::time_point( fc::seconds( 2 ) ) );
+      BOOST_CHECK_THROW( cache.get_message( block_ids[1] ), fc::key_not_found_exception );
+      BOOST_CHECK_THROW( cache.get_message_propagation_data( messages[1].id() ), fc::key_not_found_exception );
+      BOOST_CHECK_THROW( cache.get_message_propagation_data( graphene::net::message_hash_type() ),
+                         fc::key_not_found_exception );
+
+      // a message cached again is not counted twice
+      const size_t bytes = cache.size_in_bytes();
+      cache.cache_message( messages[2], messages[2].id(), propagation( 4 ), block_ids[2] );
+      BOOST_CHECK_EQUAL( cache.size(), 3u );
+      BOOST_CHECK_EQUAL( cache.size_in_bytes(), bytes );
+      BOOST_CHECK( cache.get_message_propagation_data( block_ids[2] ).received_time == fc::time_point( fc::seconds( 3 ) ) );
+
+      // the oldest messages are evicted for the byte limit, down to the newest one
+      cache.set_max_size_in_bytes( bytes - 1 );
+      BOOST_CHECK_EQUAL( cache.size(), 2u );
+      BOOST_CHECK_THROW( cache.get_message( messages[0].id() ), fc::key_not_found_exception );
+      BOOST_CHECK_THROW( cache.get_message_propagation_data( block_ids[0] ), fc::key_not_found_exception );
+      cache.set_max_size_in_bytes( 0 );
+      BOOST_CHECK_EQUAL( cache.size(), 1u );
+      BOOST_CHECK( cache.get_message( messages[2].id() ).id() == messages[2].id() );
+      cache.cache_message( messages[0], messages[0].id(), propagation( 1 ), block_ids[0] );
+      BOOST_CHECK_EQUAL( cache.size(), 1u );
+      BOOST_CHECK( cache.get_message( messages[0].id() ).id() == messages[0].id() );
+      BOOST_CHECK_THROW( cache.get_message( messages[2].id() ), fc::key_not_found_exception );
+      BOOST_CHECK_EQUAL( cache.get_statistics()["evicted"].as_uint64(), 3u );
+
+      // messages expire after a number of blocks, counted from the block they were cached in
+      blockchain_tied_message_cache expiring;
+      expiring.cache_message( messages[0], messages[0].id(), propagation( 1 ), block_ids[0] );
+      expiring.block_accepted();
+      expiring.block_accepted();
+      expiring.cache_message( messages[1], messages[1].id(), propagation( 2 ), block_ids[1] );
+      for( uint32_t i = 2; i < duration; ++i )
+         expiring.block_accepted();
+      BOOST_CHECK_EQUAL( expiring.size(), 2u );
+      expiring.block_accepted();
+      BOOST_CHECK_EQUAL( expiring.size(), 1u );
+      BOOST_CHECK_THROW( expiring.get_message( messages[0].id() ), fc::key_not_found_exception );
+      BOOST_CHECK( expiring.get_message( messages[1].id() ).id() == messages[1].id() );
+      expiring.block_accepted();
+      BOOST_CHECK_EQUAL( expiring.size(), 1u );
+      expiring.block_accepted();
+      BOOST_CHECK_EQUAL( expiring.size(), 0u );
+      BOOST_CHECK_EQUAL( expiring.size_in_bytes(), 0u );
+      BOOST_CHECK_EQUAL( expiring.get_statistics()["expired"].as_uint64(), 2u );
+   }
+   catch ( const fc::exception& e )
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
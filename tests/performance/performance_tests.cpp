@@ -11,6 +11,7 @@
 #include <graphene/db/simple_index.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/io/json.hpp>
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
@@ -30,6 +31,32 @@ BOOST_AUTO_TEST_CASE( sigcheck_benchmark )
    auto elapsed = end-start;
    wdump( ((100000.0*1000000.0) / elapsed.count()) );
 }
+
+BOOST_AUTO_TEST_CASE( json_parse_benchmark )
+{
+   BOOST_TEST_MESSAGE( "=== json_parse_benchmark ===" );
+   fc::variants accounts;
+   for( uint32_t i = 0; i < 100; ++i )
+      accounts.push_back( fc::mutable_variant_object( "id", "1.2." + fc::to_string( i ) )
+                                                    ( "name", "account-" + fc::to_string( i ) )
+                                                    ( "balance", uint64_t(i) * 1000000007 )
+                                                    ( "memo", "a \"quoted\" memo\n" )
+                                                    ( "flags", fc::variants{ true, false, fc::variant() } ) );
+   const std::string request = fc::json::to_string( fc::mutable_variant_object( "id", 1 )( "method", "call" )
+                                                       ( "params", fc::variants{ 0, "broadcast", accounts } ) );
+   for( const auto& parser : { std::make_pair( "legacy_parser", fc::json::legacy_parser ),
+                               std::make_pair( "buffer_parser", fc::json::buffer_parser ) } )
+   {
+      const std::string name = parser.first;
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < 10000; ++i )
+         auto var = fc::json::from_string( request, parser.second );
+      auto end = fc::time_point::now();
+      auto elapsed = end-start;
+      // bytes per microsecond, i.e. MB/s
+      wdump( (name)(request.size())( ((request.size()*10000.0) / elapsed.count()) ) );
+   }
+}
 /*
 BOOST_AUTO_TEST_CASE( transfer_benchmark )
 {